@@ -371,6 +371,8 @@ extern const char *__progname;
 #define	ELFTC_BYTE_ORDER_BIG_ENDIAN		_BIG_ENDIAN
 
 #define	ELFTC_HAVE_MMAP				1
+#define	ELFTC_HAVE_POSIX_FALLOCATE		0
+#define	ELFTC_HAVE_PTHREADS			1
 
 #endif
 
@@ -383,6 +385,8 @@ extern const char *__progname;
 #define	ELFTC_BYTE_ORDER_BIG_ENDIAN		__BIG_ENDIAN
 
 #define	ELFTC_HAVE_MMAP				1
+#define	ELFTC_HAVE_POSIX_FALLOCATE		1
+#define	ELFTC_HAVE_PTHREADS			1
 
 /*
  * Debian GNU/Linux and Debian GNU/kFreeBSD do not have strmode(3).
@@ -407,6 +411,12 @@ extern const char *__progname;
 #define	ELFTC_BYTE_ORDER_BIG_ENDIAN		_BIG_ENDIAN
 
 #define	ELFTC_HAVE_MMAP				1
+#if __FreeBSD_version >= 900000
+#define	ELFTC_HAVE_POSIX_FALLOCATE		1
+#else
+#define	ELFTC_HAVE_POSIX_FALLOCATE		0
+#endif
+#define	ELFTC_HAVE_PTHREADS			1
 #define	ELFTC_HAVE_STRMODE			1
 #if __FreeBSD_version <= 900000
 #define	ELFTC_BROKEN_YY_NO_INPUT		1
@@ -416,6 +426,8 @@ extern const char *__progname;
 
 #if defined(__minix)
 #define	ELFTC_HAVE_MMAP				0
+#define	ELFTC_HAVE_POSIX_FALLOCATE		0
+#define	ELFTC_HAVE_PTHREADS			0
 #endif	/* __minix */
 
 
@@ -429,6 +441,8 @@ extern const char *__progname;
 #define	ELFTC_BYTE_ORDER_BIG_ENDIAN		_BIG_ENDIAN
 
 #define	ELFTC_HAVE_MMAP				1
+#define	ELFTC_HAVE_POSIX_FALLOCATE		1
+#define	ELFTC_HAVE_PTHREADS			1
 #define	ELFTC_HAVE_STRMODE			1
 #if __NetBSD_Version__ <= 599002100
 /* from src/doc/CHANGES: flex(1): Import flex-2.5.35 [christos 20091025] */
@@ -448,6 +462,8 @@ extern const char *__progname;
 #define	ELFTC_BYTE_ORDER_BIG_ENDIAN		_BIG_ENDIAN
 
 #define	ELFTC_HAVE_MMAP				1
+#define	ELFTC_HAVE_POSIX_FALLOCATE		0
+#define	ELFTC_HAVE_PTHREADS			1
 #define	ELFTC_HAVE_STRMODE			1
 
 #define	ELFTC_NEED_BYTEORDER_EXTENSIONS		1
@@ -455,4 +471,17 @@ extern const char *__progname;
 
 #endif	/* __OpenBSD__ */
 
+
+/*
+ * Thread-local storage qualifier.  Platforms lacking thread support
+ * get ordinary (process-wide) storage.
+ */
+#ifndef	ELFTC_THREAD_LOCAL
+#if	ELFTC_HAVE_PTHREADS && defined(__GNUC__)
+#define	ELFTC_THREAD_LOCAL	__thread
+#else
+#define	ELFTC_THREAD_LOCAL	/**/
+#endif
+#endif	/* ELFTC_THREAD_LOCAL */
+
 #endif	/* _ELFTC_H */
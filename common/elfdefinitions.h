@@ -144,6 +144,12 @@ _ELF_DEFINE_DT(DT_PREINIT_ARRAYSZ,  33,					\
 	"size of pre-initialization array")				\
 _ELF_DEFINE_DT(DT_MAXPOSTAGS,	    34,					\
 	"the number of positive tags")					\
+_ELF_DEFINE_DT(DT_RELRSZ,           35,					\
+	"size of the DT_RELR table")					\
+_ELF_DEFINE_DT(DT_RELR,             36,					\
+	"address of the relative relocation bitmap table")		\
+_ELF_DEFINE_DT(DT_RELRENT,          37,					\
+	"size of a DT_RELR entry")					\
 _ELF_DEFINE_DT(DT_LOOS,             0x6000000DUL,			\
 	"start of OS-specific types")					\
 _ELF_DEFINE_DT(DT_SUNW_AUXILIARY,   0x6000000DUL,			\
@@ -1074,6 +1080,8 @@ _ELF_DEFINE_SHT(SHT_PREINIT_ARRAY,   16,				\
 _ELF_DEFINE_SHT(SHT_GROUP,           17, "defines a section group")	\
 _ELF_DEFINE_SHT(SHT_SYMTAB_SHNDX,    18,				\
 	"used for extended section numbering")				\
+_ELF_DEFINE_SHT(SHT_RELR,            19,				\
+	"relative relocation bitmaps")					\
 _ELF_DEFINE_SHT(SHT_LOOS,            0x60000000UL,			\
 	"start of OS-specific range")					\
 _ELF_DEFINE_SHT(SHT_SUNW_dof,	     0x6FFFFFF4UL,			\
@@ -1241,6 +1249,7 @@ _ELF_DEFINE_STT(STT_FILE,            4, "source file")			\
 _ELF_DEFINE_STT(STT_COMMON,          5, "uninitialized common block")	\
 _ELF_DEFINE_STT(STT_TLS,             6, "thread local storage")		\
 _ELF_DEFINE_STT(STT_LOOS,            10, "start of OS-specific types")	\
+_ELF_DEFINE_STT(STT_GNU_IFUNC,       10, "indirect function (GNU)")	\
 _ELF_DEFINE_STT(STT_HIOS,            12, "end of OS-specific types")	\
 _ELF_DEFINE_STT(STT_LOPROC,          13,				\
 	"start of processor-specific types")				\
@@ -1949,7 +1958,9 @@ _ELF_DEFINE_RELOC(R_X86_64_SIZE32,	32)	\
 _ELF_DEFINE_RELOC(R_X86_64_SIZE64,	33)	\
 _ELF_DEFINE_RELOC(R_X86_64_GOTPC32_TLSDESC, 34)	\
 _ELF_DEFINE_RELOC(R_X86_64_TLSDESC_CALL, 35)	\
-_ELF_DEFINE_RELOC(R_X86_64_TLSDESC,	36)
+_ELF_DEFINE_RELOC(R_X86_64_TLSDESC,	36)	\
+_ELF_DEFINE_RELOC(R_X86_64_GOTPCRELX,	41)	\
+_ELF_DEFINE_RELOC(R_X86_64_REX_GOTPCRELX, 42)
 
 #define	_ELF_DEFINE_RELOCATIONS()		\
 _ELF_DEFINE_386_RELOCATIONS()			\
@@ -2513,6 +2524,15 @@ typedef struct {
 	Elf64_Sxword	r_addend;    /* constant addend */
 } Elf64_Rela;
 
+/*
+ * Relative relocation entries. An even entry is the address of a
+ * place to relocate. An odd entry is a bitmap of the places that
+ * follow the last one relocated, one bit per word.
+ */
+
+typedef Elf32_Word	Elf32_Relr;
+typedef Elf64_Xword	Elf64_Relr;
+
 
 #define ELF32_R_SYM(I)		((I) >> 8)
 #define ELF32_R_TYPE(I)		((unsigned char) (I))
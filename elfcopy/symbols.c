@@ -72,6 +72,8 @@ static int	match_wildcard(const char *name, const char *pattern);
 #define BIT_CLR(v, n) (v[(n)>>3] &= ~(1U << ((n) & 7)))
 #define BIT_ISSET(v, n) (v[(n)>>3] & (1U << ((n) & 7)))
 
+#define	SYM_BATCH	256	/* symbols read from libelf at a time */
+
 static int
 is_debug_symbol(unsigned char st_info)
 {
@@ -297,11 +299,11 @@ generate_symbols(struct elfcopy *ecp)
 	char		*newname;
 	unsigned char	*gsym;
 	GElf_Shdr	 ish;
-	GElf_Sym	 sym;
+	GElf_Sym	 sym, syms[SYM_BATCH];
 	Elf_Data*	 id;
 	Elf_Scn		*is;
 	size_t		 ishstrndx, namelen, ndx, nsyms, sc, symndx;
-	int		 ec, elferr, i;
+	int		 ec, elferr, i, j, n;
 
 	if (elf_getshstrndx(ecp->ein, &ishstrndx) == 0)
 		errx(EXIT_FAILURE, "elf_getshstrndx failed: %s",
@@ -409,10 +411,14 @@ generate_symbols(struct elfcopy *ecp)
 		return (0);
 
 	/* Copy/Filter each symbol. */
-	for (i = 0; (size_t)i < sc; i++) {
-		if (gelf_getsym(id, i, &sym) != &sym)
-			errx(EXIT_FAILURE, "gelf_getsym failed: %s",
-			    elf_errmsg(-1));
+	for (i = j = n = 0; (size_t)i < sc; i++, j++) {
+		if (j == n) {
+			if ((n = gelf_getsyms(id, i, SYM_BATCH, syms)) <= 0)
+				errx(EXIT_FAILURE, "gelf_getsyms failed: %s",
+				    elf_errmsg(-1));
+			j = 0;
+		}
+		sym = syms[j];
 		if ((name = elf_strptr(ecp->ein, symndx, sym.st_name)) == NULL)
 			errx(EXIT_FAILURE, "elf_strptr failed: %s",
 			    elf_errmsg(-1));
@@ -86,6 +86,9 @@ typedef Elf64_Nhdr	Elf_Note;
 /* Convenient print macro. */
 #define	PRT(...)	fprintf(ed->out, __VA_ARGS__)
 
+/* Number of symbols or relocations retrieved from libelf at a time. */
+#define	BATCH_SIZE	256
+
 /* Internal data structure for sections. */
 struct section {
 	const char	*name;		/* section name */
@@ -190,6 +193,9 @@ d_tags(uint64_t tag)
 	case 30: return "DT_FLAGS";
 	case 32: return "DT_PREINIT_ARRAY"; /* XXX: DT_ENCODING */
 	case 33: return "DT_PREINIT_ARRAYSZ";
+	case 35: return "DT_RELRSZ";
+	case 36: return "DT_RELR";
+	case 37: return "DT_RELRENT";
 	/* 0x6000000D - 0x6ffff000 operating system-specific semantics */
 	case 0x6ffffdf5: return "DT_GNU_PRELINKED";
 	case 0x6ffffdf6: return "DT_GNU_CONFLICTSZ";
@@ -328,6 +334,7 @@ sh_types(u_int64_t sht) {
 	case 16: return "SHT_PREINIT_ARRAY";
 	case 17: return "SHT_GROUP";
 	case 18: return "SHT_SYMTAB_SHNDX";
+	case 19: return "SHT_RELR";
 	/* 0x60000000 - 0x6fffffff operating system-specific semantics */
 	case 0x6ffffff0: return "XXX:VERSYM";
 	case 0x6ffffff6: return "SHT_GNU_HASH";
@@ -805,6 +812,8 @@ static void	elf_print_rela(struct elfdump *ed, struct section *s,
     Elf_Data *data);
 static void	elf_print_rel(struct elfdump *ed, struct section *s,
     Elf_Data *data);
+static void	elf_print_relr(struct elfdump *ed, struct section *s,
+    Elf_Data *data);
 static void	elf_print_reloc(struct elfdump *ed);
 static void	elf_print_got(struct elfdump *ed);
 static void	elf_print_got_section(struct elfdump *ed, struct section *s);
@@ -1672,8 +1681,8 @@ elf_print_symtab(struct elfdump *ed, int i)
 	uint16_t	*vs;
 	char		 idx[10];
 	Elf_Data	*data;
-	GElf_Sym	 sym;
-	int		 len, j, elferr, nvs;
+	GElf_Sym	 sym, syms[BATCH_SIZE];
+	int		 len, j, k, n, elferr, nvs;
 
 	s = &ed->sl[i];
 	if (ed->flags & SOLARIS_FMT)
@@ -1702,11 +1711,17 @@ elf_print_symtab(struct elfdump *ed, int i)
 			vs = NULL;
 		}
 	}
-	for (j = 0; j < len; j++) {
-		if (gelf_getsym(data, j, &sym) != &sym) {
-			warnx("gelf_getsym failed: %s", elf_errmsg(-1));
-			continue;
+	for (j = k = n = 0; j < len; j++, k++) {
+		if (k == n) {
+			if ((n = gelf_getsyms(data, j, BATCH_SIZE, syms)) <=
+			    0) {
+				warnx("gelf_getsyms failed: %s",
+				    elf_errmsg(-1));
+				break;
+			}
+			k = 0;
 		}
+		sym = syms[k];
 		name = get_string(ed, s->link, sym.st_name);
 		if (ed->flags & SOLARIS_FMT) {
 			snprintf(idx, sizeof(idx), "[%d]", j);
@@ -1825,6 +1840,8 @@ elf_print_dynamic(struct elfdump *ed)
 		case DT_SYMENT:
 		case DT_RELSZ:
 		case DT_RELENT:
+		case DT_RELRSZ:
+		case DT_RELRENT:
 		case DT_PLTREL:
 		case DT_VERDEF:
 		case DT_VERDEFNUM:
@@ -1845,6 +1862,7 @@ elf_print_dynamic(struct elfdump *ed)
 		case DT_INIT:
 		case DT_FINI:
 		case DT_REL:
+		case DT_RELR:
 		case DT_JMPREL:
 		case DT_DEBUG:
 			if (ed->flags & SOLARIS_FMT)
@@ -1905,7 +1923,8 @@ static void
 elf_print_rela(struct elfdump *ed, struct section *s, Elf_Data *data)
 {
 	struct rel_entry	r;
-	int			j, len;
+	GElf_Rela		relas[BATCH_SIZE];
+	int			j, k, len, n;
 
 	if (ed->flags & SOLARIS_FMT) {
 		PRT("\nRelocation Section:  %s\n", s->name);
@@ -1915,12 +1934,17 @@ elf_print_rela(struct elfdump *ed, struct section *s, Elf_Data *data)
 		PRT("\nrelocation with addend (%s):\n", s->name);
 	r.type = SHT_RELA;
 	len = data->d_size / s->entsize;
-	for (j = 0; j < len; j++) {
-		if (gelf_getrela(data, j, &r.u_r.rela) != &r.u_r.rela) {
-			warnx("gelf_getrela failed: %s",
-			    elf_errmsg(-1));
-			continue;
+	for (j = k = n = 0; j < len; j++, k++) {
+		if (k == n) {
+			if ((n = gelf_getrelas(data, j, BATCH_SIZE, relas)) <=
+			    0) {
+				warnx("gelf_getrelas failed: %s",
+				    elf_errmsg(-1));
+				break;
+			}
+			k = 0;
 		}
+		r.u_r.rela = relas[k];
 		r.symn = get_symbol_name(ed, s->link,
 		    GELF_R_SYM(r.u_r.rela.r_info));
 		elf_print_rel_entry(ed, s, j, &r);
@@ -1934,7 +1958,8 @@ static void
 elf_print_rel(struct elfdump *ed, struct section *s, Elf_Data *data)
 {
 	struct rel_entry	r;
-	int			j, len;
+	GElf_Rel		rels[BATCH_SIZE];
+	int			j, k, len, n;
 
 	if (ed->flags & SOLARIS_FMT) {
 		PRT("\nRelocation Section:  %s\n", s->name);
@@ -1944,17 +1969,75 @@ elf_print_rel(struct elfdump *ed, struct section *s, Elf_Data *data)
 		PRT("\nrelocation (%s):\n", s->name);
 	r.type = SHT_REL;
 	len = data->d_size / s->entsize;
-	for (j = 0; j < len; j++) {
-		if (gelf_getrel(data, j, &r.u_r.rel) != &r.u_r.rel) {
-			warnx("gelf_getrel failed: %s", elf_errmsg(-1));
-			continue;
+	for (j = k = n = 0; j < len; j++, k++) {
+		if (k == n) {
+			if ((n = gelf_getrels(data, j, BATCH_SIZE, rels)) <=
+			    0) {
+				warnx("gelf_getrels failed: %s",
+				    elf_errmsg(-1));
+				break;
+			}
+			k = 0;
 		}
+		r.u_r.rel = rels[k];
 		r.symn = get_symbol_name(ed, s->link,
 		    GELF_R_SYM(r.u_r.rel.r_info));
 		elf_print_rel_entry(ed, s, j, &r);
 	}
 }
 
+/*
+ * Dump a relocation section of type SHT_RELR, decoding the places
+ * encoded by each address and bitmap entry.
+ */
+static void
+elf_print_relr(struct elfdump *ed, struct section *s, Elf_Data *data)
+{
+	uint64_t	base, entry, off;
+	int		bits, j, k, len, w;
+
+	if (ed->flags & SOLARIS_FMT) {
+		PRT("\nRelative Relocation Section:  %s\n", s->name);
+		PRT("        entry                offset\n");
+	} else
+		PRT("\nrelative relocation (%s):\n", s->name);
+	w = ed->ec == ELFCLASS32 ? 4 : 8;
+	bits = w * 8 - 1;
+	base = 0;
+	len = data->d_size / w;
+	for (j = 0; j < len; j++) {
+		if (ed->ec == ELFCLASS32)
+			entry = ((uint32_t *) data->d_buf)[j];
+		else
+			entry = ((uint64_t *) data->d_buf)[j];
+		if (!(ed->flags & SOLARIS_FMT)) {
+			PRT("\n");
+			PRT("entry: %d\n", j);
+			PRT("\tr_relr: %#jx\n", (uintmax_t)entry);
+		}
+		if ((entry & 1) == 0) {
+			if (ed->flags & SOLARIS_FMT)
+				PRT("        %#18jx %#12jx\n", (uintmax_t)entry,
+				    (uintmax_t)entry);
+			else
+				PRT("\tr_offset: %#jx\n", (uintmax_t)entry);
+			base = entry + w;
+			continue;
+		}
+		for (k = 0; k < bits; k++) {
+			if (((entry >> (k + 1)) & 1) == 0)
+				continue;
+			off = base + (uint64_t)k * w;
+			if (ed->flags & SOLARIS_FMT)
+				PRT("        %#18jx %#12jx\n", (uintmax_t)entry,
+				    (uintmax_t)off);
+			else
+				PRT("\tr_offset: %#jx\n", (uintmax_t)off);
+		}
+		base += (uint64_t)bits * w;
+	}
+}
+
 /*
  * Dump relocation sections.
  */
@@ -1967,7 +2050,8 @@ elf_print_reloc(struct elfdump *ed)
 
 	for (i = 0; (size_t)i < ed->shnum; i++) {
 		s = &ed->sl[i];
-		if ((s->type == SHT_REL || s->type == SHT_RELA) &&
+		if ((s->type == SHT_REL || s->type == SHT_RELA ||
+		    s->type == SHT_RELR) &&
 		    (STAILQ_EMPTY(&ed->snl) || find_name(ed, s->name))) {
 			(void) elf_errno();
 			if ((data = elf_getdata(s->scn, NULL)) == NULL) {
@@ -1979,8 +2063,10 @@ elf_print_reloc(struct elfdump *ed)
 			}
 			if (s->type == SHT_REL)
 				elf_print_rel(ed, s, data);
-			else
+			else if (s->type == SHT_RELA)
 				elf_print_rela(ed, s, data);
+			else
+				elf_print_relr(ed, s, data);
 		}
 	}
 }
@@ -37,6 +37,19 @@
 
 ELFTC_VCSID("$Id$");
 
+/*
+ * Relaxations of GOT loads through R_X86_64_GOTPCRELX and
+ * R_X86_64_REX_GOTPCRELX relocations.
+ */
+enum amd64_got_relax {
+	GOT_RELAX_NONE,
+	GOT_RELAX_LEA,		/* mov foo@GOTPCREL(%rip),%reg */
+	GOT_RELAX_CALL,		/* call *foo@GOTPCREL(%rip) */
+	GOT_RELAX_JMP,		/* jmp *foo@GOTPCREL(%rip) */
+	GOT_RELAX_TEST,		/* test %reg,foo@GOTPCREL(%rip) */
+	GOT_RELAX_BINOP		/* op foo@GOTPCREL(%rip),%reg */
+};
+
 static void _create_plt_reloc(struct ld *ld, struct ld_symbol *lsb,
     uint64_t offset);
 static void _create_got_reloc(struct ld *ld, struct ld_symbol *lsb,
@@ -64,6 +77,8 @@ static void _reserve_got_entry(struct ld *ld, struct ld_symbol *lsb, int num);
 static void _reserve_gotplt_entry(struct ld *ld, struct ld_symbol *lsb);
 static void _reserve_plt_entry(struct ld *ld, struct ld_symbol *lsb);
 static int _is_absolute_reloc(uint64_t r);
+static int _is_branch_reloc(struct ld_reloc_entry *lre,
+    const uint8_t *buf);
 static void _warn_pic(struct ld *ld, struct ld_reloc_entry *lre);
 static void _create_tls_gd_reloc(struct ld *ld, struct ld_symbol *lsb);
 static void _create_tls_ld_reloc(struct ld *ld, struct ld_symbol *lsb);
@@ -73,18 +88,27 @@ static enum ld_tls_relax _tls_check_relax(struct ld *ld,
 static uint64_t _got_offset(struct ld *ld, struct ld_symbol *lsb);
 static int _tls_verify_gd(uint8_t *buf, uint64_t off);
 static int _tls_verify_ld(uint8_t *buf, uint64_t off);
-static void _tls_relax_gd_to_ie(struct ld *ld, struct ld_state *ls,
+static void _tls_relax_gd_to_ie(struct ld *ld, struct ld_input_section *is,
     struct ld_output *lo,struct ld_reloc_entry *lre, uint64_t p, uint64_t g,
     uint8_t *buf);
-static void _tls_relax_gd_to_le(struct ld *ld, struct ld_state *ls,
+static void _tls_relax_gd_to_le(struct ld *ld, struct ld_input_section *is,
     struct ld_output *lo, struct ld_reloc_entry *lre, struct ld_symbol *lsb,
     uint8_t *buf);
-static void _tls_relax_ld_to_le(struct ld *ld, struct ld_state *ls,
+static void _tls_relax_ld_to_le(struct ld *ld, struct ld_input_section *is,
     struct ld_reloc_entry *lre, uint8_t *buf);
 static void _tls_relax_ie_to_le(struct ld *ld, struct ld_output *lo,
     struct ld_reloc_entry *lre, struct ld_symbol *lsb, uint8_t *buf);
 static int32_t _tls_dtpoff(struct ld_output *lo, struct ld_symbol *lsb);
 static int32_t _tls_tpoff(struct ld_output *lo, struct ld_symbol *lsb);
+static enum amd64_got_relax _got_relax_form(struct ld *ld,
+    struct ld_reloc_entry *lre, uint8_t *buf);
+static enum amd64_got_relax _got_check_relax(struct ld *ld,
+    struct ld_input_section *is, struct ld_reloc_entry *lre, uint8_t *buf,
+    int scan);
+static uint64_t _got_relax_image_size(struct ld *ld);
+static void _got_relax(struct ld *ld, struct ld_output *lo,
+    enum amd64_got_relax gr, struct ld_reloc_entry *lre, uint64_t s,
+    uint64_t p, uint8_t *buf);
 
 static uint64_t
 _get_max_page_size(struct ld *ld)
@@ -132,6 +156,8 @@ _reloc2str(uint64_t r)
 		case 21: return "R_X86_64_DTPOFF32";
 		case 22: return "R_X86_64_GOTTPOFF";
 		case 23: return "R_X86_64_TPOFF32";
+		case 41: return "R_X86_64_GOTPCRELX";
+		case 42: return "R_X86_64_REX_GOTPCRELX";
 	default:
 		snprintf(s, sizeof(s), "<unkown: %ju>", r);
 		return (s);
@@ -159,6 +185,33 @@ _is_relative_reloc(uint64_t r)
 	return (0);
 }
 
+static int
+_is_branch_reloc(struct ld_reloc_entry *lre, const uint8_t *buf)
+{
+	uint64_t off;
+
+	if (lre->lre_type == R_X86_64_PLT32)
+		return (1);
+
+	/*
+	 * Calls and jumps to local functions are usually emitted with
+	 * R_X86_64_PC32 against the section symbol. Recognize them by the
+	 * opcode preceding the displacement.
+	 */
+	if (lre->lre_type != R_X86_64_PC32 || buf == NULL ||
+	    (lre->lre_tis->is_flags & SHF_EXECINSTR) == 0)
+		return (0);
+	off = lre->lre_offset;
+	if (off < 1 || off + 4 > lre->lre_tis->is_size)
+		return (0);
+	if (buf[off - 1] == 0xe8 || buf[off - 1] == 0xe9)
+		return (1);
+	if (off >= 2 && buf[off - 2] == 0x0f && (buf[off - 1] & 0xf0) == 0x80)
+		return (1);
+
+	return (0);
+}
+
 static void
 _warn_pic(struct ld *ld, struct ld_reloc_entry *lre)
 {
@@ -405,6 +458,7 @@ _finalize_got_and_plt(struct ld *ld)
 {
 	struct ld_output *lo;
 	struct ld_input_section *got_is, *rela_got_is, *plt_is, *rela_plt_is;
+	struct ld_input_section *relr_is;
 	struct ld_output_section *got_os, *plt_os, *rela_plt_os;
 	struct ld_reloc_entry *lre;
 	struct ld_symbol *lsb;
@@ -430,7 +484,8 @@ _finalize_got_and_plt(struct ld *ld)
 	 */
 	rela_got_is = ld_input_find_internal_section(ld, ".rela.got");
 	if (rela_got_is != NULL && rela_got_is->is_reloc != NULL) {
-		STAILQ_FOREACH(lre, rela_got_is->is_reloc, lre_next) {
+		for (j = 0; (uint64_t) j < rela_got_is->is_num_reloc; j++) {
+			lre = &rela_got_is->is_reloc[j];
 			if (lre->lre_type == R_X86_64_RELATIVE) {
 				lsb = lre->lre_sym;
 				got = (uint8_t *) got_is->is_ibuf +
@@ -440,6 +495,19 @@ _finalize_got_and_plt(struct ld *ld)
 		}
 	}
 
+	/* Do the same for GOT relocations packed in .relr.dyn. */
+	relr_is = ld_input_find_internal_section(ld, ".relr.dyn");
+	if (got_is != NULL && relr_is != NULL && relr_is->is_reloc != NULL) {
+		for (j = 0; (uint64_t) j < relr_is->is_num_reloc; j++) {
+			lre = &relr_is->is_reloc[j];
+			if (lre->lre_tis != got_is)
+				continue;
+			lsb = lre->lre_sym;
+			got = (uint8_t *) got_is->is_ibuf + lsb->lsb_got_off;
+			WRITE_64(got, lsb->lsb_value);
+		}
+	}
+
 	/*
 	 * Find the .plt section. The buffers should have been allocated
 	 * at this point.
@@ -469,8 +537,12 @@ _finalize_got_and_plt(struct ld *ld)
 	/* Point sh_info field of the .rela.plt to .plt section. */
 	rela_plt_os->os_info = plt_os;
 
-	/* Fill in the value of symbol _DYNAMIC in the first GOT entry. */
-	ld_symbols_get_value(ld, dynamic_symbol, &u64);
+	/*
+	 * Fill in the value of symbol _DYNAMIC in the first GOT entry,
+	 * or zero if there is no dynamic section.
+	 */
+	if (ld_symbols_get_value(ld, dynamic_symbol, &u64) < 0)
+		u64 = 0;
 	WRITE_64(got, u64);
 	got += 8;
 
@@ -518,8 +590,8 @@ _finalize_got_and_plt(struct ld *ld)
 	 * and fill in each GOT and PLT entries.
 	 */
 	i = 3;
-	j = 0;
-	STAILQ_FOREACH(lre, rela_plt_is->is_reloc, lre_next) {
+	for (j = 0; (uint64_t) j < rela_plt_is->is_num_reloc; j++) {
+		lre = &rela_plt_is->is_reloc[j];
 		lsb = ld_symbols_ref(lre->lre_sym);
 
 		/*
@@ -573,9 +645,6 @@ _finalize_got_and_plt(struct ld *ld)
 		u64 = plt_os->os_addr + (i - 2) * 16 + 6;
 		WRITE_64(got, u64);
 
-		/* Increase relocation entry index. */
-		j++;
-
 		/* Move to next GOT entry. */
 		got += 8;
 		i++;
@@ -787,6 +856,27 @@ _scan_reloc(struct ld *ld, struct ld_input_section *is,
 		}
 		break;
 
+	case R_X86_64_GOTPCRELX:
+	case R_X86_64_REX_GOTPCRELX:
+		/*
+		 * The GOT load is rewritten into a direct access if the
+		 * symbol is resolved locally and within reach, in which
+		 * case no GOT entry is needed.
+		 */
+		if (_got_check_relax(ld, is, lre,
+		    ld_input_get_section_rawdata(ld, is), 1) != GOT_RELAX_NONE)
+			break;
+		if (!lsb->lsb_got) {
+			_reserve_got_entry(ld, lsb, 1);
+			if (ld_reloc_require_glob_dat(ld, lre))
+				_create_got_reloc(ld, lsb, R_X86_64_GLOB_DAT,
+				    lsb->lsb_got_off);
+			else
+				_create_got_reloc(ld, lsb, R_X86_64_RELATIVE,
+				    lsb->lsb_got_off);
+		}
+		break;
+
 	case R_X86_64_TLSGD:	/* Global Dynamic */
 		tr = _tls_check_relax(ld, lre);
 		switch (tr) {
@@ -864,15 +954,13 @@ static void
 _process_reloc(struct ld *ld, struct ld_input_section *is,
     struct ld_reloc_entry *lre, struct ld_symbol *lsb, uint8_t *buf)
 {
-	struct ld_state *ls;
 	struct ld_output *lo;
 	uint64_t u64, s, l, p, g;
 	int64_t s64;
 	uint32_t u32;
 	int32_t s32;
 	enum ld_tls_relax tr;
-
-	ls = &ld->ld_state;
+	enum amd64_got_relax gr;
 
 	lo = ld->ld_output;
 	assert(lo != NULL);
@@ -898,11 +986,11 @@ _process_reloc(struct ld *ld, struct ld_input_section *is,
 		break;
 
 	case R_X86_64_PLT32:
-		if (!ls->ls_ignore_next_plt) {
+		if (!is->is_ignore_next_plt) {
 			s32 = l + lre->lre_addend - p;
 			WRITE_32(buf + lre->lre_offset, s32);
 		} else
-			ls->ls_ignore_next_plt = 0;
+			is->is_ignore_next_plt = 0;
 		break;
 
 	case R_X86_64_GOTPCREL:
@@ -911,6 +999,21 @@ _process_reloc(struct ld *ld, struct ld_input_section *is,
 		WRITE_32(buf + lre->lre_offset, s32);
 		break;
 
+	case R_X86_64_GOTPCRELX:
+	case R_X86_64_REX_GOTPCRELX:
+		gr = _got_check_relax(ld, is, lre, buf, 0);
+		if (gr == GOT_RELAX_NONE) {
+			/* The scan expected the relaxed load to fit. */
+			if (!lsb->lsb_got)
+				ld_fatal(ld, "%s relocation failed",
+				    _reloc2str(lre->lre_type));
+			g = _got_offset(ld, lsb);
+			s32 = g + lre->lre_addend - p;
+			WRITE_32(buf + lre->lre_offset, s32);
+		} else
+			_got_relax(ld, lo, gr, lre, s, p, buf);
+		break;
+
 	case R_X86_64_32:
 		u64 = s + lre->lre_addend;
 		u32 = u64 & 0xffffffff;
@@ -937,10 +1040,10 @@ _process_reloc(struct ld *ld, struct ld_input_section *is,
 			break;
 		case TLS_RELAX_INIT_EXEC:
 			g = _got_offset(ld, lsb);
-			_tls_relax_gd_to_ie(ld, ls, lo, lre, p, g, buf);
+			_tls_relax_gd_to_ie(ld, is, lo, lre, p, g, buf);
 			break;
 		case TLS_RELAX_LOCAL_EXEC:
-			_tls_relax_gd_to_le(ld, ls, lo, lre, lsb, buf);
+			_tls_relax_gd_to_le(ld, is, lo, lre, lsb, buf);
 			break;
 		default:
 			ld_fatal(ld, "Internal: invalid TLS relaxation %d",
@@ -958,7 +1061,7 @@ _process_reloc(struct ld *ld, struct ld_input_section *is,
 			WRITE_32(buf + lre->lre_offset, s32);
 			break;
 		case TLS_RELAX_LOCAL_EXEC:
-			_tls_relax_ld_to_le(ld, ls, lre, buf);
+			_tls_relax_ld_to_le(ld, is, lre, buf);
 			break;
 		default:
 			ld_fatal(ld, "Internal: invalid TLS relaxation %d",
@@ -1039,6 +1142,249 @@ _adjust_reloc(struct ld *ld, struct ld_input_section *is,
 	lre->lre_addend += _is->is_reloff;
 }
 
+static enum amd64_got_relax
+_got_relax_form(struct ld *ld, struct ld_reloc_entry *lre, uint8_t *buf)
+{
+	struct ld_symbol *lsb;
+	uint64_t off;
+	uint8_t modrm, op;
+	int pic;
+
+	lsb = ld_symbols_ref(lre->lre_sym);
+	off = lre->lre_offset;
+
+	/*
+	 * The relaxed instruction refers to the symbol itself, which
+	 * therefore should be resolved locally. The addend should be the
+	 * one of a plain GOT load, i.e. refer to the end of the
+	 * instruction.
+	 */
+	if (buf == NULL || off < 2 || (int64_t) lre->lre_addend != -4)
+		return (GOT_RELAX_NONE);
+	if (ld_reloc_require_glob_dat(ld, lre) ||
+	    lsb->lsb_type == STT_GNU_IFUNC)
+		return (GOT_RELAX_NONE);
+
+	/*
+	 * An absolute symbol can not be addressed relative to %rip in a
+	 * position-independent output object.
+	 */
+	pic = ld->ld_dso || ld->ld_pie;
+	if (pic && lsb->lsb_shndx == SHN_ABS)
+		return (GOT_RELAX_NONE);
+
+	op = buf[off - 2];
+	modrm = buf[off - 1];
+
+	/* "mov foo@GOTPCREL(%rip),%reg" -> "lea foo(%rip),%reg" */
+	if (op == 0x8b)
+		return (GOT_RELAX_LEA);
+
+	/*
+	 * "call *foo@GOTPCREL(%rip)" -> "addr32 call foo" and
+	 * "jmp *foo@GOTPCREL(%rip)" -> "jmp foo; nop". These never
+	 * carry a REX prefix.
+	 */
+	if (op == 0xff && lre->lre_type == R_X86_64_GOTPCRELX) {
+		if (modrm == 0x15)
+			return (GOT_RELAX_CALL);
+		if (modrm == 0x25)
+			return (GOT_RELAX_JMP);
+		return (GOT_RELAX_NONE);
+	}
+
+	/*
+	 * The other instructions take the symbol address as an
+	 * immediate operand instead, which is only known at link time
+	 * when the output object is not position-independent.
+	 */
+	if (pic || (modrm & 0xc7) != 0x05)
+		return (GOT_RELAX_NONE);
+	if (lre->lre_type == R_X86_64_REX_GOTPCRELX &&
+	    (off < 3 || (buf[off - 3] & 0xf0) != 0x40))
+		return (GOT_RELAX_NONE);
+
+	/* "test %reg,foo@GOTPCREL(%rip)" -> "test $foo,%reg" */
+	if (op == 0x85)
+		return (GOT_RELAX_TEST);
+
+	/*
+	 * "op foo@GOTPCREL(%rip),%reg" -> "op $foo,%reg", where op is
+	 * one of adc, add, and, cmp, or, sbb, sub and xor.
+	 */
+	if ((op & 0xc7) == 0x03)
+		return (GOT_RELAX_BINOP);
+
+	return (GOT_RELAX_NONE);
+}
+
+static enum amd64_got_relax
+_got_check_relax(struct ld *ld, struct ld_input_section *is,
+    struct ld_reloc_entry *lre, uint8_t *buf, int scan)
+{
+	struct ld_symbol *lsb;
+	enum amd64_got_relax gr;
+	uint64_t off, p, s;
+	int64_t d;
+
+	if ((gr = _got_relax_form(ld, lre, buf)) == GOT_RELAX_NONE)
+		return (GOT_RELAX_NONE);
+
+	lsb = ld_symbols_ref(lre->lre_sym);
+	off = lre->lre_offset;
+
+	/*
+	 * The relaxed instruction holds the distance to the symbol, or
+	 * the symbol address itself, in 32 bits. Otherwise the GOT
+	 * load is kept.
+	 *
+	 * Addresses are not assigned yet when relocations are scanned.
+	 * No GOT entry is reserved for a relaxed load at that point, so
+	 * it is only relaxed if it will fit whatever the layout: the
+	 * value of an absolute symbol is known already, and any other
+	 * symbol lies within the output image, which is placed in the
+	 * low 2GB of the address space unless it is very large.
+	 */
+	s = lsb->lsb_value;
+	if (scan) {
+		if (_got_relax_image_size(ld) >= 0x40000000)
+			return (GOT_RELAX_NONE);
+		if (lsb->lsb_shndx != SHN_ABS)
+			return (gr);
+		if (gr == GOT_RELAX_LEA || gr == GOT_RELAX_CALL ||
+		    gr == GOT_RELAX_JMP)
+			return (s <= INT32_MAX ? gr : GOT_RELAX_NONE);
+	}
+
+	switch (gr) {
+	case GOT_RELAX_LEA:
+	case GOT_RELAX_CALL:
+	case GOT_RELAX_JMP:
+		p = off + is->is_output->os_addr + is->is_reloff;
+		d = s + lre->lre_addend - p;
+		if (gr == GOT_RELAX_JMP)
+			d++;
+		if (d < INT32_MIN || d > INT32_MAX)
+			return (GOT_RELAX_NONE);
+		break;
+	default:
+		/* A 64-bit operation sign-extends the immediate. */
+		if (lre->lre_type == R_X86_64_REX_GOTPCRELX &&
+		    (buf[off - 3] & 0x8) != 0) {
+			if ((int64_t) s < INT32_MIN || (int64_t) s > INT32_MAX)
+				return (GOT_RELAX_NONE);
+		} else if (s > UINT32_MAX)
+			return (GOT_RELAX_NONE);
+		break;
+	}
+
+	return (gr);
+}
+
+/*
+ * Return an upper bound of the size of the output image before it is
+ * laid out: the size and alignment of every input section and common
+ * symbol.
+ */
+static uint64_t
+_got_relax_image_size(struct ld *ld)
+{
+	static uint64_t size;
+	static int done;
+	struct ld_input *li;
+	struct ld_input_section *is;
+	struct ld_symbol *lsb, *_lsb;
+	size_t i;
+
+	if (done)
+		return (size);
+
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		for (i = 0; i < li->li_shnum; i++) {
+			is = &li->li_is[i];
+			size += is->is_size + is->is_align;
+		}
+	}
+	HASH_ITER(hh, ld->ld_sym, lsb, _lsb) {
+		/* The value of a common symbol is its alignment. */
+		if (lsb->lsb_shndx == SHN_COMMON)
+			size += lsb->lsb_size + lsb->lsb_value;
+	}
+	done = 1;
+
+	return (size);
+}
+
+static void
+_got_relax(struct ld *ld, struct ld_output *lo, enum amd64_got_relax gr,
+    struct ld_reloc_entry *lre, uint64_t s, uint64_t p, uint8_t *buf)
+{
+	uint64_t off;
+	int32_t s32;
+	uint32_t u32;
+	uint8_t reg, rex;
+
+	off = lre->lre_offset;
+	s32 = s + lre->lre_addend - p;
+
+	switch (gr) {
+	case GOT_RELAX_LEA:
+		buf[off - 2] = 0x8d;
+		WRITE_32(buf + off, s32);
+		break;
+
+	case GOT_RELAX_CALL:
+		/*
+		 * The addr32 prefix pads the 5-byte direct call to the
+		 * size of the original instruction.
+		 */
+		buf[off - 2] = 0x67;
+		buf[off - 1] = 0xe8;
+		WRITE_32(buf + off, s32);
+		break;
+
+	case GOT_RELAX_JMP:
+		/*
+		 * The direct jump starts one byte earlier, the nop that
+		 * follows it is never executed.
+		 */
+		buf[off - 2] = 0xe9;
+		s32++;
+		WRITE_32(buf + off - 1, s32);
+		buf[off + 3] = 0x90;
+		break;
+
+	case GOT_RELAX_TEST:
+	case GOT_RELAX_BINOP:
+		/*
+		 * The register moves from the reg field to the r/m field
+		 * of ModRM, hence REX.R moves to REX.B as well.
+		 */
+		reg = (buf[off - 1] >> 3) & 0x7;
+		if (gr == GOT_RELAX_TEST) {
+			buf[off - 2] = 0xf7;
+			buf[off - 1] = 0xc0 | reg;
+		} else {
+			/* The opcode extension selects the operation. */
+			buf[off - 1] = 0xc0 | (buf[off - 2] & 0x38) | reg;
+			buf[off - 2] = 0x81;
+		}
+		if (lre->lre_type == R_X86_64_REX_GOTPCRELX) {
+			rex = buf[off - 3];
+			buf[off - 3] = (rex & ~0x4) | ((rex & 0x4) >> 2);
+		}
+
+		/* _got_check_relax() has made sure that the value fits. */
+		u32 = s & 0xffffffff;
+		WRITE_32(buf + off, u32);
+		break;
+
+	default:
+		ld_fatal(ld, "Internal: invalid GOT relaxation %d", gr);
+		break;
+	}
+}
+
 static enum ld_tls_relax
 _tls_check_relax(struct ld *ld, struct ld_reloc_entry *lre)
 {
@@ -1135,8 +1481,9 @@ _tls_verify_ld(uint8_t *buf, uint64_t off)
 }
 
 static void
-_tls_relax_gd_to_ie(struct ld *ld, struct ld_state *ls, struct ld_output *lo,
-    struct ld_reloc_entry *lre, uint64_t p, uint64_t g, uint8_t *buf)
+_tls_relax_gd_to_ie(struct ld *ld, struct ld_input_section *is,
+    struct ld_output *lo, struct ld_reloc_entry *lre, uint64_t p, uint64_t g,
+    uint8_t *buf)
 {
 	/*
 	 * Initial Exec model:
@@ -1168,12 +1515,13 @@ _tls_relax_gd_to_ie(struct ld *ld, struct ld_state *ls, struct ld_output *lo,
 	WRITE_32(buf + lre->lre_offset + 8, s32);
 
 	/* Ignore the next R_X86_64_PLT32 relocation for _tls_get_addr. */
-	ls->ls_ignore_next_plt = 1;
+	is->is_ignore_next_plt = 1;
 }
 
 static void
-_tls_relax_gd_to_le(struct ld *ld, struct ld_state *ls, struct ld_output *lo,
-    struct ld_reloc_entry *lre, struct ld_symbol *lsb, uint8_t *buf)
+_tls_relax_gd_to_le(struct ld *ld, struct ld_input_section *is,
+    struct ld_output *lo, struct ld_reloc_entry *lre, struct ld_symbol *lsb,
+    uint8_t *buf)
 {
 	/*
 	 * Local Exec model:
@@ -1200,11 +1548,11 @@ _tls_relax_gd_to_le(struct ld *ld, struct ld_state *ls, struct ld_output *lo,
 	WRITE_32(buf + lre->lre_offset + 8, s32);
 
 	/* Ignore the next R_X86_64_PLT32 relocation for _tls_get_addr. */
-	ls->ls_ignore_next_plt = 1;
+	is->is_ignore_next_plt = 1;
 }
 
 static void
-_tls_relax_ld_to_le(struct ld *ld, struct ld_state *ls,
+_tls_relax_ld_to_le(struct ld *ld, struct ld_input_section *is,
     struct ld_reloc_entry *lre, uint8_t *buf)
 {
 	/*
@@ -1225,7 +1573,7 @@ _tls_relax_ld_to_le(struct ld *ld, struct ld_state *ls,
 	memcpy(buf + lre->lre_offset - 3, le_p, sizeof(le_p) - 1);
 
 	/* Ignore the next R_X86_64_PLT32 relocation for _tls_get_addr. */
-	ls->ls_ignore_next_plt = 1;
+	is->is_ignore_next_plt = 1;
 }
 
 static void
@@ -1345,6 +1693,7 @@ amd64_register(struct ld *ld)
 	amd64->adjust_reloc = _adjust_reloc;
 	amd64->is_absolute_reloc = _is_absolute_reloc;
 	amd64->is_relative_reloc = _is_relative_reloc;
+	amd64->is_branch_reloc = _is_branch_reloc;
 	amd64->finalize_reloc = _finalize_reloc;
 	amd64->finalize_got_and_plt = _finalize_got_and_plt;
 	amd64->reloc_is_64bit = 1;
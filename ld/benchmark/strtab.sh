@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# Measure the time ld(1) takes to link a large object with many
+# symbols and sections.
+#
+# An assembler source file defining `N' global symbols, spread over
+# `S' sections, is generated and assembled, and the resulting object
+# is linked with `ld -r'.  Every symbol name ends up in .strtab and
+# every section name in .shstrtab.
+#
+# Usage: strtab.sh [-n N] [-s S] [ld...]
+#
+# $Id$
+
+n=500000
+s=5000
+while getopts n:s: opt; do
+	case "$opt" in
+	n)	n="$OPTARG";;
+	s)	s="$OPTARG";;
+	*)	echo "usage: $0 [-n N] [-s S] [ld...]" >&2; exit 1;;
+	esac
+done
+shift $((OPTIND - 1))
+[ $# -eq 0 ] && set -- "$(dirname "$0")/../ld"
+
+tmpdir=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmpdir"' EXIT
+
+awk -v n="$n" -v s="$s" 'BEGIN {
+	for (i = 0; i < n; i++) {
+		if (i % int((n + s - 1) / s) == 0)
+			printf "\t.section\tbench.%d,\"a\",@progbits\n", i;
+		printf "\t.globl\tbench_symbol_%d\n", i;
+		printf "bench_symbol_%d:\n\t.byte\t%d\n", i, i % 256;
+	}
+}' > "$tmpdir/bench.s"
+${CC:-cc} -c -o "$tmpdir/bench.o" "$tmpdir/bench.s" || exit 1
+
+for ld in "$@"; do
+	start=$(date +%s.%N)
+	"$ld" -r -o "$tmpdir/out.o" "$tmpdir/bench.o" ||
+	    echo "$ld: exit status $?" >&2
+	end=$(date +%s.%N)
+	awk -v ld="$ld" -v n="$n" -v s="$s" -v t0="$start" -v t1="$end" \
+	    'BEGIN { printf "%s\t%d symbols\t%d sections\t%.2f s\n", ld, n,
+	    s, t1 - t0 }'
+done
@@ -61,6 +61,8 @@ static void _reserve_gotplt_entry(struct ld *ld, struct ld_symbol *lsb);
 static void _reserve_plt_entry(struct ld *ld, struct ld_symbol *lsb);
 static int _is_absolute_reloc(uint64_t r);
 static int _is_relative_reloc(uint64_t r);
+static int _is_branch_reloc(struct ld_reloc_entry *lre,
+    const uint8_t *buf);
 static void _warn_pic(struct ld *ld, struct ld_reloc_entry *lre);
 static uint32_t _got_offset(struct ld *ld, struct ld_symbol *lsb);
 
@@ -144,6 +146,33 @@ _is_relative_reloc(uint64_t r)
 	return (0);
 }
 
+static int
+_is_branch_reloc(struct ld_reloc_entry *lre, const uint8_t *buf)
+{
+	uint64_t off;
+
+	if (lre->lre_type == R_386_PLT32)
+		return (1);
+
+	/*
+	 * Calls and jumps to local functions are usually emitted with
+	 * R_386_PC32 against the section symbol. Recognize them by the
+	 * opcode preceding the displacement.
+	 */
+	if (lre->lre_type != R_386_PC32 || buf == NULL ||
+	    (lre->lre_tis->is_flags & SHF_EXECINSTR) == 0)
+		return (0);
+	off = lre->lre_offset;
+	if (off < 1 || off + 4 > lre->lre_tis->is_size)
+		return (0);
+	if (buf[off - 1] == 0xe8 || buf[off - 1] == 0xe9)
+		return (1);
+	if (off >= 2 && buf[off - 2] == 0x0f && (buf[off - 1] & 0xf0) == 0x80)
+		return (1);
+
+	return (0);
+}
+
 static void
 _warn_pic(struct ld *ld, struct ld_reloc_entry *lre)
 {
@@ -536,13 +565,10 @@ static void
 _process_reloc(struct ld *ld, struct ld_input_section *is,
     struct ld_reloc_entry *lre, struct ld_symbol *lsb, uint8_t *buf)
 {
-	struct ld_state *ls;
 	struct ld_output *lo;
 	uint32_t p, s, l, g, got;
 	int32_t a, v;
 
-	ls = &ld->ld_state;
-
 	lo = ld->ld_output;
 	assert(lo != NULL);
 
@@ -570,11 +596,11 @@ _process_reloc(struct ld *ld, struct ld_input_section *is,
 		break;
 
 	case R_386_PLT32:
-		if (!ls->ls_ignore_next_plt) {
+		if (!is->is_ignore_next_plt) {
 			v = l + a - p;
 			WRITE_32(buf + lre->lre_offset, v);
 		} else
-			ls->ls_ignore_next_plt = 0;
+			is->is_ignore_next_plt = 0;
 		break;
 
 	case R_386_GOT32:
@@ -616,6 +642,7 @@ i386_register(struct ld *ld)
 	i386_arch->process_reloc = _process_reloc;
 	i386_arch->is_absolute_reloc = _is_absolute_reloc;
 	i386_arch->is_relative_reloc = _is_relative_reloc;
+	i386_arch->is_branch_reloc = _is_branch_reloc;
 	i386_arch->reloc_is_64bit = 0;
 	i386_arch->reloc_is_rela = 0;
 	i386_arch->reloc_entsize = sizeof(Elf32_Rel);
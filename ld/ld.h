@@ -33,6 +33,7 @@
 #include <sys/stat.h>
 #include <ar.h>
 #include <assert.h>
+#include <ctype.h>
 #include <dirent.h>
 #include <err.h>
 #include <errno.h>
@@ -42,6 +43,7 @@
 #include <inttypes.h>
 #include <libelftc.h>
 #include <libgen.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -55,22 +57,29 @@
 #include "uthash.h"
 #include "_elftc.h"
 
+struct ld_arena_chunk;
 struct ld_file;
+struct ld_file_cache;
 struct ld_input_section_head;
 struct ld_path;
 struct ld_symbol;
 struct ld_symbol_head;
 struct ld_output_data_buffer;
-struct ld_wildcard_match;
+struct ld_symver_matcher;
+struct ld_wildcard_matcher;
 struct ld_ehframe_cie_head;
 struct ld_ehframe_fde_head;
 struct ld_section_group;
 
 #define	LD_MAX_NESTED_GROUP	16
+#define	LD_GELF_BATCH		256	/* entries read from libelf at once */
+#define	LD_MAX_THREADS		256	/* limit for --threads */
+
+#define	LD_HASH_STYLE_SYSV	0x1	/* create .hash section */
+#define	LD_HASH_STYLE_GNU	0x2	/* create .gnu.hash section */
 
 struct ld_state {
 	Elftc_Bfd_Target *ls_itgt;	/* input bfd target set by -b */
-	struct ld_file *ls_file;	/* current open file */
 	unsigned ls_static;		/* use static library */
 	unsigned ls_whole_archive;	/* include whole archive */
 	unsigned ls_as_needed;		/* DT_NEEDED */
@@ -88,7 +97,6 @@ struct ld_state {
 	unsigned ls_rerun;		/* ld(1) restarted */
 	unsigned ls_archive_mb_header;	/* extracted list header printed */
 	unsigned ls_first_output_sec;	/* flag indicates 1st output section */
-	unsigned ls_ignore_next_plt;	/* ignore next PLT relocation */
 	unsigned ls_version_local;	/* version entry is local */
 	uint64_t ls_relative_reloc;	/* number of *_RELATIVE relocations */
 	struct ld_input_section_head *ls_gc;
@@ -116,7 +124,11 @@ struct ld {
 	struct ld_strtab *ld_shstrtab;	/* section name table */
 	struct ld_symbol_head *ld_ext_symbols; /* -u/EXTERN symbols */
 	struct ld_symbol_head *ld_var_symbols; /* ldscript var symbols */
+	struct ld_arena_chunk *ld_arena; /* arena allocator chunks */
 	struct ld_symbol *ld_sym;	/* internal symbol table */
+	struct ld_symbol **ld_undef;	/* undefined symbol worklist */
+	size_t ld_undef_num;		/* number of worklist entries */
+	size_t ld_undef_cap;		/* capacity of the worklist */
 	struct ld_symbol *ld_symtab_import; /* hash for import symbols */
 	struct ld_symbol *ld_symtab_export; /* hash for export symbols */
 	struct ld_symbol_defver *ld_defver; /* default version table */
@@ -125,7 +137,8 @@ struct ld {
 	struct ld_symbol_table *ld_dynsym; /* .dynsym symbol table */
 	struct ld_strtab *ld_dynstr;	/* .dynstr string table */
 	struct ld_symbol_head *ld_dyn_symbols; /* dynamic symbol list */
-	struct ld_wildcard_match *ld_wm; /* wildcard hash table */
+	struct ld_wildcard_matcher *ld_wm; /* section wildcard matcher */
+	struct ld_symver_matcher *ld_vm; /* version script matcher */
 	struct ld_input_section *ld_dynbss; /* .dynbss section */
 	struct ld_input_section *ld_got;    /* .got section */
 	struct ld_ehframe_cie_head *ld_cie; /* ehframe CIE list */
@@ -146,7 +159,18 @@ struct ld {
 	unsigned char ld_print_version; /* linker version printed */
 	unsigned char ld_gc;		/* perform garbage collection */
 	unsigned char ld_gc_print;	/* print removed sections */
+	unsigned char ld_icf;		/* identical code folding mode */
+	unsigned char ld_icf_print;	/* print folded sections */
+	unsigned char ld_stats;		/* print statistics */
 	unsigned char ld_ehframe_hdr;	/* create .eh_frame_hdr section */
+	unsigned char ld_relr;		/* pack relative relocations */
+	unsigned char ld_hash_style;	/* dynamic symbol hash sections */
+	unsigned char ld_build_id;	/* build ID style */
+	uint8_t *ld_build_id_hex;	/* build ID given as 0xHEX */
+	size_t ld_build_id_hexsz;	/* size of ld_build_id_hex */
+	unsigned ld_threads;		/* number of worker threads */
+	uint64_t ld_file_cache_size;	/* input file cache budget */
+	struct ld_file_cache *ld_fc;	/* input file cache */
 	STAILQ_HEAD(ld_input_head, ld_input) ld_lilist; /* input object list */
 	TAILQ_HEAD(ld_file_head, ld_file) ld_lflist; /* input file list */
 };
@@ -0,0 +1,161 @@
+/*-
+ * Copyright (c) 2026 The Elftoolchain Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "ld.h"
+#include "ld_arena.h"
+
+ELFTC_VCSID("$Id$");
+
+/*
+ * A bump allocator for objects that live until the end of the link,
+ * such as symbols, symbol names and input section descriptors.
+ *
+ * Memory is handed out from large zero-filled chunks and is never
+ * freed individually; ld_arena_cleanup() releases all the chunks at
+ * once.  The allocator is not thread-safe; threads allocate from
+ * chunk lists of their own, which are joined to the arena when the
+ * threads are done.
+ */
+
+#define	_ARENA_CHUNK_SIZE	(1024 * 1024)
+#define	_ARENA_ALIGN		16
+
+struct ld_arena_chunk {
+	struct ld_arena_chunk *ac_next;	/* next chunk */
+	size_t ac_size;			/* usable size */
+	size_t ac_used;			/* bytes handed out */
+};
+
+#define	_ARENA_HDR_SIZE		roundup(sizeof(struct ld_arena_chunk), \
+	_ARENA_ALIGN)
+
+void *
+ld_arena_calloc(struct ld *ld, size_t nmemb, size_t size)
+{
+
+	return (ld_arena_calloc_r(ld, &ld->ld_arena, nmemb, size));
+}
+
+/*
+ * Allocate from the chunk list `head' instead of the arena.
+ */
+void *
+ld_arena_calloc_r(struct ld *ld, struct ld_arena_chunk **head, size_t nmemb,
+    size_t size)
+{
+	struct ld_arena_chunk *ac;
+	size_t sz;
+	void *p;
+
+	if (size != 0 && nmemb > SIZE_MAX / size)
+		ld_fatal(ld, "arena: allocation too large");
+
+	sz = roundup(nmemb * size, _ARENA_ALIGN);
+
+	ac = *head;
+	if (ac == NULL || ac->ac_size - ac->ac_used < sz) {
+		/*
+		 * Large requests get a chunk of their own, placed behind
+		 * the current chunk so that its free space is not lost.
+		 */
+		if (sz > _ARENA_CHUNK_SIZE / 4) {
+			if ((ac = calloc(1, _ARENA_HDR_SIZE + sz)) == NULL)
+				ld_fatal_std(ld, "calloc");
+			ac->ac_size = ac->ac_used = sz;
+			if (*head != NULL) {
+				ac->ac_next = (*head)->ac_next;
+				(*head)->ac_next = ac;
+			} else
+				*head = ac;
+			return ((char *) ac + _ARENA_HDR_SIZE);
+		}
+
+		if ((ac = calloc(1, _ARENA_HDR_SIZE + _ARENA_CHUNK_SIZE)) ==
+		    NULL)
+			ld_fatal_std(ld, "calloc");
+		ac->ac_size = _ARENA_CHUNK_SIZE;
+		ac->ac_next = *head;
+		*head = ac;
+	}
+
+	p = (char *) ac + _ARENA_HDR_SIZE + ac->ac_used;
+	ac->ac_used += sz;
+
+	return (p);
+}
+
+char *
+ld_arena_strdup(struct ld *ld, const char *s)
+{
+
+	return (ld_arena_strdup_r(ld, &ld->ld_arena, s));
+}
+
+char *
+ld_arena_strdup_r(struct ld *ld, struct ld_arena_chunk **head, const char *s)
+{
+	size_t len;
+	char *p;
+
+	len = strlen(s) + 1;
+	p = ld_arena_calloc_r(ld, head, len, 1);
+	memcpy(p, s, len);
+
+	return (p);
+}
+
+/*
+ * Hand the chunk list `head' over to the arena.
+ */
+void
+ld_arena_join(struct ld *ld, struct ld_arena_chunk *head)
+{
+	struct ld_arena_chunk *ac;
+
+	if (head == NULL)
+		return;
+
+	/* Keep the current chunk first, so its free space is used. */
+	for (ac = head; ac->ac_next != NULL; ac = ac->ac_next)
+		;
+	if (ld->ld_arena != NULL) {
+		ac->ac_next = ld->ld_arena->ac_next;
+		ld->ld_arena->ac_next = head;
+	} else
+		ld->ld_arena = head;
+}
+
+void
+ld_arena_cleanup(struct ld *ld)
+{
+	struct ld_arena_chunk *ac, *_ac;
+
+	for (ac = ld->ld_arena; ac != NULL; ac = _ac) {
+		_ac = ac->ac_next;
+		free(ac);
+	}
+	ld->ld_arena = NULL;
+}
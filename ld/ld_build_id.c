@@ -0,0 +1,485 @@
+/*-
+ * Copyright (c) 2026 The Elftoolchain Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "ld.h"
+#include "ld_build_id.h"
+#include "ld_hash.h"
+#include "ld_input.h"
+#include "ld_output.h"
+#include "ld_utils.h"
+
+ELFTC_VCSID("$Id$");
+
+/*
+ * Support routines for the .note.gnu.build-id section (--build-id).
+ *
+ * The hashed build ID styles are computed over the output file after
+ * it has been written out, while the build ID itself is still zero.
+ * The file is cut into chunks of a fixed size which are hashed
+ * independently, in parallel if --threads is given, and the build ID
+ * is the hash of the concatenated chunk digests.  Since the chunk size
+ * does not depend on the number of threads, neither does the build ID.
+ */
+
+#define	_BUILD_ID_NAME		".note.gnu.build-id"
+#define	_BUILD_ID_CHUNK		(1024 * 1024)
+#define	_NOTE_HEADER_SIZE	16	/* namesz, descsz, type and "GNU" */
+
+#define	_ROTL32(X,N)	(((X) << (N)) | ((X) >> (32 - (N))))
+
+struct ld_build_id_hash {
+	int bh_style;			/* build ID style */
+	const uint8_t *bh_image;	/* output file image */
+	size_t bh_size;			/* size of the image */
+	size_t bh_nchunk;		/* number of chunks */
+	uint8_t *bh_digest;		/* digests of the chunks */
+	size_t bh_digest_size;		/* size of one digest */
+	size_t bh_first;		/* first chunk hashed by a thread */
+	size_t bh_stride;		/* distance between its chunks */
+};
+
+static void _digest(int style, const uint8_t *p, size_t len, uint8_t *out);
+static size_t _digest_size(struct ld *ld);
+static void *_hash_chunks(void *arg);
+static void _md5_block(uint32_t *h, const uint8_t *p);
+static void _md_pad(uint32_t *h, void (*block)(uint32_t *, const uint8_t *),
+    const uint8_t *p, size_t len, int big_endian);
+static void _random_uuid(struct ld *ld, uint8_t *p);
+static void _sha1_block(uint32_t *h, const uint8_t *p);
+
+void
+ld_build_id_set_style(struct ld *ld, const char *style)
+{
+	const char *s;
+	uint8_t *p;
+	size_t n;
+	int c, v;
+
+	free(ld->ld_build_id_hex);
+	ld->ld_build_id_hex = NULL;
+	ld->ld_build_id_hexsz = 0;
+
+	/* A bare --build-id selects SHA-1, like GNU ld. */
+	if (style == NULL || !strcmp(style, "sha1"))
+		ld->ld_build_id = LD_BUILD_ID_SHA1;
+	else if (!strcmp(style, "none"))
+		ld->ld_build_id = LD_BUILD_ID_NONE;
+	else if (!strcmp(style, "fast"))
+		ld->ld_build_id = LD_BUILD_ID_FAST;
+	else if (!strcmp(style, "md5"))
+		ld->ld_build_id = LD_BUILD_ID_MD5;
+	else if (!strcmp(style, "uuid"))
+		ld->ld_build_id = LD_BUILD_ID_UUID;
+	else if (style[0] == '0' && (style[1] == 'x' || style[1] == 'X')) {
+		/* Hexadecimal digits, optionally separated by '-' or ':'. */
+		n = 0;
+		for (s = style + 2; *s != '\0'; s++) {
+			if (isxdigit((unsigned char) *s))
+				n++;
+			else if (*s != '-' && *s != ':')
+				ld_fatal(ld, "invalid build ID: %s", style);
+		}
+		if (n == 0 || n % 2 != 0)
+			ld_fatal(ld, "invalid build ID: %s", style);
+		if ((p = calloc(n / 2, 1)) == NULL)
+			ld_fatal_std(ld, "calloc");
+		n = 0;
+		for (s = style + 2; *s != '\0'; s++) {
+			if (!isxdigit((unsigned char) *s))
+				continue;
+			c = tolower((unsigned char) *s);
+			v = isdigit(c) ? c - '0' : c - 'a' + 10;
+			p[n / 2] |= n % 2 == 0 ? v << 4 : v;
+			n++;
+		}
+		ld->ld_build_id = LD_BUILD_ID_HEX;
+		ld->ld_build_id_hex = p;
+		ld->ld_build_id_hexsz = n / 2;
+	} else
+		ld_fatal(ld, "unknown build ID style: %s", style);
+}
+
+void
+ld_build_id_create(struct ld *ld)
+{
+	struct ld_input_section *is;
+
+	is = ld_input_add_internal_section(ld, _BUILD_ID_NAME);
+	is->is_type = SHT_NOTE;
+	is->is_flags = SHF_ALLOC;
+	is->is_size = _NOTE_HEADER_SIZE + roundup(_digest_size(ld), 4);
+	is->is_align = 4;
+	is->is_entsize = 0;
+	is->is_refed = 1;
+}
+
+/*
+ * Write the note into the internal section buffer.  The hashed styles
+ * leave the build ID zero, to be filled in by ld_build_id_compute()
+ * once the output file has been written out.
+ */
+void
+ld_build_id_finalize(struct ld *ld)
+{
+	struct ld_input_section *is;
+	struct ld_output *lo;
+	uint8_t *p;
+	size_t sz;
+
+	lo = ld->ld_output;
+	assert(lo != NULL);
+
+	is = ld_input_find_internal_section(ld, _BUILD_ID_NAME);
+	assert(is != NULL);
+	if (is->is_discard || is->is_output == NULL)
+		return;
+
+	p = is->is_ibuf;
+	assert(p != NULL);
+	sz = _digest_size(ld);
+
+	WRITE_32(p, 4);
+	WRITE_32(p + 4, sz);
+	WRITE_32(p + 8, NT_GNU_BUILD_ID);
+	memcpy(p + 12, "GNU", 4);
+	p += _NOTE_HEADER_SIZE;
+	memset(p, 0, roundup(sz, 4));
+
+	switch (ld->ld_build_id) {
+	case LD_BUILD_ID_HEX:
+		memcpy(p, ld->ld_build_id_hex, sz);
+		break;
+	case LD_BUILD_ID_UUID:
+		_random_uuid(ld, p);
+		break;
+	default:
+		break;
+	}
+}
+
+void
+ld_build_id_compute(struct ld *ld)
+{
+	struct ld_build_id_hash *bh;
+	struct ld_input_section *is;
+	struct ld_output *lo;
+	struct stat sb;
+	pthread_t *tid;
+	uint8_t *image, *digest;
+	size_t i, n, nchunk, sz;
+	int error;
+
+	if (ld->ld_build_id != LD_BUILD_ID_FAST &&
+	    ld->ld_build_id != LD_BUILD_ID_MD5 &&
+	    ld->ld_build_id != LD_BUILD_ID_SHA1)
+		return;
+
+	lo = ld->ld_output;
+	assert(lo != NULL);
+
+	is = ld_input_find_internal_section(ld, _BUILD_ID_NAME);
+	assert(is != NULL);
+	if (is->is_discard || is->is_output == NULL)
+		return;
+
+	if (fstat(lo->lo_fd, &sb) < 0)
+		ld_fatal_std(ld, "fstat");
+	assert(sb.st_size > 0);
+
+	if ((image = mmap(NULL, (size_t) sb.st_size, PROT_READ | PROT_WRITE,
+	    MAP_SHARED, lo->lo_fd, (off_t) 0)) == MAP_FAILED)
+		ld_fatal_std(ld, "mmap");
+
+	sz = _digest_size(ld);
+	nchunk = ((size_t) sb.st_size + _BUILD_ID_CHUNK - 1) / _BUILD_ID_CHUNK;
+	if ((digest = calloc(nchunk, sz)) == NULL)
+		ld_fatal_std(ld, "calloc");
+
+	/*
+	 * Thread i hashes chunks i, i + n, i + 2n, ..., so that the
+	 * threads work on nearby parts of the file at the same time.
+	 */
+	n = MIN(ld->ld_threads, nchunk);
+	if ((bh = calloc(n, sizeof(*bh))) == NULL ||
+	    (tid = calloc(n, sizeof(*tid))) == NULL)
+		ld_fatal_std(ld, "calloc");
+	for (i = 0; i < n; i++) {
+		bh[i].bh_style = ld->ld_build_id;
+		bh[i].bh_image = image;
+		bh[i].bh_size = sb.st_size;
+		bh[i].bh_nchunk = nchunk;
+		bh[i].bh_digest = digest;
+		bh[i].bh_digest_size = sz;
+		bh[i].bh_first = i;
+		bh[i].bh_stride = n;
+	}
+
+	/* This thread hashes the first share of the chunks. */
+	for (i = 1; i < n; i++) {
+		if ((error = pthread_create(&tid[i], NULL, _hash_chunks,
+		    &bh[i])) != 0) {
+			errno = error;
+			ld_fatal_std(ld, "pthread_create");
+		}
+	}
+	(void) _hash_chunks(&bh[0]);
+	for (i = 1; i < n; i++)
+		(void) pthread_join(tid[i], NULL);
+
+	_digest(ld->ld_build_id, digest, nchunk * sz, image +
+	    is->is_output->os_off + is->is_reloff + _NOTE_HEADER_SIZE);
+
+	if (munmap(image, (size_t) sb.st_size) < 0)
+		ld_fatal_std(ld, "munmap");
+
+	free(tid);
+	free(bh);
+	free(digest);
+}
+
+static void *
+_hash_chunks(void *arg)
+{
+	struct ld_build_id_hash *bh;
+	size_t i, off;
+
+	bh = arg;
+	for (i = bh->bh_first; i < bh->bh_nchunk; i += bh->bh_stride) {
+		off = i * _BUILD_ID_CHUNK;
+		_digest(bh->bh_style, bh->bh_image + off,
+		    MIN(_BUILD_ID_CHUNK, bh->bh_size - off),
+		    bh->bh_digest + i * bh->bh_digest_size);
+	}
+
+	return (NULL);
+}
+
+static size_t
+_digest_size(struct ld *ld)
+{
+
+	switch (ld->ld_build_id) {
+	case LD_BUILD_ID_FAST:
+		return (8);
+	case LD_BUILD_ID_MD5:
+	case LD_BUILD_ID_UUID:
+		return (16);
+	case LD_BUILD_ID_SHA1:
+		return (20);
+	case LD_BUILD_ID_HEX:
+		return (ld->ld_build_id_hexsz);
+	default:
+		assert(0);
+		return (0);
+	}
+}
+
+static void
+_digest(int style, const uint8_t *p, size_t len, uint8_t *out)
+{
+	uint32_t h[5];
+	int i;
+
+	switch (style) {
+	case LD_BUILD_ID_FAST:
+		WRITE_64LE(out, ld_hash_xxh64(p, len));
+		break;
+	case LD_BUILD_ID_MD5:
+		h[0] = 0x67452301;
+		h[1] = 0xefcdab89;
+		h[2] = 0x98badcfe;
+		h[3] = 0x10325476;
+		_md_pad(h, _md5_block, p, len, 0);
+		for (i = 0; i < 4; i++)
+			WRITE_32LE(out + i * 4, h[i]);
+		break;
+	case LD_BUILD_ID_SHA1:
+		h[0] = 0x67452301;
+		h[1] = 0xefcdab89;
+		h[2] = 0x98badcfe;
+		h[3] = 0x10325476;
+		h[4] = 0xc3d2e1f0;
+		_md_pad(h, _sha1_block, p, len, 1);
+		for (i = 0; i < 5; i++)
+			WRITE_32BE(out + i * 4, h[i]);
+		break;
+	default:
+		assert(0);
+		break;
+	}
+}
+
+/*
+ * Feed `len' bytes at `p' followed by the Merkle-Damgard padding
+ * shared by MD5 and SHA-1 into the 64-byte block function `block'.
+ */
+static void
+_md_pad(uint32_t *h, void (*block)(uint32_t *, const uint8_t *),
+    const uint8_t *p, size_t len, int big_endian)
+{
+	uint8_t tail[128];
+	uint64_t bits;
+	size_t n, tsz;
+
+	for (n = len; n >= 64; n -= 64, p += 64)
+		block(h, p);
+
+	memset(tail, 0, sizeof(tail));
+	memcpy(tail, p, n);
+	tail[n] = 0x80;
+	tsz = n < 56 ? 64 : 128;
+	bits = (uint64_t) len * 8;
+	if (big_endian)
+		WRITE_64BE(tail + tsz - 8, bits);
+	else
+		WRITE_64LE(tail + tsz - 8, bits);
+
+	block(h, tail);
+	if (tsz == 128)
+		block(h, tail + 64);
+}
+
+static void
+_md5_block(uint32_t *h, const uint8_t *p)
+{
+	static const uint32_t k[64] = {
+		0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+		0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+		0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+		0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+		0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+		0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+		0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+		0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+		0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+		0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+		0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+		0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+		0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+		0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+		0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+		0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+	};
+	static const uint8_t r[16] = {
+		7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21,
+	};
+	uint32_t a, b, c, d, f, t, w[16];
+	int g, i;
+
+	for (i = 0; i < 16; i++)
+		READ_32LE(p + i * 4, w[i]);
+
+	a = h[0];
+	b = h[1];
+	c = h[2];
+	d = h[3];
+	for (i = 0; i < 64; i++) {
+		if (i < 16) {
+			f = (b & c) | (~b & d);
+			g = i;
+		} else if (i < 32) {
+			f = (d & b) | (~d & c);
+			g = (5 * i + 1) % 16;
+		} else if (i < 48) {
+			f = b ^ c ^ d;
+			g = (3 * i + 5) % 16;
+		} else {
+			f = c ^ (b | ~d);
+			g = (7 * i) % 16;
+		}
+		t = a + f + k[i] + w[g];
+		a = d;
+		d = c;
+		c = b;
+		b += _ROTL32(t, r[(i / 16) * 4 + i % 4]);
+	}
+	h[0] += a;
+	h[1] += b;
+	h[2] += c;
+	h[3] += d;
+}
+
+static void
+_sha1_block(uint32_t *h, const uint8_t *p)
+{
+	uint32_t a, b, c, d, e, t, w[80];
+	int i;
+
+	for (i = 0; i < 16; i++)
+		READ_32BE(p + i * 4, w[i]);
+	for (; i < 80; i++) {
+		t = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+		w[i] = _ROTL32(t, 1);
+	}
+
+	a = h[0];
+	b = h[1];
+	c = h[2];
+	d = h[3];
+	e = h[4];
+#define	_SHA1_STEP(F,K)						\
+	do {							\
+		t = _ROTL32(a, 5) + (F) + e + (K) + w[i];	\
+		e = d;						\
+		d = c;						\
+		c = _ROTL32(b, 30);				\
+		b = a;						\
+		a = t;						\
+	} while (0)
+
+	for (i = 0; i < 20; i++)
+		_SHA1_STEP((b & c) | (~b & d), 0x5a827999);
+	for (; i < 40; i++)
+		_SHA1_STEP(b ^ c ^ d, 0x6ed9eba1);
+	for (; i < 60; i++)
+		_SHA1_STEP((b & c) | (b & d) | (c & d), 0x8f1bbcdc);
+	for (; i < 80; i++)
+		_SHA1_STEP(b ^ c ^ d, 0xca62c1d6);
+
+#undef	_SHA1_STEP
+
+	h[0] += a;
+	h[1] += b;
+	h[2] += c;
+	h[3] += d;
+	h[4] += e;
+}
+
+static void
+_random_uuid(struct ld *ld, uint8_t *p)
+{
+	int fd;
+
+	if ((fd = open("/dev/urandom", O_RDONLY)) < 0)
+		ld_fatal_std(ld, "open /dev/urandom");
+	if (read(fd, p, 16) != 16)
+		ld_fatal_std(ld, "read /dev/urandom");
+	(void) close(fd);
+
+	/* Mark it as a version 4 (random) UUID. */
+	p[6] = (p[6] & 0x0f) | 0x40;
+	p[8] = (p[8] & 0x3f) | 0x80;
+}
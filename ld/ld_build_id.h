@@ -0,0 +1,40 @@
+/*-
+ * Copyright (c) 2026 The Elftoolchain Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+
+#define	LD_BUILD_ID_NONE	0	/* no build ID */
+#define	LD_BUILD_ID_FAST	1	/* 64-bit tree hash of the output */
+#define	LD_BUILD_ID_MD5		2	/* MD5 tree hash of the output */
+#define	LD_BUILD_ID_SHA1	3	/* SHA-1 tree hash of the output */
+#define	LD_BUILD_ID_UUID	4	/* random UUID */
+#define	LD_BUILD_ID_HEX		5	/* given on the command line */
+
+void	ld_build_id_compute(struct ld *);
+void	ld_build_id_create(struct ld *);
+void	ld_build_id_finalize(struct ld *);
+void	ld_build_id_set_style(struct ld *, const char *);
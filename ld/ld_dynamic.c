@@ -73,8 +73,14 @@ ld_dynamic_create(struct ld *ld)
 	/* Create .dynsym and .dynstr sections. */
 	_create_dynsym_and_dynstr_section(ld, lo);
 
-	/* Create .hash section. */
-	ld_hash_create_svr4_hash_section(ld);
+	/*
+	 * Create .gnu.hash and/or .hash sections.  The .gnu.hash section
+	 * is created first since it reorders the dynamic symbols.
+	 */
+	if (ld->ld_hash_style & LD_HASH_STYLE_GNU)
+		ld_hash_create_gnu_hash_section(ld);
+	if (ld->ld_hash_style & LD_HASH_STYLE_SYSV)
+		ld_hash_create_svr4_hash_section(ld);
 
 	/*
 	 * Create .gnu.version_d section if the linker creats a shared
@@ -319,6 +325,10 @@ _create_dynamic(struct ld *ld, struct ld_output *lo)
 	if (ld->ld_dynsym)
 		entries += 5;
 
+	/* DT_GNU_HASH */
+	if (ld->ld_hash_style & LD_HASH_STYLE_GNU)
+		entries++;
+
 	/* DT_RPATH. */
 	if (!STAILQ_EMPTY(&ld->ld_state.ls_rplist)) {
 		rpath = ld_path_join_rpath(ld);
@@ -341,6 +351,10 @@ _create_dynamic(struct ld *ld, struct ld_output *lo)
 	/* DT_REL/DT_RELA, DT_RELSZ/DT_RELASZ and DT_RELENT/DT_RELAENT */
 	entries += 3;
 
+	/* DT_RELR, DT_RELRSZ and DT_RELRENT. */
+	if (lo->lo_relr_dyn != NULL)
+		entries += 3;
+
 	/*
 	 * DT_VERNEED, DT_VERNEEDNUM, DT_VERDEF, DT_VERDEFNUM and DT_VERSYM.
 	 */
@@ -455,11 +469,15 @@ _finalize_dynamic(struct ld *ld, struct ld_output *lo)
 	if (lo->lo_hash != NULL)
 		DT_ENTRY_PTR(DT_HASH, lo->lo_hash->os_addr);
 
+	/* DT_GNU_HASH */
+	if (lo->lo_gnu_hash != NULL)
+		DT_ENTRY_PTR(DT_GNU_HASH, lo->lo_gnu_hash->os_addr);
+
 	/* DT_HASH, DT_STRTAB, DT_SYMTAB, DT_STRSZ and DT_SYMENT */
 	if (lo->lo_dynsym != NULL && lo->lo_dynstr != NULL) {
 		DT_ENTRY_PTR(DT_STRTAB, lo->lo_dynstr->os_addr);
 		DT_ENTRY_PTR(DT_SYMTAB, lo->lo_dynsym->os_addr);
-		DT_ENTRY_VAL(DT_STRSZ, ld_strtab_getsize(ld->ld_dynstr));
+		DT_ENTRY_VAL(DT_STRSZ, ld_strtab_getsize(ld, ld->ld_dynstr));
 		DT_ENTRY_VAL(DT_SYMENT,
 		    lo->lo_ec == ELFCLASS32 ? sizeof(Elf32_Sym) :
 		    sizeof(Elf64_Sym));
@@ -496,6 +514,14 @@ _finalize_dynamic(struct ld *ld, struct ld_output *lo)
 		}
 	}
 
+	/* DT_RELR, DT_RELRSZ and DT_RELRENT. */
+	if (lo->lo_relr_dyn != NULL) {
+		DT_ENTRY_PTR(DT_RELR, lo->lo_relr_dyn->os_addr);
+		DT_ENTRY_VAL(DT_RELRSZ, lo->lo_relr_dyn->os_size);
+		DT_ENTRY_VAL(DT_RELRENT, lo->lo_ec == ELFCLASS32 ?
+		    sizeof(Elf32_Relr) : sizeof(Elf64_Relr));
+	}
+
 	/*
 	 * DT_VERNEED, DT_VERNEEDNUM, DT_VERDEF, DT_VERDEFNUM and
 	 * DT_VERSYM.
@@ -30,6 +30,7 @@
 #include "ld_input.h"
 #include "ld_output.h"
 #include "ld_reloc.h"
+#include "ld_symbols.h"
 #include "ld_utils.h"
 
 ELFTC_VCSID("$Id$");
@@ -154,6 +155,102 @@ ld_ehframe_adjust(struct ld *ld, struct ld_input_section *is)
 	is->is_ehframe = NULL;
 }
 
+/*
+ * Remove the FDE's describing code of discarded sections from an input
+ * .eh_frame section, e.g. after sections were folded by ICF, together
+ * with their relocation entries.
+ */
+void
+ld_ehframe_prune(struct ld *ld, struct ld_input_section *is)
+{
+	struct ld_output *lo;
+	struct ld_input_section *ris, *sis;
+	struct ld_reloc_entry *lre;
+	struct ld_symbol *lsb;
+	uint8_t *p;
+	uint64_t length, es, off, pcbegin, adjust, i, j, k;
+	uint32_t cie_id;
+	int discard;
+
+	lo = ld->ld_output;
+	assert(lo != NULL);
+
+	if ((ris = is->is_ris) == NULL || ris->is_reloc == NULL ||
+	    is->is_ibuf == NULL || is->is_discard)
+		return;
+	assert(is->is_ehframe == NULL && is->is_shrink == 0);
+
+	adjust = 0;
+	for (off = i = j = 0; off < is->is_size; off += es) {
+		p = (uint8_t *) is->is_ibuf + off;
+
+		/* Read CIE/FDE length field. */
+		READ_32(p, length);
+		p += 4;
+		es = length + 4;
+		if (length == 0xffffffff) {
+			READ_64(p, length);
+			p += 8;
+			es = length + 12;
+		}
+
+		/* Check for terminator */
+		if (length == 0)
+			break;
+
+		/*
+		 * The FDE is discarded if its initial location refers to
+		 * a discarded section.
+		 */
+		READ_32(p, cie_id);
+		discard = 0;
+		if (cie_id != 0) {
+			pcbegin = p - (uint8_t *) is->is_ibuf + 4;
+			for (k = i; k < ris->is_num_reloc &&
+			    ris->is_reloc[k].lre_offset < off + es; k++) {
+				lre = &ris->is_reloc[k];
+				if (lre->lre_offset != pcbegin)
+					continue;
+				if ((lsb = lre->lre_sym) != NULL &&
+				    (sis = lsb->lsb_is) != NULL &&
+				    sis->is_discard)
+					discard = 1;
+				break;
+			}
+		}
+		if (discard) {
+			/* Mark it for ld_ehframe_adjust(). */
+			WRITE_32(p, 0xFFFFFFFF);
+			is->is_shrink += es;
+		}
+
+		/* Remove or move the relocation entries of this entry. */
+		for (; i < ris->is_num_reloc &&
+		    ris->is_reloc[i].lre_offset < off + es; i++) {
+			lre = &ris->is_reloc[i];
+			if (discard) {
+				ris->is_size -= ld->ld_arch->reloc_entsize;
+				continue;
+			}
+			lre->lre_offset -= adjust;
+			ris->is_reloc[j++] = *lre;
+		}
+		if (discard)
+			adjust += es;
+	}
+	if (is->is_shrink == 0)
+		return;
+	for (; i < ris->is_num_reloc; i++) {
+		lre = &ris->is_reloc[i];
+		lre->lre_offset -= adjust;
+		ris->is_reloc[j++] = *lre;
+	}
+	ris->is_num_reloc = j;
+
+	is->is_ehframe = is->is_ibuf;
+	ld_ehframe_adjust(ld, is);
+}
+
 void
 ld_ehframe_scan(struct ld *ld)
 {
@@ -403,12 +500,15 @@ _process_ehframe_section(struct ld *ld, struct ld_output *lo,
     struct ld_input_section *is)
 {
 	struct ld_input *li;
+	struct ld_input_section *ris;
 	struct ld_output_section *os;
 	struct ld_ehframe_cie *cie, *_cie;
 	struct ld_ehframe_cie_head cie_h;
 	struct ld_ehframe_fde *fde;
-	struct ld_reloc_entry *lre, *_lre;
+	struct ld_reloc_entry *lre;
 	uint64_t length, es, off, off_orig, remain, shrink, auglen;
+	uint64_t i, j;
+	int discard;
 	uint32_t cie_id, cie_pointer, length_size;
 	uint8_t *p, *et, cie_version, *augment;
 
@@ -590,8 +690,10 @@ _process_ehframe_section(struct ld *ld, struct ld_output *lo,
 	 * section content.
 	 */
 	if (shrink > 0 && is->is_ris != NULL && is->is_ris->is_reloc != NULL) {
-		STAILQ_FOREACH_SAFE(lre, is->is_ris->is_reloc, lre_next,
-		    _lre) {
+		ris = is->is_ris;
+		for (i = j = 0; i < ris->is_num_reloc; i++) {
+			lre = &ris->is_reloc[i];
+			discard = 0;
 			STAILQ_FOREACH(cie, &cie_h, cie_next) {
 				if (cie->cie_off_orig > lre->lre_offset)
 					break;
@@ -604,21 +706,22 @@ _process_ehframe_section(struct ld *ld, struct ld_output *lo,
 				 */
 				if (lre->lre_offset <
 				    cie->cie_off_orig + cie->cie_size) {
-					STAILQ_REMOVE(is->is_ris->is_reloc,
-					    lre, ld_reloc_entry, lre_next);
-					is->is_ris->is_num_reloc--;
-					is->is_ris->is_size -= 
+					ris->is_size -=
 					    ld->ld_arch->reloc_entsize;
 					if (os->os_r != NULL)
 						os->os_r->os_size -=
 						    ld->ld_arch->reloc_entsize;
+					discard = 1;
 					break;
 				}
 
 				/* Adjust relocation offset for FDE entries. */
 				lre->lre_offset -= cie->cie_size;
 			}
+			if (!discard)
+				ris->is_reloc[j++] = *lre;
 		}
+		ris->is_num_reloc = j;
 	}
 
 	/* Insert newly found non-duplicate CIE's to the global CIE list. */
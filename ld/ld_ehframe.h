@@ -27,6 +27,7 @@
  */
 
 void	ld_ehframe_adjust(struct ld *, struct ld_input_section *);
+void	ld_ehframe_prune(struct ld *, struct ld_input_section *);
 void	ld_ehframe_scan(struct ld *);
 void	ld_ehframe_create_hdr(struct ld *);
 void	ld_ehframe_finalize_hdr(struct ld *);
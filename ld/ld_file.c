@@ -37,15 +37,21 @@ ELFTC_VCSID("$Id$");
 
 static void _add_file(struct ld *ld, const char *name, enum ld_file_type type,
     int first, struct ld_file *after);
+static void _evict_files(struct ld *ld);
+static struct ld_file_cache *_file_cache(struct ld *ld);
+static void _map_file(struct ld *ld, struct ld_file *lf);
+static void _unmap_file(struct ld *ld, struct ld_file *lf);
 
 void
 ld_file_cleanup(struct ld *ld)
 {
 	struct ld_file *lf, *_lf;
 	struct ld_archive_member *lam, *_lam;
+	struct ld_archive_symbol *las, *_las;
 
 	TAILQ_FOREACH_SAFE(lf, &ld->ld_lflist, lf_next, _lf) {
 		TAILQ_REMOVE(&ld->ld_lflist, lf, lf_next);
+		_unmap_file(ld, lf);
 		free(lf->lf_name);
 		if (lf->lf_ar != NULL) {
 			HASH_ITER(hh, lf->lf_ar->la_m, lam, _lam) {
@@ -53,10 +59,19 @@ ld_file_cleanup(struct ld *ld)
 				free(lam->lam_name);
 				free(lam);
 			}
+			HASH_ITER(hh, lf->lf_ar->la_s, las, _las) {
+				HASH_DEL(lf->lf_ar->la_s, las);
+				free(las->las_name);
+				free(las);
+			}
+			free(lf->lf_ar->la_pending);
 			free(lf->lf_ar);
 		}
 		free(lf);
 	}
+
+	free(ld->ld_fc);
+	ld->ld_fc = NULL;
 }
 
 void
@@ -81,21 +96,116 @@ ld_file_add_after(struct ld *ld, const char *name, enum ld_file_type type,
 	_add_file(ld, name, type, 0, after);
 }
 
+/*
+ * Load an input file. The file is mapped and its ELF descriptor
+ * created unless it is still in the file cache. Each load must be
+ * paired with a call to ld_file_unload().
+ */
 void
 ld_file_load(struct ld *ld, struct ld_file *lf)
+{
+	struct ld_file_cache *fc;
+
+	fc = _file_cache(ld);
+
+	if (lf->lf_mmap != NULL) {
+		fc->fc_hit++;
+		TAILQ_REMOVE(&fc->fc_lru, lf, lf_lru);
+	} else {
+		fc->fc_miss++;
+		_map_file(ld, lf);
+		fc->fc_size += lf->lf_size;
+		if (fc->fc_size > fc->fc_peak)
+			fc->fc_peak = fc->fc_size;
+	}
+	TAILQ_INSERT_HEAD(&fc->fc_lru, lf, lf_lru);
+	lf->lf_ref++;
+
+	_evict_files(ld);
+}
+
+/*
+ * Release an input file. It stays mapped until it has to make room
+ * for other files.
+ */
+void
+ld_file_unload(struct ld *ld, struct ld_file *lf)
+{
+
+	assert(lf->lf_mmap != NULL && lf->lf_ref > 0);
+	lf->lf_ref--;
+
+	_evict_files(ld);
+}
+
+void
+ld_file_print_stats(struct ld *ld)
+{
+	struct ld_file_cache *fc;
+	uint64_t n;
+
+	fc = _file_cache(ld);
+
+	n = fc->fc_hit + fc->fc_miss;
+	fprintf(stderr, "%s: input file cache: %ju loads, %ju hits (%ju%%), "
+	    "%ju evictions, %ju bytes mapped at peak\n", ld->ld_progname,
+	    (uintmax_t) n, (uintmax_t) fc->fc_hit,
+	    (uintmax_t) (n > 0 ? fc->fc_hit * 100 / n : 0),
+	    (uintmax_t) fc->fc_evict, (uintmax_t) fc->fc_peak);
+
+	n = fc->fc_mhit + fc->fc_mmiss;
+	fprintf(stderr, "%s: archive member cache: %ju loads, %ju hits "
+	    "(%ju%%)\n", ld->ld_progname, (uintmax_t) n,
+	    (uintmax_t) fc->fc_mhit,
+	    (uintmax_t) (n > 0 ? fc->fc_mhit * 100 / n : 0));
+}
+
+static struct ld_file_cache *
+_file_cache(struct ld *ld)
+{
+	struct ld_file_cache *fc;
+
+	if ((fc = ld->ld_fc) == NULL) {
+		if ((fc = calloc(1, sizeof(*fc))) == NULL)
+			ld_fatal_std(ld, "calloc");
+		TAILQ_INIT(&fc->fc_lru);
+		ld->ld_fc = fc;
+	}
+
+	return (fc);
+}
+
+static void
+_evict_files(struct ld *ld)
+{
+	struct ld_file_cache *fc;
+	struct ld_file *lf, *_lf;
+
+	fc = ld->ld_fc;
+
+	/* Files that are loaded can not be unmapped. */
+	lf = TAILQ_LAST(&fc->fc_lru, ld_file_lru);
+	while (lf != NULL && fc->fc_size > ld->ld_file_cache_size) {
+		_lf = TAILQ_PREV(lf, ld_file_lru, lf_lru);
+		if (lf->lf_ref == 0) {
+			_unmap_file(ld, lf);
+			fc->fc_evict++;
+		}
+		lf = _lf;
+	}
+}
+
+static void
+_map_file(struct ld *ld, struct ld_file *lf)
 {
 	struct ld_archive *la;
-	struct ld_state *ls;
 	struct stat sb;
 	Elf_Kind k;
 	GElf_Ehdr ehdr;
 	int fd;
 
 	assert(lf != NULL && lf->lf_name != NULL);
-
-	ls = &ld->ld_state;
-	if (ls->ls_file == lf)
-		return;
+	assert(lf->lf_mmap == NULL);
 
 	if ((fd = open(lf->lf_name, O_RDONLY)) < 0)
 		ld_fatal_std(ld, "%s: open", lf->lf_name);
@@ -105,9 +215,15 @@ ld_file_load(struct ld *ld, struct ld_file *lf)
 	if (sb.st_size == 0)
 		ld_fatal(ld, "%s: File truncated", lf->lf_name);
 
+	/*
+	 * The file is mapped writable but private, so that relocations
+	 * can be applied to the input section contents in place without
+	 * the changes reaching the file.  Pages are only copied when
+	 * they are written to.
+	 */
 	lf->lf_size = sb.st_size;
-	if ((lf->lf_mmap = mmap(NULL, lf->lf_size, PROT_READ, MAP_PRIVATE, fd,
-	    (off_t) 0)) == MAP_FAILED)
+	if ((lf->lf_mmap = mmap(NULL, lf->lf_size, PROT_READ | PROT_WRITE,
+	    MAP_PRIVATE, fd, (off_t) 0)) == MAP_FAILED)
 		ld_fatal_std(ld, "%s: mmap", lf->lf_name);
 	close(fd);
 
@@ -159,23 +275,38 @@ ld_file_load(struct ld *ld, struct ld_file *lf)
 	ld_arch_verify(ld, lf->lf_name, ehdr.e_machine);
 }
 
-void
-ld_file_unload(struct ld *ld, struct ld_file *lf)
+static void
+_unmap_file(struct ld *ld, struct ld_file *lf)
 {
-	struct ld_state *ls;
+	struct ld_archive_member *lam, *_lam;
+	struct ld_file_cache *fc;
 
-	ls = &ld->ld_state;
+	if (lf->lf_mmap == NULL)
+		return;
 
-	if (lf->lf_type != LFT_BINARY)
-		elf_end(lf->lf_elf);
+	assert(lf->lf_ref == 0);
 
-	if (lf->lf_mmap != NULL) {
-		if (munmap(lf->lf_mmap, lf->lf_size) < 0)
-			ld_fatal_std(ld, "%s: munmap", lf->lf_name);
+	if (lf->lf_type != LFT_BINARY) {
+		/* Member descriptors refer to the archive descriptor. */
+		if (lf->lf_ar != NULL) {
+			HASH_ITER(hh, lf->lf_ar->la_m, lam, _lam) {
+				if (lam->lam_elf != NULL) {
+					elf_end(lam->lam_elf);
+					lam->lam_elf = NULL;
+				}
+			}
+		}
+		elf_end(lf->lf_elf);
+		lf->lf_elf = NULL;
 	}
 
-	if (ls->ls_file == lf)
-		ls->ls_file = NULL;
+	if (munmap(lf->lf_mmap, lf->lf_size) < 0)
+		ld_fatal_std(ld, "%s: munmap", lf->lf_name);
+	lf->lf_mmap = NULL;
+
+	fc = ld->ld_fc;
+	TAILQ_REMOVE(&fc->fc_lru, lf, lf_lru);
+	fc->fc_size -= lf->lf_size;
 }
 
 static void
@@ -38,12 +38,23 @@ struct ld_archive_member {
 	char *lam_ar_name;		/* archive name */
 	char *lam_name;			/* archive member name */
 	off_t lam_off;			/* archive member offset */
+	Elf *lam_elf;			/* cached member ELF descriptor */
 	struct ld_input *lam_input;	/* input object */
 	UT_hash_handle hh;		/* hash handle */
 };
 
+struct ld_archive_symbol {
+	char *las_name;			/* symbol name */
+	off_t las_off;			/* defining archive member offset */
+	size_t las_idx;			/* archive symbol table entry */
+	UT_hash_handle hh;		/* hash handle */
+};
+
 struct ld_archive {
 	struct ld_archive_member *la_m;	/* extracted member list. */
+	struct ld_archive_symbol *la_s;	/* archive symbol table index */
+	uint64_t *la_pending;		/* symbol table entries to visit */
+	unsigned char la_indexed;	/* la_s was built */
 };
 
 struct ld_file {
@@ -58,7 +69,28 @@ struct ld_file {
 	unsigned lf_as_needed;		/* DT_NEEDED */
 	unsigned lf_group_level;	/* archive group level */
 	unsigned lf_search_dir;		/* search library directories */
+	unsigned lf_ref;		/* number of active loads */
 	TAILQ_ENTRY(ld_file) lf_next;	/* next input file */
+	TAILQ_ENTRY(ld_file) lf_lru;	/* next file in the cache */
+};
+
+/*
+ * Input files stay mapped after they are unloaded, so that the passes
+ * over the input objects do not map and parse the same files again.
+ * Files that are not loaded are unmapped, least recently used first,
+ * once the mapped size exceeds the budget.
+ */
+#define	LD_FILE_CACHE_SIZE	(1024UL * 1024 * 1024) /* default budget */
+
+struct ld_file_cache {
+	TAILQ_HEAD(ld_file_lru, ld_file) fc_lru; /* mapped files, newest first */
+	uint64_t fc_size;		/* mapped size */
+	uint64_t fc_peak;		/* peak mapped size */
+	uint64_t fc_hit;		/* loads of mapped files */
+	uint64_t fc_miss;		/* loads that mapped a file */
+	uint64_t fc_evict;		/* files unmapped for the budget */
+	uint64_t fc_mhit;		/* loads of parsed archive members */
+	uint64_t fc_mmiss;		/* loads that parsed a member */
 };
 
 void	ld_file_add(struct ld *, const char *, enum ld_file_type);
@@ -67,4 +99,5 @@ void	ld_file_add_after(struct ld *, const char *, enum ld_file_type,
     struct ld_file *);
 void	ld_file_cleanup(struct ld *);
 void	ld_file_load(struct ld *, struct ld_file *);
+void	ld_file_print_stats(struct ld *);
 void	ld_file_unload(struct ld *, struct ld_file *);
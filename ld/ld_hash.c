@@ -29,6 +29,7 @@
 #include "ld_layout.h"
 #include "ld_output.h"
 #include "ld_symbols.h"
+#include "ld_utils.h"
 
 ELFTC_VCSID("$Id$");
 
@@ -45,6 +46,43 @@ static unsigned hash_buckets[] = {
 	16411, 32771, 65537, 131101, 262147
 };
 
+static uint32_t	_hash_buckets(uint32_t nsyms);
+static int	_cmp_gnu_hash_entry(const void *a, const void *b);
+static uint32_t	_gnu_hash(const char *name);
+static int	_gnu_hash_symbol(struct ld_symbol *lsb);
+
+#define	_ROTL64(X,N)	(((X) << (N)) | ((X) >> (64 - (N))))
+
+#define	_XXH_P1		0x9e3779b185ebca87ULL
+#define	_XXH_P2		0xc2b2ae3d27d4eb4fULL
+#define	_XXH_P3		0x165667b19e3779f9ULL
+#define	_XXH_P4		0x85ebca77c2b2ae63ULL
+#define	_XXH_P5		0x27d4eb2f165667c5ULL
+
+#define	_XXH_ROUND(A,V)					\
+	do {						\
+		(A) += (V) * _XXH_P2;			\
+		(A) = _ROTL64((A), 31) * _XXH_P1;	\
+	} while (0)
+
+#define	_XXH_MERGE(H,V)					\
+	do {						\
+		uint64_t _v = 0;			\
+		_XXH_ROUND(_v, (V));			\
+		(H) = ((H) ^ _v) * _XXH_P1 + _XXH_P4;	\
+	} while (0)
+
+/*
+ * An entry of the dynamic symbol table, as seen while building the
+ * .gnu.hash section.
+ */
+struct ld_gnu_hash_entry {
+	struct ld_symbol *ghe_lsb;	/* dynamic symbol */
+	uint32_t ghe_hash;		/* GNU hash of the symbol name */
+	uint32_t ghe_bucket;		/* bucket the symbol belongs to */
+	int ghe_hashed;			/* included in the hash table */
+};
+
 void
 ld_hash_create_svr4_hash_section(struct ld *ld)
 {
@@ -78,17 +116,7 @@ ld_hash_create_svr4_hash_section(struct ld *ld)
 	assert(ld->ld_dynsym != NULL && ld->ld_dynsym->sy_size > 0);
 
 	nchains = ld->ld_dynsym->sy_size;
-	nbuckets = 0;
-	for (i = 1;
-	    (size_t) i < sizeof(hash_buckets) / sizeof(hash_buckets[0]);
-	    i++) {
-		if (nchains < hash_buckets[i]) {
-			nbuckets = hash_buckets[i - 1];
-			break;
-		}
-	}
-	if (nbuckets == 0)
-		nbuckets = hash_buckets[i - 1];
+	nbuckets = _hash_buckets(nchains);
 
 	if ((buf = calloc(nbuckets + nchains + 2, sizeof(uint32_t))) == NULL)
 		ld_fatal_std(ld, "calloc");
@@ -124,3 +152,314 @@ ld_hash_create_svr4_hash_section(struct ld *ld)
 	(void) ld_output_create_section_element(ld, os, OET_DATA_BUFFER,
 	    odb, NULL);
 }
+
+/*
+ * Create the .gnu.hash section.
+ *
+ * The section consists of a header, a Bloom filter, a bucket array
+ * and a hash value array.  The dynamic symbols which are looked up
+ * through the section have to occupy the tail of the dynamic symbol
+ * table, grouped by bucket, so the dynamic symbols are reordered here,
+ * before the .hash section, symbol versioning sections and dynamic
+ * relocations refer to the symbol indices.
+ */
+void
+ld_hash_create_gnu_hash_section(struct ld *ld)
+{
+	struct ld_output *lo;
+	struct ld_output_section *os;
+	struct ld_output_data_buffer *odb;
+	struct ld_gnu_hash_entry *ghe;
+	struct ld_symbol *lsb;
+	char hash_name[] = ".gnu.hash";
+	uint64_t *bloom;
+	uint32_t h, maskbitslog2, maskwords, nbuckets, nhashed, shift1, shift2;
+	uint32_t symoffset, w;
+	uint8_t *p;
+	size_t bloomsz;
+	int i, n;
+
+	lo = ld->ld_output;
+	assert(lo != NULL);
+
+	HASH_FIND_STR(lo->lo_ostbl, hash_name, os);
+	if (os == NULL)
+		os = ld_layout_insert_output_section(ld, hash_name, SHF_ALLOC);
+	os->os_type = SHT_GNU_HASH;
+	os->os_flags = SHF_ALLOC;
+	if (lo->lo_ec == ELFCLASS32) {
+		os->os_entsize = 4;
+		os->os_align = 4;
+	} else {
+		os->os_entsize = 0;
+		os->os_align = 8;
+	}
+
+	if ((os->os_link = strdup(".dynsym")) == NULL)
+		ld_fatal_std(ld, "strdup");
+
+	lo->lo_gnu_hash = os;
+
+	assert(ld->ld_dynsym != NULL && ld->ld_dynsym->sy_size > 0);
+	assert(ld->ld_dyn_symbols != NULL);
+
+	/* Compute the hash values of the dynamic symbols. */
+	n = ld->ld_dynsym->sy_size - 1;
+	if ((ghe = calloc(n > 0 ? n : 1, sizeof(*ghe))) == NULL)
+		ld_fatal_std(ld, "calloc");
+
+	i = 0;
+	nhashed = 0;
+	STAILQ_FOREACH(lsb, ld->ld_dyn_symbols, lsb_dyn) {
+		assert(i < n);
+		ghe[i].ghe_lsb = lsb;
+		if (lsb->lsb_name != NULL && _gnu_hash_symbol(lsb)) {
+			ghe[i].ghe_hash = _gnu_hash(lsb->lsb_name);
+			ghe[i].ghe_hashed = 1;
+			nhashed++;
+		}
+		i++;
+	}
+	assert(i == n);
+
+	nbuckets = _hash_buckets(nhashed);
+	for (i = 0; i < n; i++)
+		if (ghe[i].ghe_hashed)
+			ghe[i].ghe_bucket = ghe[i].ghe_hash % nbuckets;
+
+	/*
+	 * Move the symbols that are not looked up to the front of the
+	 * dynamic symbol table, and sort the rest by bucket.
+	 */
+	qsort(ghe, n, sizeof(*ghe), _cmp_gnu_hash_entry);
+
+	STAILQ_INIT(ld->ld_dyn_symbols);
+	for (i = 0; i < n; i++) {
+		ghe[i].ghe_lsb->lsb_dyn_index = i + 1;
+		STAILQ_INSERT_TAIL(ld->ld_dyn_symbols, ghe[i].ghe_lsb,
+		    lsb_dyn);
+	}
+	symoffset = n - nhashed + 1;
+
+	/*
+	 * Size the Bloom filter using the same rules as GNU ld.
+	 */
+	maskbitslog2 = 1;
+	if (nhashed > 1)
+		for (w = nhashed - 1; w != 0; w >>= 1)
+			maskbitslog2++;
+	if (maskbitslog2 < 3)
+		maskbitslog2 = 5;
+	else if ((1U << (maskbitslog2 - 2)) & nhashed)
+		maskbitslog2 += 3;
+	else
+		maskbitslog2 += 2;
+	if (lo->lo_ec == ELFCLASS32)
+		shift1 = 5;
+	else {
+		if (maskbitslog2 == 5)
+			maskbitslog2 = 6;
+		shift1 = 6;
+	}
+	shift2 = maskbitslog2;
+	maskwords = 1U << (maskbitslog2 - shift1);
+
+	/*
+	 * The Bloom filter words are 64 bits wide in ELFCLASS64 objects,
+	 * so the section contents are written out in the byte order of
+	 * the output object instead of being translated by libelf.
+	 */
+	if (lo->lo_ec == ELFCLASS32)
+		bloomsz = maskwords * 4;
+	else
+		bloomsz = maskwords * 8;
+
+	if ((odb = calloc(1, sizeof(*odb))) == NULL)
+		ld_fatal_std(ld, "calloc");
+	odb->odb_size = 16 + bloomsz + (nbuckets + nhashed) * 4;
+	if ((odb->odb_buf = calloc(1, odb->odb_size)) == NULL)
+		ld_fatal_std(ld, "calloc");
+	odb->odb_align = os->os_align;
+	odb->odb_type = ELF_T_BYTE;
+
+	p = odb->odb_buf;
+	WRITE_32(p, nbuckets);
+	WRITE_32(p + 4, symoffset);
+	WRITE_32(p + 8, maskwords);
+	WRITE_32(p + 12, shift2);
+
+	/* Compute the Bloom filter. */
+	if ((bloom = calloc(maskwords, sizeof(*bloom))) == NULL)
+		ld_fatal_std(ld, "calloc");
+	for (i = n - nhashed; i < n; i++) {
+		h = ghe[i].ghe_hash;
+		bloom[(h >> shift1) & (maskwords - 1)] |=
+		    (1ULL << (h & ((1U << shift1) - 1))) |
+		    (1ULL << ((h >> shift2) & ((1U << shift1) - 1)));
+	}
+	p += 16;
+	for (w = 0; w < maskwords; w++) {
+		if (lo->lo_ec == ELFCLASS32) {
+			WRITE_32(p, bloom[w]);
+			p += 4;
+		} else {
+			WRITE_64(p, bloom[w]);
+			p += 8;
+		}
+	}
+	free(bloom);
+
+	/*
+	 * Fill in the buckets and the hash value array.  The lowest bit
+	 * of a hash value is set for the last symbol in its bucket.
+	 */
+	for (i = n - nhashed; i < n; i++) {
+		assert(ghe[i].ghe_hashed);
+		if (i == n - (int) nhashed ||
+		    ghe[i - 1].ghe_bucket != ghe[i].ghe_bucket)
+			WRITE_32(p + ghe[i].ghe_bucket * 4, i + 1);
+	}
+	p += nbuckets * 4;
+	for (i = n - nhashed; i < n; i++) {
+		h = ghe[i].ghe_hash & ~1U;
+		if (i + 1 == n || ghe[i + 1].ghe_bucket != ghe[i].ghe_bucket)
+			h |= 1;
+		WRITE_32(p, h);
+		p += 4;
+	}
+
+	(void) ld_output_create_section_element(ld, os, OET_DATA_BUFFER,
+	    odb, NULL);
+
+	free(ghe);
+}
+
+/*
+ * XXH64 of `len' bytes at `buf', with a zero seed.  This is used
+ * where a fast, well distributed 64-bit hash of bulk data is needed.
+ */
+uint64_t
+ld_hash_xxh64(const void *buf, size_t len)
+{
+	const uint8_t *p, *end;
+	uint64_t h, k, v1, v2, v3, v4, x;
+	uint32_t y;
+
+	p = buf;
+	end = p + len;
+	if (len >= 32) {
+		v1 = _XXH_P1 + _XXH_P2;
+		v2 = _XXH_P2;
+		v3 = 0;
+		v4 = -_XXH_P1;
+		for (; end - p >= 32; p += 32) {
+			READ_64LE(p, x);
+			_XXH_ROUND(v1, x);
+			READ_64LE(p + 8, x);
+			_XXH_ROUND(v2, x);
+			READ_64LE(p + 16, x);
+			_XXH_ROUND(v3, x);
+			READ_64LE(p + 24, x);
+			_XXH_ROUND(v4, x);
+		}
+		h = _ROTL64(v1, 1) + _ROTL64(v2, 7) + _ROTL64(v3, 12) +
+		    _ROTL64(v4, 18);
+		_XXH_MERGE(h, v1);
+		_XXH_MERGE(h, v2);
+		_XXH_MERGE(h, v3);
+		_XXH_MERGE(h, v4);
+	} else
+		h = _XXH_P5;
+
+	h += len;
+	for (; end - p >= 8; p += 8) {
+		READ_64LE(p, x);
+		k = 0;
+		_XXH_ROUND(k, x);
+		h = _ROTL64(h ^ k, 27) * _XXH_P1 + _XXH_P4;
+	}
+	if (end - p >= 4) {
+		READ_32LE(p, y);
+		h ^= (uint64_t) y * _XXH_P1;
+		h = _ROTL64(h, 23) * _XXH_P2 + _XXH_P3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h ^= *p * _XXH_P5;
+		h = _ROTL64(h, 11) * _XXH_P1;
+	}
+
+	h ^= h >> 33;
+	h *= _XXH_P2;
+	h ^= h >> 29;
+	h *= _XXH_P3;
+	h ^= h >> 32;
+
+	return (h);
+}
+
+/*
+ * Return the number of buckets to use for `nsyms' symbols.
+ */
+static uint32_t
+_hash_buckets(uint32_t nsyms)
+{
+	size_t i;
+
+	for (i = 1; i < sizeof(hash_buckets) / sizeof(hash_buckets[0]); i++)
+		if (nsyms < hash_buckets[i])
+			return (hash_buckets[i - 1]);
+
+	return (hash_buckets[i - 1]);
+}
+
+static int
+_cmp_gnu_hash_entry(const void *a, const void *b)
+{
+	const struct ld_gnu_hash_entry *ga, *gb;
+
+	ga = a;
+	gb = b;
+
+	if (ga->ghe_hashed != gb->ghe_hashed)
+		return (ga->ghe_hashed - gb->ghe_hashed);
+
+	if (ga->ghe_hashed && ga->ghe_bucket != gb->ghe_bucket)
+		return (ga->ghe_bucket < gb->ghe_bucket ? -1 : 1);
+
+	/* Otherwise keep the original order. */
+	if (ga->ghe_lsb->lsb_dyn_index < gb->ghe_lsb->lsb_dyn_index)
+		return (-1);
+	else if (ga->ghe_lsb->lsb_dyn_index > gb->ghe_lsb->lsb_dyn_index)
+		return (1);
+
+	return (0);
+}
+
+static uint32_t
+_gnu_hash(const char *name)
+{
+	const unsigned char *p;
+	uint32_t h;
+
+	h = 5381;
+	for (p = (const unsigned char *) name; *p != '\0'; p++)
+		h = (h << 5) + h + *p;
+
+	return (h);
+}
+
+/*
+ * Undefined dynamic symbols are not looked up through the hash table,
+ * except for functions whose canonical address is a PLT entry in the
+ * output object.
+ */
+static int
+_gnu_hash_symbol(struct ld_symbol *lsb)
+{
+
+	if (lsb->lsb_import)
+		return (lsb->lsb_type == STT_FUNC && lsb->lsb_func_addr);
+
+	return (lsb->lsb_shndx != SHN_UNDEF);
+}
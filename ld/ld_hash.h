@@ -26,4 +26,6 @@
  * $Id$
  */
 
+void	ld_hash_create_gnu_hash_section(struct ld *);
 void	ld_hash_create_svr4_hash_section(struct ld *);
+uint64_t ld_hash_xxh64(const void *, size_t);
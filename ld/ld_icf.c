@@ -0,0 +1,499 @@
+/*-
+ * Copyright (c) 2026 The Elftoolchain Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "ld.h"
+#include "ld_arch.h"
+#include "ld_ehframe.h"
+#include "ld_hash.h"
+#include "ld_icf.h"
+#include "ld_input.h"
+#include "ld_reloc.h"
+#include "ld_symbols.h"
+
+ELFTC_VCSID("$Id$");
+
+/*
+ * Identical code folding (-icf).
+ *
+ * Two executable input sections are identical if they have the same
+ * contents and attributes, and if their relocations are the same and
+ * refer to the same targets.  A relocation target in a section which
+ * is itself a folding candidate only has to be in an identical
+ * section, so functions calling each other can be folded together.
+ *
+ * The candidates are split into classes by a hash of their contents
+ * and relocations.  The classes are then refined by a hash of the
+ * classes of their relocation targets, until the number of classes
+ * does not change any more.  The members of each class are finally
+ * compared with the first one, and the ones which turn out to be
+ * different are put in classes of their own, after which the classes
+ * are refined again.  A class is named after its first member in
+ * input order, and all other members are folded into that one.
+ *
+ * With -icf=safe, sections whose address may be used, because they
+ * are referred to by relocations other than branches or define
+ * symbols visible outside the output object, are not folded.
+ */
+
+struct ld_icf_target {
+	size_t it_sec;			/* target candidate index + 1 */
+	const void *it_ptr;		/* target symbol or section */
+	uint64_t it_value;		/* offset of the target */
+};
+
+struct ld_icf_key {
+	size_t k_class;			/* current class */
+	uint64_t k_hash;		/* hash to refine the class with */
+	size_t k_idx;			/* candidate index */
+};
+
+struct ld_icf {
+	struct ld_input_section **ic_is; /* candidate sections */
+	const uint8_t **ic_data;	/* contents of the candidates */
+	struct ld_icf_target **ic_tgt;	/* relocation targets */
+	uint64_t *ic_chash;		/* hash of the constant parts */
+	size_t *ic_class;		/* class of the candidates */
+	struct ld_icf_key *ic_key;	/* buffer for partitioning */
+	size_t ic_num;			/* number of candidates */
+	size_t ic_cap;			/* capacity of the arrays */
+};
+
+static void _add_candidate(struct ld *ld, struct ld_icf *ic,
+    struct ld_input_section *is);
+static int _cmp_key(const void *a, const void *b);
+static int _equal(struct ld_icf *ic, size_t a, size_t b);
+static void _fold(struct ld *ld, struct ld_icf *ic);
+static void _mark_address_taken(struct ld *ld);
+static uint64_t _mix(uint64_t h, uint64_t v);
+static size_t _partition(struct ld_icf *ic, int variable);
+static void _resolve_targets(struct ld *ld, struct ld_icf *ic);
+
+#define	_ICF_RELOC_NUM(is)						\
+	((is)->is_ris != NULL ? (is)->is_ris->is_num_reloc : 0)
+
+void
+ld_icf_fold_sections(struct ld *ld)
+{
+	struct ld_icf ic;
+	struct ld_input *li;
+	struct ld_input_section *is;
+	size_t i, j, n, _n;
+	int split;
+
+	if (ld->ld_reloc)
+		return;
+
+	/* Find the candidate sections. */
+	memset(&ic, 0, sizeof(ic));
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		if (li->li_name == NULL || li->li_type == LIT_DSO)
+			continue;
+		for (j = 0; j < li->li_shnum; j++) {
+			is = &li->li_is[j];
+			if ((is->is_flags & (SHF_ALLOC | SHF_EXECINSTR |
+			    SHF_WRITE)) != (SHF_ALLOC | SHF_EXECINSTR) ||
+			    is->is_type != SHT_PROGBITS || is->is_size == 0 ||
+			    is->is_discard || (ld->ld_gc && !is->is_refed) ||
+			    !strcmp(is->is_name, ".init") ||
+			    !strcmp(is->is_name, ".fini"))
+				continue;
+			is->is_icf = 1;
+		}
+	}
+	if (ld->ld_icf == LD_ICF_SAFE)
+		_mark_address_taken(ld);
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		if (li->li_name == NULL || li->li_type == LIT_DSO)
+			continue;
+		for (j = 0; j < li->li_shnum; j++) {
+			is = &li->li_is[j];
+			if (is->is_icf)
+				_add_candidate(ld, &ic, is);
+		}
+	}
+	if (ic.ic_num < 2)
+		goto done;
+
+	_resolve_targets(ld, &ic);
+
+	if ((ic.ic_class = calloc(ic.ic_num, sizeof(*ic.ic_class))) == NULL ||
+	    (ic.ic_key = malloc(ic.ic_num * sizeof(*ic.ic_key))) == NULL)
+		ld_fatal_std(ld, "malloc");
+
+	n = _partition(&ic, 0);
+	for (;;) {
+		do {
+			_n = n;
+			n = _partition(&ic, 1);
+		} while (n != _n);
+
+		/* Put members which differ from their class in own ones. */
+		split = 0;
+		for (i = 0; i < ic.ic_num; i++) {
+			if (ic.ic_class[i] != i &&
+			    !_equal(&ic, ic.ic_class[i], i)) {
+				ic.ic_class[i] = i;
+				split = 1;
+			}
+		}
+		if (!split)
+			break;
+		n = _partition(&ic, 1);
+	}
+
+	_fold(ld, &ic);
+
+done:
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		if (li->li_file != NULL && li->li_elf != NULL)
+			ld_input_unload(ld, li);
+		for (j = 0; j < li->li_shnum; j++)
+			li->li_is[j].is_icf = 0;
+	}
+	if (ic.ic_tgt != NULL) {
+		for (i = 0; i < ic.ic_num; i++)
+			free(ic.ic_tgt[i]);
+	}
+	free(ic.ic_key);
+	free(ic.ic_class);
+	free(ic.ic_chash);
+	free(ic.ic_tgt);
+	free(ic.ic_data);
+	free(ic.ic_is);
+}
+
+static void
+_add_candidate(struct ld *ld, struct ld_icf *ic, struct ld_input_section *is)
+{
+	struct ld_input *li;
+	const uint8_t *p;
+
+	li = is->is_input;
+	if (li->li_elf == NULL)
+		ld_input_load(ld, li);
+	if ((p = ld_input_get_section_rawdata(ld, is)) == NULL) {
+		is->is_icf = 0;
+		return;
+	}
+
+	if (ic->ic_num == ic->ic_cap) {
+		ic->ic_cap = ic->ic_cap ? ic->ic_cap * 2 : 64;
+		if ((ic->ic_is = realloc(ic->ic_is, ic->ic_cap *
+		    sizeof(*ic->ic_is))) == NULL ||
+		    (ic->ic_data = realloc(ic->ic_data, ic->ic_cap *
+		    sizeof(*ic->ic_data))) == NULL)
+			ld_fatal_std(ld, "realloc");
+	}
+	ic->ic_is[ic->ic_num] = is;
+	ic->ic_data[ic->ic_num] = p;
+	is->is_icf = ++ic->ic_num;
+}
+
+/*
+ * Clear the candidate mark of sections whose address may be used: the
+ * targets of relocations other than branches in allocated sections,
+ * and the sections defining symbols which are visible outside of the
+ * output object.  References from .eh_frame do not count.
+ */
+static void
+_mark_address_taken(struct ld *ld)
+{
+	struct ld_input *li;
+	struct ld_input_section *is;
+	struct ld_reloc_entry *lre;
+	struct ld_symbol *lsb, *_lsb;
+	const uint8_t *buf;
+	uint64_t i, j;
+
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		if (li->li_name == NULL || li->li_type == LIT_DSO)
+			continue;
+		for (i = 0; i < li->li_shnum; i++) {
+			is = &li->li_is[i];
+			if (is->is_reloc == NULL || is->is_tis == NULL ||
+			    (is->is_tis->is_flags & SHF_ALLOC) == 0 ||
+			    !strcmp(is->is_tis->is_name, ".eh_frame"))
+				continue;
+			buf = NULL;
+			if (is->is_tis->is_flags & SHF_EXECINSTR) {
+				if (li->li_elf == NULL)
+					ld_input_load(ld, li);
+				buf = ld_input_get_section_rawdata(ld,
+				    is->is_tis);
+			}
+			for (j = 0; j < is->is_num_reloc; j++) {
+				lre = &is->is_reloc[j];
+				if (lre->lre_sym == NULL ||
+				    ld->ld_arch->is_branch_reloc(lre, buf))
+					continue;
+				lsb = ld_symbols_ref(lre->lre_sym);
+				if (lsb->lsb_is != NULL)
+					lsb->lsb_is->is_icf = 0;
+			}
+		}
+	}
+
+	HASH_ITER(hh, ld->ld_sym, lsb, _lsb) {
+		if (lsb->lsb_is == NULL || lsb->lsb_bind == STB_LOCAL)
+			continue;
+		if (lsb->lsb_ref_dso || ld_symbols_overridden(ld, lsb))
+			lsb->lsb_is->is_icf = 0;
+	}
+}
+
+/*
+ * Record the targets of the relocations of the candidates, and the
+ * hash of everything about the candidates which does not depend on
+ * the classes of other candidates.
+ */
+static void
+_resolve_targets(struct ld *ld, struct ld_icf *ic)
+{
+	struct ld_input_section *is;
+	struct ld_icf_target *it;
+	struct ld_reloc_entry *lre;
+	struct ld_symbol *lsb;
+	uint64_t h, j, nr;
+	size_t i;
+
+	if ((ic->ic_tgt = calloc(ic->ic_num, sizeof(*ic->ic_tgt))) == NULL ||
+	    (ic->ic_chash = malloc(ic->ic_num * sizeof(*ic->ic_chash))) ==
+	    NULL)
+		ld_fatal_std(ld, "malloc");
+
+	for (i = 0; i < ic->ic_num; i++) {
+		is = ic->ic_is[i];
+		nr = _ICF_RELOC_NUM(is);
+		h = ld_hash_xxh64(ic->ic_data[i], is->is_size);
+		h = _mix(h, is->is_size);
+		h = _mix(h, is->is_flags);
+		h = _mix(h, is->is_align);
+		h = _mix(h, nr);
+		if (nr > 0 && (ic->ic_tgt[i] = calloc(nr, sizeof(*it))) ==
+		    NULL)
+			ld_fatal_std(ld, "calloc");
+		for (j = 0; j < nr; j++) {
+			lre = &is->is_ris->is_reloc[j];
+			it = &ic->ic_tgt[i][j];
+			if (lre->lre_sym != NULL) {
+				/*
+				 * Symbols which may be preempted, and symbols
+				 * without a fixed place in an input section,
+				 * are compared by identity; others by their
+				 * location.
+				 */
+				lsb = ld_symbols_ref(lre->lre_sym);
+				if ((lsb->lsb_bind != STB_LOCAL &&
+				    ld_symbols_overridden(ld, lsb)) ||
+				    lsb->lsb_is == NULL ||
+				    lsb->lsb_shndx == SHN_COMMON ||
+				    lsb->lsb_preset_os != NULL ||
+				    ld_symbols_in_dso(lsb))
+					it->it_ptr = lsb;
+				else if (lsb->lsb_is->is_icf) {
+					it->it_sec = lsb->lsb_is->is_icf;
+					it->it_value = lsb->lsb_value;
+				} else {
+					it->it_ptr = lsb->lsb_is;
+					it->it_value = lsb->lsb_value;
+				}
+			}
+			h = _mix(h, lre->lre_type);
+			h = _mix(h, lre->lre_offset);
+			h = _mix(h, lre->lre_addend);
+			h = _mix(h, (uintptr_t) it->it_ptr);
+			h = _mix(h, it->it_value);
+		}
+		ic->ic_chash[i] = h;
+	}
+}
+
+/*
+ * Split the classes by the constant hash, or by the classes of the
+ * relocation targets if `variable' is set.  Returns the number of
+ * classes.
+ */
+static size_t
+_partition(struct ld_icf *ic, int variable)
+{
+	struct ld_icf_key *k;
+	struct ld_icf_target *it;
+	uint64_t h, j, nr;
+	size_t i, n, c;
+
+	for (i = 0; i < ic->ic_num; i++) {
+		k = &ic->ic_key[i];
+		k->k_class = ic->ic_class[i];
+		k->k_idx = i;
+		if (!variable) {
+			k->k_hash = ic->ic_chash[i];
+			continue;
+		}
+		h = 0;
+		nr = _ICF_RELOC_NUM(ic->ic_is[i]);
+		for (j = 0; j < nr; j++) {
+			it = &ic->ic_tgt[i][j];
+			if (it->it_sec != 0)
+				h = _mix(h, ic->ic_class[it->it_sec - 1]);
+		}
+		k->k_hash = h;
+	}
+
+	qsort(ic->ic_key, ic->ic_num, sizeof(*ic->ic_key), _cmp_key);
+
+	n = 0;
+	c = 0;
+	for (i = 0; i < ic->ic_num; i++) {
+		k = &ic->ic_key[i];
+		if (i == 0 || k->k_class != k[-1].k_class ||
+		    k->k_hash != k[-1].k_hash) {
+			c = k->k_idx;
+			n++;
+		}
+		ic->ic_class[k->k_idx] = c;
+	}
+
+	return (n);
+}
+
+static int
+_equal(struct ld_icf *ic, size_t a, size_t b)
+{
+	struct ld_input_section *isa, *isb;
+	struct ld_reloc_entry *la, *lb;
+	struct ld_icf_target *ta, *tb;
+	uint64_t j, nr;
+
+	isa = ic->ic_is[a];
+	isb = ic->ic_is[b];
+	nr = _ICF_RELOC_NUM(isa);
+	if (isa->is_size != isb->is_size || isa->is_flags != isb->is_flags ||
+	    isa->is_align != isb->is_align || nr != _ICF_RELOC_NUM(isb) ||
+	    memcmp(ic->ic_data[a], ic->ic_data[b], isa->is_size) != 0)
+		return (0);
+
+	for (j = 0; j < nr; j++) {
+		la = &isa->is_ris->is_reloc[j];
+		lb = &isb->is_ris->is_reloc[j];
+		if (la->lre_type != lb->lre_type ||
+		    la->lre_offset != lb->lre_offset ||
+		    la->lre_addend != lb->lre_addend)
+			return (0);
+		ta = &ic->ic_tgt[a][j];
+		tb = &ic->ic_tgt[b][j];
+		if (ta->it_value != tb->it_value || ta->it_ptr != tb->it_ptr ||
+		    (ta->it_sec == 0) != (tb->it_sec == 0))
+			return (0);
+		if (ta->it_sec != 0 && ic->ic_class[ta->it_sec - 1] !=
+		    ic->ic_class[tb->it_sec - 1])
+			return (0);
+	}
+
+	return (1);
+}
+
+/*
+ * Remove the sections which are not the first of their class, and
+ * move their symbols to the first one.
+ */
+static void
+_fold(struct ld *ld, struct ld_icf *ic)
+{
+	struct ld_input *li;
+	struct ld_input_section *is, *_is;
+	struct ld_symbol *lsb;
+	size_t i, j;
+
+	for (i = 0; i < ic->ic_num; i++) {
+		if (ic->ic_class[i] == i)
+			continue;
+		is = ic->ic_is[i];
+		_is = ic->ic_is[ic->ic_class[i]];
+		is->is_discard = 1;
+		if (ld->ld_icf_print)
+			ld_info(ld, "Fold section `%s' in file %s into `%s' "
+			    "in file %s", is->is_name,
+			    ld_input_get_fullname(ld, is->is_input),
+			    _is->is_name, ld_input_get_fullname(ld,
+			    _is->is_input));
+	}
+
+	/*
+	 * Drop the FDE's of the folded sections before their symbols
+	 * are redirected to the sections they are folded into.
+	 */
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		if (li->li_name == NULL || li->li_type == LIT_DSO)
+			continue;
+		for (j = 0; j < li->li_shnum; j++) {
+			is = &li->li_is[j];
+			if (is->is_name != NULL && is->is_type != SHT_REL &&
+			    is->is_type != SHT_RELA &&
+			    !strcmp(is->is_name, ".eh_frame"))
+				ld_ehframe_prune(ld, is);
+		}
+	}
+
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		if (li->li_name == NULL || li->li_type == LIT_DSO ||
+		    li->li_symindex == NULL)
+			continue;
+		for (j = 0; j < li->li_symnum; j++) {
+			if ((lsb = li->li_symindex[j]) == NULL ||
+			    (is = lsb->lsb_is) == NULL || is->is_icf == 0)
+				continue;
+			i = is->is_icf - 1;
+			if (ic->ic_class[i] != i)
+				lsb->lsb_is = ic->ic_is[ic->ic_class[i]];
+		}
+	}
+}
+
+static uint64_t
+_mix(uint64_t h, uint64_t v)
+{
+
+	h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+
+	return (h * 0xff51afd7ed558ccdULL);
+}
+
+static int
+_cmp_key(const void *a, const void *b)
+{
+	const struct ld_icf_key *ka, *kb;
+
+	ka = a;
+	kb = b;
+	if (ka->k_class != kb->k_class)
+		return (ka->k_class < kb->k_class ? -1 : 1);
+	if (ka->k_hash != kb->k_hash)
+		return (ka->k_hash < kb->k_hash ? -1 : 1);
+	if (ka->k_idx != kb->k_idx)
+		return (ka->k_idx < kb->k_idx ? -1 : 1);
+
+	return (0);
+}
@@ -25,6 +25,7 @@
  */
 
 #include "ld.h"
+#include "ld_arena.h"
 #include "ld_file.h"
 #include "ld_input.h"
 #include "ld_symbols.h"
@@ -57,10 +58,8 @@ ld_input_init(struct ld *ld)
 
 	li = ld_input_alloc(ld, NULL, NULL);
 
-	li->li_is = calloc(_MAX_INTERNAL_SECTIONS,
+	li->li_is = ld_arena_calloc(ld, _MAX_INTERNAL_SECTIONS,
 	    sizeof(struct ld_input_section));
-	if (li->li_is == NULL)
-		ld_fatal_std(ld, "calloc");
 
 	STAILQ_INSERT_TAIL(&ld->ld_lilist, li, li_next);
 
@@ -70,8 +69,7 @@ ld_input_init(struct ld *ld)
 	 * (other than SHN_UNDEF)
 	 */
 	is = &li->li_is[li->li_shnum];
-	if ((is->is_name = strdup("")) == NULL)
-		ld_fatal_std(ld, "strdup");
+	is->is_name = ld_arena_strdup(ld, "");
 	is->is_input = li;
 	is->is_type = SHT_NULL;
 	is->is_index = li->li_shnum;
@@ -92,8 +90,7 @@ ld_input_add_internal_section(struct ld *ld, const char *name)
 		    "sections");
 
 	is = &li->li_is[li->li_shnum];
-	if ((is->is_name = strdup(name)) == NULL)
-		ld_fatal_std(ld, "strdup");
+	is->is_name = ld_arena_strdup(ld, name);
 	is->is_input = li;
 	is->is_index = li->li_shnum;
 
@@ -163,6 +160,10 @@ ld_input_cleanup(struct ld *ld)
 	struct ld_input *li, *_li;
 	int i;
 
+	/*
+	 * The input objects themselves, their names and their section
+	 * arrays are allocated from the arena and released with it.
+	 */
 	STAILQ_FOREACH_SAFE(li, &ld->ld_lilist, li_next, _li) {
 		STAILQ_REMOVE(&ld->ld_lilist, li, ld_input, li_next);
 		if (li->li_symindex)
@@ -177,15 +178,10 @@ ld_input_cleanup(struct ld *ld)
 					free(li->li_vername[i]);
 			free(li->li_vername);
 		}
-		if (li->li_is)
-			free(li->li_is);
 		if (li->li_fullname)
 			free(li->li_fullname);
-		if (li->li_name)
-			free(li->li_name);
 		if (li->li_soname)
 			free(li->li_soname);
-		free(li);
 	}
 }
 
@@ -219,11 +215,9 @@ ld_input_alloc(struct ld *ld, struct ld_file *lf, const char *name)
 {
 	struct ld_input *li;
 
-	if ((li = calloc(1, sizeof(*li))) == NULL)
-		ld_fatal_std(ld, "calloc");
-
-	if (name != NULL && (li->li_name = strdup(name)) == NULL)
-		ld_fatal_std(ld, "strdup");
+	li = ld_arena_calloc(ld, 1, sizeof(*li));
+	if (name != NULL)
+		li->li_name = ld_arena_strdup(ld, name);
 
 	li->li_file = lf;
 
@@ -294,6 +288,12 @@ ld_input_link_objects(struct ld *ld)
 	}
 }
 
+/*
+ * Return the contents of an input section.  The returned pointer refers
+ * to the image of the input file, which is mapped copy-on-write, so the
+ * caller may apply relocations to it in place.  The data remains valid
+ * until the file is unloaded.
+ */
 void *
 ld_input_get_section_rawdata(struct ld *ld, struct ld_input_section *is)
 {
@@ -301,7 +301,6 @@ ld_input_get_section_rawdata(struct ld *ld, struct ld_input_section *is)
 	Elf_Scn *scn;
 	Elf_Data *d;
 	struct ld_input *li;
-	char *buf;
 	int elferr;
 
 	li = is->is_input;
@@ -324,18 +323,12 @@ ld_input_get_section_rawdata(struct ld *ld, struct ld_input_section *is)
 	if (d->d_buf == NULL || d->d_size == 0)
 		return (NULL);
 
-	if ((buf = malloc(d->d_size)) == NULL)
-		ld_fatal_std(ld, "malloc");
-
-	memcpy(buf, d->d_buf, d->d_size);
-
-	return (buf);
+	return (d->d_buf);
 }
 
 void
 ld_input_load(struct ld *ld, struct ld_input *li)
 {
-	struct ld_state *ls;
 	struct ld_file *lf;
 	struct ld_archive_member *lam;
 
@@ -343,23 +336,30 @@ ld_input_load(struct ld *ld, struct ld_input *li)
 		return;
 
 	assert(li->li_elf == NULL);
-	ls = &ld->ld_state;
-	if (li->li_file != ls->ls_file) {
-		if (ls->ls_file != NULL)
-			ld_file_unload(ld, ls->ls_file);
-		ld_file_load(ld, li->li_file);
-	}
 	lf = li->li_file;
+	ld_file_load(ld, lf);
 	if (lf->lf_ar != NULL) {
+		/*
+		 * Member descriptors are kept with the archive mapping,
+		 * so a member is only parsed again after its archive
+		 * has been evicted from the file cache.
+		 */
 		assert(li->li_lam != NULL);
 		lam = li->li_lam;
+		if (lam->lam_elf != NULL) {
+			ld->ld_fc->fc_mhit++;
+			li->li_elf = lam->lam_elf;
+			return;
+		}
+		ld->ld_fc->fc_mmiss++;
 		if (elf_rand(lf->lf_elf, lam->lam_off) != lam->lam_off)
 			ld_fatal(ld, "%s: elf_rand: %s", lf->lf_name,
 			    elf_errmsg(-1));
-		if ((li->li_elf = elf_begin(-1, ELF_C_READ, lf->lf_elf)) ==
+		if ((lam->lam_elf = elf_begin(-1, ELF_C_READ, lf->lf_elf)) ==
 		    NULL)
 			ld_fatal(ld, "%s: elf_begin: %s", lf->lf_name,
 			    elf_errmsg(-1));
+		li->li_elf = lam->lam_elf;
 	} else
 		li->li_elf = lf->lf_elf;
 }
@@ -367,18 +367,13 @@ ld_input_load(struct ld *ld, struct ld_input *li)
 void
 ld_input_unload(struct ld *ld, struct ld_input *li)
 {
-	struct ld_file *lf;
-
-	(void) ld;
 
 	if (li->li_file == NULL)
 		return;
 
 	assert(li->li_elf != NULL);
-	lf = li->li_file;
-	if (lf->lf_ar != NULL)
-		(void) elf_end(li->li_elf);
 	li->li_elf = NULL;
+	ld_file_unload(ld, li->li_file);
 }
 
 void
@@ -405,8 +400,7 @@ ld_input_init_sections(struct ld *ld, struct ld_input *li, Elf *e)
 	li->li_shnum++;
 
 	assert(li->li_is == NULL);
-	if ((li->li_is = calloc(li->li_shnum, sizeof(*is))) == NULL)
-		ld_fatal_std(ld, "%s: calloc: %s", li->li_name);
+	li->li_is = ld_arena_calloc(ld, li->li_shnum, sizeof(*is));
 
 	if (elf_getshdrstrndx(e, &shstrndx) < 0)
 		ld_fatal(ld, "%s: elf_getshdrstrndx: %s", li->li_name,
@@ -432,8 +426,7 @@ ld_input_init_sections(struct ld *ld, struct ld_input *li, Elf *e)
 			    " invalid", li->li_name, name);
 
 		is = &li->li_is[ndx];
-		if ((is->is_name = strdup(name)) == NULL)
-			ld_fatal_std(ld, "%s: calloc", li->li_name);
+		is->is_name = ld_arena_strdup(ld, name);
 		is->is_off = sh.sh_offset;
 		is->is_size = sh.sh_size;
 		is->is_entsize = sh.sh_entsize;
@@ -590,8 +583,7 @@ ld_input_alloc_common_symbol(struct ld *ld, struct ld_symbol *lsb)
 		 * Create a pseudo section named COMMON to keep track of
 		 * common symbols.
 		 */
-		if ((is->is_name = strdup("COMMON")) == NULL)
-			ld_fatal_std(ld, "%s: calloc", li->li_name);
+		is->is_name = ld_arena_strdup(ld, "COMMON");
 		is->is_off = 0;
 		is->is_size = 0;
 		is->is_entsize = 0;
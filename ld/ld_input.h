@@ -26,8 +26,9 @@
  * $Id$
  */
 
-struct ld_reloc_entry_head;
+struct ld_reloc_entry;
 struct ld_ehframe_fde_head;
+struct ld_merge_section;
 
 struct ld_section_group {
 	char *sg_name;
@@ -55,14 +56,18 @@ struct ld_input_section {
 	unsigned char is_pltrel;	/* section holds PLT relocations */
 	unsigned char is_refed;		/* should not be gc'ed */
 	unsigned char is_need_reloc;	/* need apply relocation */
+	unsigned char is_ignore_next_plt; /* ignore next PLT relocation */
 	void *is_data;			/* output section data descriptor */
 	void *is_ibuf;			/* buffer for internal sections */
 	void *is_ehframe;		/* temp buffer for ehframe section. */
-	struct ld_reloc_entry_head *is_reloc; /* list of relocation entries */
+	struct ld_reloc_entry *is_reloc; /* array of relocation entries */
 	uint64_t is_num_reloc;		/* number of reloc entries */
+	uint64_t is_cap_reloc;		/* capacity of is_reloc */
 	struct ld_input_section *is_tis; /* relocation target */
 	struct ld_input_section *is_ris; /* relocation section */
 	struct ld_ehframe_fde_head *is_fde; /* list of FDE */
+	struct ld_merge_section *is_merge; /* merged section offset map */
+	uint64_t is_icf;		/* ICF candidate index + 1 */
 	STAILQ_ENTRY(ld_input_section) is_next; /* next section */
 	STAILQ_ENTRY(ld_input_section) is_gc_next; /* next gc search */
 	UT_hash_handle hh;		/* hash handle (internal section) */
@@ -98,6 +103,7 @@ struct ld_input {
 	size_t li_versym_sz;		/* symbol version array size */
 	int li_dso_refcnt;		/* symbol reference count (DSO) */
 	struct ld_symver_verdef_head *li_verdef; /* version definition */
+	void *li_data;			/* section contents copied out */
 	STAILQ_ENTRY(ld_input) li_next;	/* next input object */
 };
 
@@ -25,6 +25,7 @@
  */
 
 #include "ld.h"
+#include "ld_arena.h"
 #include "ld_arch.h"
 #include "ld_dynamic.h"
 #include "ld_ehframe.h"
@@ -35,22 +36,66 @@
 #include "ld_output.h"
 #include "ld_reloc.h"
 #include "ld_layout.h"
+#include "ld_merge.h"
 #include "ld_options.h"
 #include "ld_symbols.h"
 #include "ld_strtab.h"
 
 ELFTC_VCSID("$Id$");
 
+/*
+ * The section name wildcards of the SECTIONS command are compiled
+ * into a matcher before input sections are laid out. Every input
+ * section description is an entry, numbered in script order, and
+ * every pattern is numbered in the same order. Patterns without glob
+ * characters are kept in a hash table, patterns of the form "prefix*"
+ * terminate at a node of a byte trie, and the remaining patterns hang
+ * off the trie node of their literal prefix, so that fnmatch(3) is
+ * only called for names that share that prefix.
+ */
+
+struct ld_wildcard_pattern {
+	char *wp_name;			/* pattern */
+	unsigned wp_id;			/* pattern number */
+	struct ld_wildcard_pattern *wp_next; /* next pattern */
+	UT_hash_handle hh;		/* hash handle (exact names) */
+};
+
+struct ld_wildcard_node {
+	unsigned char wn_c;		/* byte leading to this node */
+	struct ld_wildcard_node *wn_child; /* first child */
+	struct ld_wildcard_node *wn_sibling; /* next sibling */
+	struct ld_wildcard_pattern *wn_prefix; /* "prefix*" patterns */
+	struct ld_wildcard_pattern *wn_glob; /* other patterns */
+};
+
+struct ld_wildcard_entry {
+	struct ld_output_section *we_os; /* output section */
+	struct ld_output_element *we_oe; /* input section description */
+};
+
+/*
+ * Match results are cached by the set of patterns a name matches
+ * rather than by the name itself, so that the unique names produced
+ * by -ffunction-sections share a handful of cache entries.
+ */
+
 struct ld_wildcard_match {
-	char *wm_name;
-	unsigned wm_no_match;
-	struct ld_output_section *wm_os;
-	struct ld_input_section_head *wm_islist;
-	struct ld_script_sections_output_input *wm_ldoi;
-	struct ld_wildcard_match *wm_next;
+	unsigned *wm_key;		/* matching pattern numbers */
+	unsigned *wm_ent;		/* matching entries, in script order */
+	size_t wm_nent;			/* number of matching entries */
 	UT_hash_handle hh;
 };
 
+struct ld_wildcard_matcher {
+	struct ld_wildcard_entry *wc_ent; /* input section descriptions */
+	unsigned *wc_pent;		/* pattern number to entry map */
+	unsigned *wc_id;		/* matching pattern buffer */
+	struct ld_wildcard_pattern *wc_exact; /* exact name hash */
+	struct ld_wildcard_node wc_root; /* prefix trie */
+	struct ld_wildcard_match *wc_wm; /* match cache */
+};
+
 /*
  * Support routines for output section layout.
  */
@@ -62,12 +107,18 @@ static void _calc_reloc_section_offset(struct ld *ld, struct ld_output *lo);
 static void _calc_shdr_offset(struct ld *ld);
 static int _check_filename_constraint(struct ld_input *li,
     struct ld_script_sections_output_input *ldoi);
+static int _cmp_wildcard_id(const void *a, const void *b);
+static void _compile_wildcard(struct ld *ld, struct ld_wildcard_matcher *wc,
+    char *name, unsigned id);
+static void _compile_wildcards(struct ld *ld);
 static void _insert_input_to_output(struct ld *ld, struct ld_output *lo,
     struct ld_output_section *os, struct ld_input_section *is,
     struct ld_input_section_head *islist);
 static void _layout_input_sections(struct ld *ld, struct ld_input *li);
 static void _layout_orphan_section(struct ld *ld, struct ld_input_section *is);
 static void _layout_sections(struct ld *ld, struct ld_script_sections *ldss);
+static struct ld_wildcard_match *_match_wildcards(struct ld *ld,
+    char *name);
 static void _parse_output_section_descriptor(struct ld *ld,
     struct ld_output_section *os);
 static void _prepare_output_section(struct ld *ld,
@@ -75,9 +126,6 @@ static void _prepare_output_section(struct ld *ld,
 static void _print_section_layout(struct ld *ld, struct ld_output_section *os);
 static void _print_wildcard(struct ld_wildcard *lw);
 static void _print_wildcard_list(struct ld_script_list *ldl);
-static void _record_wildcard_match(struct ld *ld, char *name,
-    struct ld_output_section *os, struct ld_output_element *oe);
-static void _record_wildcard_no_match(struct ld *ld, char *name);
 static void _set_output_section_loadable_flag(struct ld_output_section *os);
 static int _wildcard_match(struct ld_wildcard *lw, const char *string);
 static int _wildcard_list_match(struct ld_script_list *list,
@@ -129,6 +177,13 @@ ld_layout_sections(struct ld *ld)
 	/* Scan and optimize .eh_frame section. */
 	ld_ehframe_scan(ld);
 
+	/* Merge duplicate strings and constants of SHF_MERGE sections. */
+	ld_merge_sections(ld);
+
+	/* Size the packed relative relocation section. */
+	if (ld->ld_relr)
+		ld_reloc_size_relr(ld);
+
 	/* Initialise sections for dyanmically linked output object. */
 	ld_dynamic_create(ld);
 
@@ -281,6 +336,14 @@ _print_section_layout(struct ld *ld, struct ld_output_section *os)
 					    is->is_size);
 				printf(" %s\n", ld_input_get_fullname(ld,
 				    is->is_input));
+				if (is->is_merge != NULL &&
+				    is->is_merge->ms_leader == is)
+					printf(" %-14s %*s %#10jx merged from"
+					    " %zu sections of %#jx bytes\n", "",
+					    lo->lo_ec == ELFCLASS32 ? 10 : 18, "",
+					    (uintmax_t) is->is_size,
+					    is->is_merge->ms_nsec,
+					    (uintmax_t) is->is_merge->ms_insize);
 			}
 			break;
 		default:
@@ -457,6 +520,8 @@ _layout_sections(struct ld *ld, struct ld_script_sections *ldss)
 		}
 	}
 
+	_compile_wildcards(ld);
+
 	/* Lay out each input object. */
 	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
 
@@ -590,74 +655,191 @@ _check_filename_constraint(struct ld_input *li,
 }
 
 static void
-_record_wildcard_match(struct ld *ld, char *name, struct ld_output_section *os,
-    struct ld_output_element *oe)
+_compile_wildcard(struct ld *ld, struct ld_wildcard_matcher *wc, char *name,
+    unsigned id)
 {
-	struct ld_wildcard_match *wm, *_wm;
-
-	assert(name != NULL && os != NULL);
-	assert(oe != NULL && oe->oe_type == OET_INPUT_SECTION_LIST);
-
-	HASH_FIND_STR(ld->ld_wm, name, wm);
-
-	/* Create a new wildcard match. */
-	if (wm == NULL) {
-		if ((wm = calloc(1, sizeof(*wm))) == NULL)
-			ld_fatal_std(ld, "calloc");
-		if ((wm->wm_name = strdup(name)) == NULL)
-			ld_fatal_std(ld, "strdup");
-		wm->wm_os = os;
-		wm->wm_islist = oe->oe_islist;
-		wm->wm_ldoi = oe->oe_entry;
-		wm->wm_next = NULL;
-		HASH_ADD_KEYPTR(hh, ld->ld_wm, wm->wm_name,
-		    strlen(wm->wm_name), wm);
+	struct ld_wildcard_node *wn, *_wn;
+	struct ld_wildcard_pattern *wp, *_wp;
+	size_t i, len;
+
+	wp = ld_arena_calloc(ld, 1, sizeof(*wp));
+	wp->wp_name = name;
+	wp->wp_id = id;
+
+	len = strcspn(name, "*?[\\");
+	if (name[len] == '\0') {
+		HASH_FIND_STR(wc->wc_exact, name, _wp);
+		if (_wp != NULL) {
+			wp->wp_next = _wp->wp_next;
+			_wp->wp_next = wp;
+		} else
+			HASH_ADD_KEYPTR(hh, wc->wc_exact, wp->wp_name, len,
+			    wp);
 		return;
 	}
 
+	/* Walk down the trie along the literal prefix. */
+	wn = &wc->wc_root;
+	for (i = 0; i < len; i++) {
+		for (_wn = wn->wn_child; _wn != NULL; _wn = _wn->wn_sibling)
+			if (_wn->wn_c == (unsigned char) name[i])
+				break;
+		if (_wn == NULL) {
+			_wn = ld_arena_calloc(ld, 1, sizeof(*_wn));
+			_wn->wn_c = (unsigned char) name[i];
+			_wn->wn_sibling = wn->wn_child;
+			wn->wn_child = _wn;
+		}
+		wn = _wn;
+	}
+
+	if (name[len] == '*' && name[len + 1] == '\0') {
+		wp->wp_next = wn->wn_prefix;
+		wn->wn_prefix = wp;
+	} else {
+		wp->wp_next = wn->wn_glob;
+		wn->wn_glob = wp;
+	}
+}
+
+static void
+_compile_wildcards(struct ld *ld)
+{
+	struct ld_wildcard_matcher *wc;
+	struct ld_output *lo;
+	struct ld_output_section *os;
+	struct ld_output_element *oe;
+	struct ld_script_sections_output_input *ldoi;
+	struct ld_script_list *ldl;
+	struct ld_wildcard *lw;
+	unsigned nent, npat;
+
+	lo = ld->ld_output;
+
 	/*
-	 * Wildcard match already exist, compare the "ldoi" to check
-	 * if this is a new wildcard match with a different file/archive
-	 * constraint. If so, Insert it to the tail of the wildcard match
-	 * list.
+	 * Output sections created for orphan input sections are not
+	 * there yet, so every input section list element found here
+	 * comes from the linker script.
 	 */
-	do {
-		if (oe->oe_entry == (void *) wm->wm_ldoi)
-			return;
-	} while (wm->wm_next != NULL && (wm = wm->wm_next));
+	nent = npat = 0;
+	STAILQ_FOREACH(os, &lo->lo_oslist, os_next) {
+		STAILQ_FOREACH(oe, &os->os_e, oe_next) {
+			if (oe->oe_type != OET_INPUT_SECTION_LIST ||
+			    (ldoi = oe->oe_entry) == NULL)
+				continue;
+			nent++;
+			assert(ldoi->ldoi_sec != NULL);
+			for (ldl = ldoi->ldoi_sec; ldl != NULL;
+			     ldl = ldl->ldl_next)
+				npat++;
+		}
+	}
 
-	if ((_wm = calloc(1, sizeof(*_wm))) == NULL)
-		ld_fatal_std(ld, "calloc");
-	_wm->wm_os = os;
-	_wm->wm_islist = oe->oe_islist;
-	_wm->wm_ldoi = oe->oe_entry;
-	_wm->wm_next = NULL;
-	wm->wm_next = _wm;
+	wc = ld_arena_calloc(ld, 1, sizeof(*wc));
+	wc->wc_ent = ld_arena_calloc(ld, nent, sizeof(*wc->wc_ent));
+	wc->wc_pent = ld_arena_calloc(ld, npat, sizeof(*wc->wc_pent));
+	wc->wc_id = ld_arena_calloc(ld, npat, sizeof(*wc->wc_id));
+
+	nent = npat = 0;
+	STAILQ_FOREACH(os, &lo->lo_oslist, os_next) {
+		STAILQ_FOREACH(oe, &os->os_e, oe_next) {
+			if (oe->oe_type != OET_INPUT_SECTION_LIST ||
+			    (ldoi = oe->oe_entry) == NULL)
+				continue;
+			wc->wc_ent[nent].we_os = os;
+			wc->wc_ent[nent].we_oe = oe;
+			for (ldl = ldoi->ldoi_sec; ldl != NULL;
+			     ldl = ldl->ldl_next) {
+				lw = ldl->ldl_entry;
+				wc->wc_pent[npat] = nent;
+				_compile_wildcard(ld, wc, lw->lw_name, npat);
+				npat++;
+			}
+			nent++;
+		}
+	}
+
+	ld->ld_wm = wc;
 }
 
-static void
-_record_wildcard_no_match(struct ld *ld, char *name)
+static int
+_cmp_wildcard_id(const void *a, const void *b)
+{
+	unsigned x, y;
+
+	x = *(const unsigned *) a;
+	y = *(const unsigned *) b;
+
+	return (x < y ? -1 : x > y);
+}
+
+static struct ld_wildcard_match *
+_match_wildcards(struct ld *ld, char *name)
 {
+	struct ld_wildcard_matcher *wc;
 	struct ld_wildcard_match *wm;
+	struct ld_wildcard_node *wn;
+	struct ld_wildcard_pattern *wp;
+	const char *p;
+	unsigned e;
+	size_t i, n;
 
-	assert(name != NULL);
+	wc = ld->ld_wm;
+	n = 0;
 
-	HASH_FIND_STR(ld->ld_wm, name, wm);
+	HASH_FIND_STR(wc->wc_exact, name, wp);
+	for (; wp != NULL; wp = wp->wp_next)
+		wc->wc_id[n++] = wp->wp_id;
 
 	/*
-	 * Unfortunately this section is an orphan section because
-	 * it doesn't satisfy the file/archive constraint but does
-	 * match certain section name wildcard. We can not record this.
+	 * Every "prefix*" pattern on the path matches. The other
+	 * patterns on the path share their literal prefix with the
+	 * name and need a closer look.
 	 */
+	wn = &wc->wc_root;
+	p = name;
+	for (;;) {
+		for (wp = wn->wn_prefix; wp != NULL; wp = wp->wp_next)
+			wc->wc_id[n++] = wp->wp_id;
+		for (wp = wn->wn_glob; wp != NULL; wp = wp->wp_next)
+			if (fnmatch(wp->wp_name, name, 0) == 0)
+				wc->wc_id[n++] = wp->wp_id;
+		if (*p == '\0')
+			break;
+		for (wn = wn->wn_child; wn != NULL; wn = wn->wn_sibling)
+			if (wn->wn_c == (unsigned char) *p)
+				break;
+		if (wn == NULL)
+			break;
+		p++;
+	}
+
+	if (n == 0)
+		return (NULL);
+
+	qsort(wc->wc_id, n, sizeof(*wc->wc_id), _cmp_wildcard_id);
+
+	HASH_FIND(hh, wc->wc_wm, wc->wc_id, n * sizeof(*wc->wc_id), wm);
 	if (wm != NULL)
-		return;
+		return (wm);
 
-	/* Create the wildcard "no-match" for the orphan. */
-	if ((wm = calloc(1, sizeof(*wm))) == NULL)
-		ld_fatal_std(ld, "calloc");
-	if ((wm->wm_name = strdup(name)) == NULL)
-		ld_fatal_std(ld, "strdup");
-	wm->wm_no_match = 1;
+	/*
+	 * Pattern numbers follow the script order, so the entries
+	 * derived from the sorted key are in script order too.
+	 */
+	wm = ld_arena_calloc(ld, 1, sizeof(*wm));
+	wm->wm_key = ld_arena_calloc(ld, n, sizeof(*wm->wm_key));
+	memcpy(wm->wm_key, wc->wc_id, n * sizeof(*wm->wm_key));
+	wm->wm_ent = ld_arena_calloc(ld, n, sizeof(*wm->wm_ent));
+	for (i = 0; i < n; i++) {
+		e = wc->wc_pent[wm->wm_key[i]];
+		if (wm->wm_nent == 0 || wm->wm_ent[wm->wm_nent - 1] != e)
+			wm->wm_ent[wm->wm_nent++] = e;
+	}
+	HASH_ADD_KEYPTR(hh, wc->wc_wm, wm->wm_key, n * sizeof(*wm->wm_key),
+	    wm);
+
+	return (wm);
 }
 
 static void
@@ -665,10 +847,9 @@ _layout_input_sections(struct ld *ld, struct ld_input *li)
 {
 	struct ld_input_section *is;
 	struct ld_output *lo;
-	struct ld_output_section *os;
-	struct ld_output_element *oe;
+	struct ld_wildcard_entry *we;
 	struct ld_wildcard_match *wm;
-	struct ld_script_sections_output_input *ldoi;
+	size_t j;
 	int i;
 
 	lo = ld->ld_output;
@@ -689,111 +870,38 @@ _layout_input_sections(struct ld *ld, struct ld_input *li)
 		    strcmp(is->is_name, ".strtab") == 0)
 			continue;
 
-		/* Search the wildcard match table for a quick match. */
-		HASH_FIND_STR(ld->ld_wm, is->is_name, wm);
-		if (wm != NULL) {
-			if (wm->wm_no_match) {
-				/*
-				 * We found a "no-match". This is certainly
-				 * an orphan section.
-				 */
-				_layout_orphan_section(ld, is);
-				continue;
-			}
-		} else
-			goto full_search;
-
-		/* There is a match! Verify file/archive constraint. */
-		while (wm != NULL) {
-			ldoi = wm->wm_ldoi;
-
-			if (!_check_filename_constraint(li, ldoi))
-				goto next_wm;
-
-			if (strcmp(wm->wm_os->os_name, "/DISCARD/") == 0) {
-				is->is_discard = 1;
-				break;
-			}
-
-			/*
-			 * File/archive constraint satisfied. Insert the
-			 * this section to the input section list of the
-			 * output section element.
-			 */
-			_insert_input_to_output(ld, lo, wm->wm_os, is,
-			    wm->wm_islist);
-			break;
-
-		next_wm:
-			wm = wm->wm_next;
-		}
-
-		if (wm != NULL)
-			continue;
-
-	full_search:
-
 		/*
-		 * Otherwise, we have to do a full search for the section
-		 * name in all the wildcard list.
+		 * Find the first input section description that matches
+		 * the section name and whose file/archive constraint is
+		 * satisfied.
 		 */
-		STAILQ_FOREACH(os, &lo->lo_oslist, os_next) {
-			STAILQ_FOREACH(oe, &os->os_e, oe_next) {
-
-				if (oe->oe_type != OET_INPUT_SECTION_LIST)
-					continue;
-
-				/*
-				 * Skip output sections created for orphan
-				 * input sections. They don't have wildcard
-				 * list.
-				 */
-				if ((ldoi = oe->oe_entry) == NULL)
-					continue;
-
-				/* Check if the section name match wildcard */
-				assert(ldoi->ldoi_sec != NULL);
-				if (!_wildcard_list_match(ldoi->ldoi_sec,
-				    is->is_name))
-					continue;
-
-				/*
-				 * Record this wildcard match to speed up
-				 * wildcard match for sections with the same
-				 * name.
-				 */
-				_record_wildcard_match(ld, is->is_name, os,
-				    oe);
-
-				/* Check file/archive constraint.  */
-				if (!_check_filename_constraint(li, ldoi)) {
-					continue;
-				}
-
-				/* Check if we should discard the section. */
-				if (strcmp(os->os_name, "/DISCARD/") == 0) {
-					is->is_discard = 1;
-					goto next_input_section;
-				}
-
-				/* Match! Insert to the input section list. */
-				_insert_input_to_output(ld, lo, os, is,
-				    oe->oe_islist);
-				goto next_input_section;
+		we = NULL;
+		if ((wm = _match_wildcards(ld, is->is_name)) != NULL) {
+			for (j = 0; j < wm->wm_nent; j++) {
+				we = &ld->ld_wm->wc_ent[wm->wm_ent[j]];
+				if (_check_filename_constraint(li,
+				    we->we_oe->oe_entry))
+					break;
 			}
+			if (j == wm->wm_nent)
+				we = NULL;
 		}
 
-		/*
-		 * We found an orphan section. Record this so we can quickly
-		 * identify other orphan sections with the same name.
-		 */
-		_record_wildcard_no_match(ld, is->is_name);
+		/* We found an orphan section. */
+		if (we == NULL) {
+			_layout_orphan_section(ld, is);
+			continue;
+		}
 
-		/* Lay out the orphan section. */
-		_layout_orphan_section(ld, is);
+		/* Check if we should discard the section. */
+		if (strcmp(we->we_os->os_name, "/DISCARD/") == 0) {
+			is->is_discard = 1;
+			continue;
+		}
 
-	next_input_section:
-		;
+		/* Match! Insert to the input section list. */
+		_insert_input_to_output(ld, lo, we->we_os, is,
+		    we->we_oe->oe_islist);
 	}
 }
 
@@ -1157,7 +1265,7 @@ _calc_output_section_offset(struct ld *ld, struct ld_output_section *os)
 		case OET_STRTAB:
 			assert(ls->ls_loc_counter == 0);
 			st = oe->oe_entry;
-			ls->ls_loc_counter = ld_strtab_getsize(st);
+			ls->ls_loc_counter = ld_strtab_getsize(ld, st);
 			break;
 		default:
 			break;
@@ -25,8 +25,11 @@
  */
 
 #include "ld.h"
+#include "ld_arena.h"
 #include "ld_arch.h"
+#include "ld_build_id.h"
 #include "ld_ehframe.h"
+#include "ld_icf.h"
 #include "ld_options.h"
 #include "ld_reloc.h"
 #include "ld_script.h"
@@ -71,6 +74,7 @@ _cleanup(void)
 	ld_path_cleanup(ld);
 	ld_input_cleanup(ld);
 	ld_file_cleanup(ld);
+	ld_arena_cleanup(ld);
 }
 
 int
@@ -91,6 +95,15 @@ restart:
 	/* The linker generate an executable by default */
 	ld->ld_exec = 1;
 
+	/* Create the SysV style .hash section by default. */
+	ld->ld_hash_style = LD_HASH_STYLE_SYSV;
+
+	/* Apply relocations from the main thread only by default. */
+	ld->ld_threads = 1;
+
+	/* Keep up to LD_FILE_CACHE_SIZE bytes of input files mapped. */
+	ld->ld_file_cache_size = LD_FILE_CACHE_SIZE;
+
 	ld_script_init(ld);
 
 	ld_options_parse(ld, argc, argv);
@@ -114,13 +127,16 @@ restart:
 
 	/*
 	 * Perform section garbage collection if command line option
-	 * -gc-sections is specified. Perform deferred relocation scan
-	 * after garbage sections are found.
+	 * -gc-sections is specified, and fold identical sections if
+	 * option -icf is specified. Perform deferred relocation scan
+	 * after garbage sections and identical sections are found.
 	 */
-	if (ld->ld_gc) {
+	if (ld->ld_gc)
 		ld_reloc_gc_sections(ld);
+	if (ld->ld_icf != LD_ICF_NONE)
+		ld_icf_fold_sections(ld);
+	if (ld->ld_gc || ld->ld_icf != LD_ICF_NONE)
 		ld_reloc_deferred_scan(ld);
-	}
 
 	/*
 	 * Search for undefined symbols and allocate space for common
@@ -133,12 +149,19 @@ restart:
 	if (ld->ld_ehframe_hdr)
 		ld_ehframe_create_hdr(ld);
 
+	/* Create .note.gnu.build-id section. */
+	if (ld->ld_build_id != LD_BUILD_ID_NONE)
+		ld_build_id_create(ld);
+
 	ld_output_init(ld);
 
 	ld_layout_sections(ld);
 
 	ld_output_create(ld);
 
+	if (ld->ld_stats)
+		ld_file_print_stats(ld);
+
 	_cleanup();
 
 	exit(EXIT_SUCCESS);
@@ -0,0 +1,630 @@
+/*-
+ * Copyright (c) 2026 The Elftoolchain Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "ld.h"
+#include "ld_arch.h"
+#include "ld_arena.h"
+#include "ld_hash.h"
+#include "ld_input.h"
+#include "ld_merge.h"
+#include "ld_output.h"
+#include "ld_reloc.h"
+#include "ld_symbols.h"
+
+ELFTC_VCSID("$Id$");
+
+/*
+ * Merging of SHF_MERGE input sections.
+ *
+ * The input sections of an output section which have the same flags,
+ * entry size and alignment form a group.  Each section of a group is
+ * cut into pieces: NUL terminated strings for SHF_STRINGS sections and
+ * entries of the entry size otherwise.  Identical pieces are stored
+ * only once, and for string sections a string which is the tail of
+ * another string is stored as part of that string.  The merged
+ * contents are put into the first section of the group, the leader,
+ * and the other sections of the group become empty.
+ *
+ * Pieces are deduplicated with a hash table which is split into
+ * shards by the high bits of the piece hash, so that the shards can
+ * be filled by different threads when --threads is given.  Within a
+ * shard pieces are inserted in input order, so the first occurrence
+ * of a piece is always the one which is kept and the output does not
+ * depend on the number of threads.
+ *
+ * Relocations against section symbols and the values of symbols
+ * defined in merged sections are then rewritten to point to the
+ * merged location.  Merging is not done for relocatable output or
+ * with -emit-relocs, and not for targets which use REL relocations,
+ * since the addends of those are stored in the section contents.
+ */
+
+#define	_MERGE_SHARD_BITS	6
+#define	_MERGE_SHARDS		(1 << _MERGE_SHARD_BITS)
+
+struct ld_merge_piece {
+	const uint8_t *mp_data;		/* piece contents */
+	uint64_t mp_size;		/* piece size, including terminator */
+	uint64_t mp_hash;		/* hash of the contents */
+	uint64_t mp_off;		/* offset in the merged section */
+	size_t mp_rep;			/* index of the piece kept */
+	size_t mp_owner;		/* index of the enclosing string */
+};
+
+struct ld_merge_group {
+	uint64_t mg_flags;		/* SHF_MERGE and SHF_STRINGS */
+	uint64_t mg_entsize;		/* entry size */
+	uint64_t mg_align;		/* alignment */
+	struct ld_input_section **mg_is; /* sections of the group */
+	size_t mg_num;			/* number of sections */
+	size_t mg_cap;			/* capacity of mg_is */
+};
+
+/*
+ * Work shared by the merging threads.  Thread i hashes the i-th part
+ * of the pieces, and then fills shards i, i + n, i + 2n, ...
+ */
+struct ld_merge_job {
+	struct ld_merge_piece *mj_p;	/* pieces */
+	size_t mj_num;			/* number of pieces */
+	size_t *mj_order;		/* piece indices, sorted by shard */
+	size_t *mj_shard;		/* start of each shard in mj_order */
+	size_t mj_first;		/* first share of the thread */
+	size_t mj_stride;		/* number of threads */
+	size_t *mj_tbl;			/* hash table of the thread */
+};
+
+static int _cmp_tail(const void *a, const void *b);
+static void *_dedup_shards(void *arg);
+static void *_hash_pieces(void *arg);
+static void _merge_group(struct ld *ld, struct ld_merge_group *mg);
+static int _mergeable(struct ld *ld, struct ld_input_section *is);
+static void _rewrite_relocs(struct ld *ld, int check);
+static void _run_jobs(struct ld *ld, struct ld_merge_job *mj, size_t n,
+    void *(*func)(void *));
+static uint64_t _split(struct ld_merge_group *mg, const uint8_t *p,
+    uint64_t size, struct ld_merge_piece *mp);
+
+void
+ld_merge_sections(struct ld *ld)
+{
+	struct ld_output *lo;
+	struct ld_output_section *os;
+	struct ld_output_element *oe;
+	struct ld_input_section *is;
+	struct ld_input_section_head *islist;
+	struct ld_input *li;
+	struct ld_merge_group *mg;
+	size_t i, ng, cap;
+	int found;
+
+	if (ld->ld_reloc || ld->ld_emit_reloc || !ld->ld_arch->reloc_is_rela)
+		return;
+
+	lo = ld->ld_output;
+	assert(lo != NULL);
+
+	/* Find the input sections which can be merged. */
+	found = 0;
+	STAILQ_FOREACH(os, &lo->lo_oslist, os_next) {
+		STAILQ_FOREACH(oe, &os->os_e, oe_next) {
+			if (oe->oe_type != OET_INPUT_SECTION_LIST ||
+			    (islist = oe->oe_islist) == NULL)
+				continue;
+			STAILQ_FOREACH(is, islist, is_next) {
+				if (_mergeable(ld, is)) {
+					is->is_merge = ld_arena_calloc(ld, 1,
+					    sizeof(*is->is_merge));
+					found = 1;
+				}
+			}
+		}
+	}
+	if (!found)
+		goto done;
+
+	/*
+	 * A relocation against a section symbol may refer to a location
+	 * outside of the section it names, and such a section can not be
+	 * taken apart.
+	 */
+	_rewrite_relocs(ld, 1);
+
+	mg = NULL;
+	cap = 0;
+	STAILQ_FOREACH(os, &lo->lo_oslist, os_next) {
+		ng = 0;
+		STAILQ_FOREACH(oe, &os->os_e, oe_next) {
+			if (oe->oe_type != OET_INPUT_SECTION_LIST ||
+			    (islist = oe->oe_islist) == NULL)
+				continue;
+			STAILQ_FOREACH(is, islist, is_next) {
+				if (is->is_merge == NULL)
+					continue;
+				for (i = 0; i < ng; i++) {
+					if (mg[i].mg_flags == (is->is_flags &
+					    (SHF_MERGE | SHF_STRINGS)) &&
+					    mg[i].mg_entsize == is->is_entsize &&
+					    mg[i].mg_align == is->is_align)
+						break;
+				}
+				if (i == ng) {
+					if (ng == cap) {
+						cap = cap ? cap * 2 : 4;
+						if ((mg = realloc(mg, cap *
+						    sizeof(*mg))) == NULL)
+							ld_fatal_std(ld,
+							    "realloc");
+					}
+					memset(&mg[ng], 0, sizeof(*mg));
+					mg[ng].mg_flags = is->is_flags &
+					    (SHF_MERGE | SHF_STRINGS);
+					mg[ng].mg_entsize = is->is_entsize;
+					mg[ng].mg_align = is->is_align;
+					ng++;
+				}
+				if (mg[i].mg_num == mg[i].mg_cap) {
+					mg[i].mg_cap = mg[i].mg_cap ?
+					    mg[i].mg_cap * 2 : 16;
+					if ((mg[i].mg_is = realloc(mg[i].mg_is,
+					    mg[i].mg_cap * sizeof(*mg[i].mg_is)))
+					    == NULL)
+						ld_fatal_std(ld, "realloc");
+				}
+				mg[i].mg_is[mg[i].mg_num++] = is;
+			}
+		}
+		for (i = 0; i < ng; i++) {
+			_merge_group(ld, &mg[i]);
+			free(mg[i].mg_is);
+		}
+	}
+	free(mg);
+
+	_rewrite_relocs(ld, 0);
+
+done:
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		if (li->li_file != NULL && li->li_elf != NULL)
+			ld_input_unload(ld, li);
+	}
+}
+
+/*
+ * Translate the offset `off' in the input section `is' to an offset
+ * in the leader of its merge group.
+ */
+uint64_t
+ld_merge_offset(struct ld_input_section *is, uint64_t off)
+{
+	struct ld_merge_section *ms;
+	size_t l, h, m;
+
+	ms = is->is_merge;
+	assert(ms != NULL && ms->ms_num > 0);
+
+	l = 0;
+	h = ms->ms_num;
+	while (h - l > 1) {
+		m = l + (h - l) / 2;
+		if (ms->ms_in[m] <= off)
+			l = m;
+		else
+			h = m;
+	}
+
+	return (ms->ms_out[l] + (off - ms->ms_in[l]));
+}
+
+static int
+_mergeable(struct ld *ld, struct ld_input_section *is)
+{
+	struct ld_input *li;
+	const uint8_t *p;
+	uint64_t i;
+
+	if ((is->is_flags & SHF_MERGE) == 0 || is->is_type != SHT_PROGBITS ||
+	    is->is_discard || is->is_entsize == 0 || is->is_size == 0 ||
+	    is->is_size % is->is_entsize != 0 || is->is_ris != NULL ||
+	    is->is_ibuf != NULL)
+		return (0);
+
+	li = is->is_input;
+	if (li->li_file == NULL)
+		return (0);
+	if (li->li_elf == NULL)
+		ld_input_load(ld, li);
+
+	if ((p = ld_input_get_section_rawdata(ld, is)) == NULL)
+		return (0);
+
+	/* A string section must end with a terminator. */
+	if (is->is_flags & SHF_STRINGS) {
+		for (i = is->is_size - is->is_entsize; i < is->is_size; i++)
+			if (p[i] != 0)
+				return (0);
+	}
+
+	return (1);
+}
+
+/*
+ * Walk all relocations against section symbols of merged sections.
+ * When `check' is set, sections referred to at offsets outside of
+ * them are excluded from merging; otherwise the addends are rewritten
+ * to offsets in the merged section.
+ */
+static void
+_rewrite_relocs(struct ld *ld, int check)
+{
+	struct ld_input *li;
+	struct ld_input_section *is, *tis;
+	struct ld_reloc_entry *lre;
+	struct ld_symbol *lsb;
+	uint64_t i, j, off;
+
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		for (i = 0; i < li->li_shnum; i++) {
+			is = &li->li_is[i];
+			for (j = 0; j < is->is_num_reloc; j++) {
+				lre = &is->is_reloc[j];
+				if ((lsb = lre->lre_sym) == NULL ||
+				    lsb->lsb_type != STT_SECTION ||
+				    (tis = lsb->lsb_is) == NULL ||
+				    tis->is_merge == NULL)
+					continue;
+				off = lsb->lsb_value + lre->lre_addend;
+				if (check) {
+					if (off >= tis->is_size)
+						tis->is_merge = NULL;
+				} else
+					lre->lre_addend = ld_merge_offset(tis,
+					    off);
+			}
+		}
+	}
+}
+
+static uint64_t
+_split(struct ld_merge_group *mg, const uint8_t *p, uint64_t size,
+    struct ld_merge_piece *mp)
+{
+	uint64_t e, i, j, n, start;
+
+	e = mg->mg_entsize;
+	if ((mg->mg_flags & SHF_STRINGS) == 0) {
+		n = size / e;
+		if (mp != NULL) {
+			for (i = 0; i < n; i++) {
+				mp[i].mp_data = p + i * e;
+				mp[i].mp_size = e;
+			}
+		}
+		return (n);
+	}
+
+	n = 0;
+	start = 0;
+	for (i = 0; i < size; i += e) {
+		for (j = 0; j < e; j++)
+			if (p[i + j] != 0)
+				break;
+		if (j < e)
+			continue;
+		if (mp != NULL) {
+			mp[n].mp_data = p + start;
+			mp[n].mp_size = i + e - start;
+		}
+		n++;
+		start = i + e;
+	}
+
+	return (n);
+}
+
+static void
+_merge_group(struct ld *ld, struct ld_merge_group *mg)
+{
+	struct ld_input_section *is, *leader;
+	struct ld_merge_section *ms;
+	struct ld_merge_piece *mp, **tail, *owner;
+	struct ld_merge_job *mj;
+	const uint8_t *base;
+	uint8_t *buf;
+	uint64_t insize, off, size;
+	size_t *first, *shard, *order;
+	size_t i, j, k, n, np, nt, nthr, tsize;
+
+	/* Cut the sections into pieces. */
+	if ((first = malloc((mg->mg_num + 1) * sizeof(*first))) == NULL)
+		ld_fatal_std(ld, "malloc");
+	np = 0;
+	for (i = 0; i < mg->mg_num; i++) {
+		is = mg->mg_is[i];
+		first[i] = np;
+		np += _split(mg, ld_input_get_section_rawdata(ld, is),
+		    is->is_size, NULL);
+	}
+	first[mg->mg_num] = np;
+	if ((mp = calloc(np, sizeof(*mp))) == NULL)
+		ld_fatal_std(ld, "calloc");
+	for (i = 0; i < mg->mg_num; i++) {
+		is = mg->mg_is[i];
+		(void) _split(mg, ld_input_get_section_rawdata(ld, is),
+		    is->is_size, &mp[first[i]]);
+	}
+
+	nthr = MAX(1, MIN(ld->ld_threads, _MERGE_SHARDS));
+	if (np < nthr)
+		nthr = 1;
+	if ((mj = calloc(nthr, sizeof(*mj))) == NULL)
+		ld_fatal_std(ld, "calloc");
+	if ((order = malloc(np * sizeof(*order))) == NULL ||
+	    (shard = calloc(_MERGE_SHARDS + 1, sizeof(*shard))) == NULL)
+		ld_fatal_std(ld, "malloc");
+	for (i = 0; i < nthr; i++) {
+		mj[i].mj_p = mp;
+		mj[i].mj_num = np;
+		mj[i].mj_order = order;
+		mj[i].mj_shard = shard;
+		mj[i].mj_first = i;
+		mj[i].mj_stride = nthr;
+	}
+
+	_run_jobs(ld, mj, nthr, _hash_pieces);
+
+	/* Sort the pieces by shard, keeping them in input order. */
+	for (i = 0; i < np; i++)
+		shard[(mp[i].mp_hash >> (64 - _MERGE_SHARD_BITS)) + 1]++;
+	for (i = 0; i < _MERGE_SHARDS; i++)
+		shard[i + 1] += shard[i];
+	for (i = 0; i < np; i++)
+		order[shard[mp[i].mp_hash >> (64 - _MERGE_SHARD_BITS)]++] = i;
+	for (i = _MERGE_SHARDS; i > 0; i--)
+		shard[i] = shard[i - 1];
+	shard[0] = 0;
+
+	/*
+	 * Each thread gets an open addressing table of at least twice
+	 * the number of pieces in the largest shard.
+	 */
+	for (i = 0, n = 0; i < _MERGE_SHARDS; i++)
+		n = MAX(n, shard[i + 1] - shard[i]);
+	for (tsize = 1; tsize < 2 * n; tsize <<= 1)
+		;
+	for (i = 0; i < nthr; i++) {
+		if ((mj[i].mj_tbl = malloc(tsize * sizeof(size_t))) == NULL)
+			ld_fatal_std(ld, "malloc");
+	}
+
+	_run_jobs(ld, mj, nthr, _dedup_shards);
+
+	for (i = 0; i < nthr; i++)
+		free(mj[i].mj_tbl);
+
+	for (i = 0; i < np; i++)
+		mp[i].mp_owner = i;
+
+	/*
+	 * Find strings which are the tail of another string.  With the
+	 * strings sorted by their reversed contents, a string which is
+	 * a tail of another one sorts right before it, or before other
+	 * tails of it.  Tail merging is not done when the alignment of
+	 * the section is larger than its entry size, since a tail might
+	 * then end up misaligned.
+	 */
+	if ((mg->mg_flags & SHF_STRINGS) && mg->mg_align <= mg->mg_entsize) {
+		if ((tail = malloc(np * sizeof(*tail))) == NULL)
+			ld_fatal_std(ld, "malloc");
+		for (i = 0, nt = 0; i < np; i++)
+			if (mp[i].mp_rep == i)
+				tail[nt++] = &mp[i];
+		qsort(tail, nt, sizeof(*tail), _cmp_tail);
+		owner = NULL;
+		for (k = nt; k > 0; k--) {
+			if (owner != NULL &&
+			    tail[k - 1]->mp_size <= owner->mp_size &&
+			    memcmp(tail[k - 1]->mp_data, owner->mp_data +
+			    owner->mp_size - tail[k - 1]->mp_size,
+			    tail[k - 1]->mp_size) == 0)
+				tail[k - 1]->mp_owner = owner - mp;
+			else
+				owner = tail[k - 1];
+		}
+		free(tail);
+	}
+
+	/* Lay out the strings kept, in the order they first appear. */
+	off = 0;
+	for (i = 0; i < np; i++) {
+		if (mp[i].mp_rep != i || mp[i].mp_owner != i)
+			continue;
+		off = roundup(off, mg->mg_align);
+		mp[i].mp_off = off;
+		off += mp[i].mp_size;
+	}
+	size = off;
+	for (i = 0; i < np; i++) {
+		if (mp[i].mp_rep == i && mp[i].mp_owner != i) {
+			j = mp[i].mp_owner;
+			mp[i].mp_off = mp[j].mp_off + mp[j].mp_size -
+			    mp[i].mp_size;
+		}
+	}
+	for (i = 0; i < np; i++)
+		mp[i].mp_off = mp[mp[i].mp_rep].mp_off;
+
+	if ((buf = calloc(1, size)) == NULL)
+		ld_fatal_std(ld, "calloc");
+	for (i = 0; i < np; i++)
+		if (mp[i].mp_rep == i && mp[i].mp_owner == i)
+			memcpy(buf + mp[i].mp_off, mp[i].mp_data,
+			    mp[i].mp_size);
+
+	/* Record the offset map of each section. */
+	leader = mg->mg_is[0];
+	insize = 0;
+	for (i = 0; i < mg->mg_num; i++) {
+		is = mg->mg_is[i];
+		base = ld_input_get_section_rawdata(ld, is);
+		ms = is->is_merge;
+		ms->ms_leader = leader;
+		ms->ms_num = n = first[i + 1] - first[i];
+		ms->ms_in = ld_arena_calloc(ld, n, sizeof(*ms->ms_in));
+		ms->ms_out = ld_arena_calloc(ld, n, sizeof(*ms->ms_out));
+		for (j = 0; j < n; j++) {
+			ms->ms_in[j] = mp[first[i] + j].mp_data - base;
+			ms->ms_out[j] = mp[first[i] + j].mp_off;
+		}
+		insize += is->is_size;
+		if (is != leader) {
+			is->is_size = 0;
+			is->is_need_reloc = 0;
+		}
+	}
+	leader->is_merge->ms_insize = insize;
+	leader->is_merge->ms_nsec = mg->mg_num;
+	leader->is_ibuf = buf;
+	leader->is_size = size;
+
+	free(shard);
+	free(order);
+	free(mj);
+	free(mp);
+	free(first);
+}
+
+static void
+_run_jobs(struct ld *ld, struct ld_merge_job *mj, size_t n,
+    void *(*func)(void *))
+{
+	pthread_t *tid;
+	size_t i;
+	int error;
+
+	if ((tid = calloc(n, sizeof(*tid))) == NULL)
+		ld_fatal_std(ld, "calloc");
+
+	/* This thread does the first share of the work. */
+	for (i = 1; i < n; i++) {
+		if ((error = pthread_create(&tid[i], NULL, func, &mj[i])) !=
+		    0) {
+			errno = error;
+			ld_fatal_std(ld, "pthread_create");
+		}
+	}
+	(void) func(&mj[0]);
+	for (i = 1; i < n; i++)
+		(void) pthread_join(tid[i], NULL);
+
+	free(tid);
+}
+
+static void *
+_hash_pieces(void *arg)
+{
+	struct ld_merge_job *mj;
+	struct ld_merge_piece *mp;
+	size_t i, end;
+
+	mj = arg;
+	i = mj->mj_num / mj->mj_stride * mj->mj_first;
+	end = mj->mj_first + 1 == mj->mj_stride ? mj->mj_num :
+	    mj->mj_num / mj->mj_stride * (mj->mj_first + 1);
+	for (; i < end; i++) {
+		mp = &mj->mj_p[i];
+		mp->mp_hash = ld_hash_xxh64(mp->mp_data, mp->mp_size);
+	}
+
+	return (NULL);
+}
+
+static void *
+_dedup_shards(void *arg)
+{
+	struct ld_merge_job *mj;
+	struct ld_merge_piece *mp, *_mp;
+	size_t *tbl, i, k, n, mask, pos;
+
+	mj = arg;
+	for (k = mj->mj_first; k < _MERGE_SHARDS; k += mj->mj_stride) {
+		n = mj->mj_shard[k + 1] - mj->mj_shard[k];
+		if (n == 0)
+			continue;
+
+		/* Table entries hold piece index + 1. */
+		for (mask = 1; mask < 2 * n; mask <<= 1)
+			;
+		tbl = mj->mj_tbl;
+		memset(tbl, 0, mask * sizeof(*tbl));
+		mask--;
+
+		for (i = mj->mj_shard[k]; i < mj->mj_shard[k + 1]; i++) {
+			mp = &mj->mj_p[mj->mj_order[i]];
+			mp->mp_rep = mj->mj_order[i];
+			for (pos = mp->mp_hash & mask; tbl[pos] != 0;
+			     pos = (pos + 1) & mask) {
+				_mp = &mj->mj_p[tbl[pos] - 1];
+				if (_mp->mp_hash == mp->mp_hash &&
+				    _mp->mp_size == mp->mp_size &&
+				    memcmp(_mp->mp_data, mp->mp_data,
+				    mp->mp_size) == 0) {
+					mp->mp_rep = tbl[pos] - 1;
+					break;
+				}
+			}
+			if (tbl[pos] == 0)
+				tbl[pos] = mj->mj_order[i] + 1;
+		}
+	}
+
+	return (NULL);
+}
+
+/*
+ * Compare two strings by their reversed contents.
+ */
+static int
+_cmp_tail(const void *a, const void *b)
+{
+	const struct ld_merge_piece *ma, *mb;
+	const uint8_t *pa, *pb;
+	uint64_t i, n;
+
+	ma = *(const struct ld_merge_piece * const *) a;
+	mb = *(const struct ld_merge_piece * const *) b;
+	pa = ma->mp_data + ma->mp_size;
+	pb = mb->mp_data + mb->mp_size;
+	n = MIN(ma->mp_size, mb->mp_size);
+	for (i = 1; i <= n; i++) {
+		if (pa[-i] != pb[-i])
+			return (pa[-i] < pb[-i] ? -1 : 1);
+	}
+	if (ma->mp_size != mb->mp_size)
+		return (ma->mp_size < mb->mp_size ? -1 : 1);
+
+	return (0);
+}
@@ -25,7 +25,9 @@
  */
 
 #include "ld.h"
+#include "ld_build_id.h"
 #include "ld_file.h"
+#include "ld_icf.h"
 #include "ld_path.h"
 #include "ld_script.h"
 #include "ld_symbols.h"
@@ -74,12 +76,14 @@ static struct ld_option ld_opts[] = {
 	{"emulation", 'm', ANY_DASH, REQ_ARG},
 	{"enable-new-dtags", KEY_ENABLE_NEW_DTAGS, ANY_DASH, NO_ARG},
 	{"fatal-warnings", KEY_FATAL_WARNINGS, ANY_DASH, NO_ARG},
+	{"file-cache-size", KEY_FILE_CACHE_SIZE, ANY_DASH, REQ_ARG},
 	{"filter", 'F', ANY_DASH, NO_ARG},
 	{"fini", KEY_FINI, ANY_DASH, NO_ARG},
 	{"format", 'b', ANY_DASH, REQ_ARG},
 	{"gc-sections", KEY_GC_SECTIONS, ANY_DASH, NO_ARG},
 	{"hash-style", KEY_HASH_STYLE, ANY_DASH, REQ_ARG},
 	{"help", KEY_HELP, ANY_DASH, NO_ARG},
+	{"icf", KEY_ICF, ANY_DASH, REQ_ARG},
 	{"init", KEY_INIT, ANY_DASH, REQ_ARG},
 	{"just-symbols", 'R', ANY_DASH, REQ_ARG},
 	{"library", 'l', ANY_DASH, REQ_ARG},
@@ -108,6 +112,7 @@ static struct ld_option ld_opts[] = {
 	{"pic-executable", KEY_PIE, ANY_DASH, NO_ARG},
 	{"pie", KEY_PIE, ONE_DASH, NO_ARG},
 	{"print-gc-sections", KEY_PRINT_GC_SECTIONS, ANY_DASH, NO_ARG},
+	{"print-icf-sections", KEY_PRINT_ICF_SECTIONS, ANY_DASH, NO_ARG},
 	{"print-map", 'M', ANY_DASH, NO_ARG},
 	{"qmagic", KEY_QMAGIC, ANY_DASH, NO_ARG},
 	{"relax", KEY_RELAX, ANY_DASH, NO_ARG},
@@ -128,6 +133,7 @@ static struct ld_option ld_opts[] = {
 	{"static", KEY_STATIC, ONE_DASH, NO_ARG},
 	{"strip-all", 's', ANY_DASH, NO_ARG},
 	{"strip-debug", 'S', ANY_DASH, NO_ARG},
+	{"threads", KEY_THREADS, ANY_DASH, REQ_ARG},
 	{"trace", 't', ANY_DASH, NO_ARG},
 	{"trace_symbol", 'y', ANY_DASH, NO_ARG},
 	{"traditional-format", KEY_TRADITIONAL_FORMAT, ANY_DASH, NO_ARG},
@@ -186,6 +192,9 @@ static struct ld_option ld_opts_z[] = {
 	{"ignore", KEY_Z_IGNORE, ONE_DASH, NO_ARG},
 	{"record", KEY_Z_RECORD, ONE_DASH, NO_ARG},
 	{"systemlibrary", KEY_Z_SYSTEM_LIBRARY, ONE_DASH, NO_ARG},
+	{"pack-relative-relocs", KEY_Z_PACK_RELATIVE_RELOCS, ONE_DASH, NO_ARG},
+	{"nopack-relative-relocs", KEY_Z_NO_PACK_RELATIVE_RELOCS, ONE_DASH,
+	    NO_ARG},
 };
 
 static void _copy_optarg(struct ld *ld, char **dst, char *src);
@@ -330,6 +339,8 @@ static void
 _process_options(struct ld *ld, int key, char *arg)
 {
 	struct ld_state *ls;
+	unsigned long n;
+	char *end;
 
 	assert(ld != NULL);
 	ls = &ld->ld_state;
@@ -391,15 +402,48 @@ _process_options(struct ld *ld, int key, char *arg)
 	case KEY_AS_NEEDED:
 		ls->ls_as_needed = 1;
 		break;
+	case KEY_BUILD_ID:
+		ld_build_id_set_style(ld, arg);
+		break;
 	case KEY_DYNAMIC:
 		ls->ls_static = 0;
 		break;
 	case KEY_EH_FRAME_HDR:
 		ld->ld_ehframe_hdr = 1;
 		break;
+	case KEY_FILE_CACHE_SIZE:
+		/* The budget is given in megabytes. */
+		errno = 0;
+		n = strtoul(arg, &end, 10);
+		if (errno != 0 || *arg == '\0' || *end != '\0' ||
+		    n > UINT64_MAX >> 20)
+			ld_fatal(ld, "invalid file cache size: %s", arg);
+		ld->ld_file_cache_size = (uint64_t) n << 20;
+		break;
 	case KEY_GC_SECTIONS:
 		ld->ld_gc = 1;
 		break;
+	case KEY_HASH_STYLE:
+		if (!strcmp(arg, "sysv"))
+			ld->ld_hash_style = LD_HASH_STYLE_SYSV;
+		else if (!strcmp(arg, "gnu"))
+			ld->ld_hash_style = LD_HASH_STYLE_GNU;
+		else if (!strcmp(arg, "both"))
+			ld->ld_hash_style = LD_HASH_STYLE_SYSV |
+			    LD_HASH_STYLE_GNU;
+		else
+			ld_fatal(ld, "unknown hash style: %s", arg);
+		break;
+	case KEY_ICF:
+		if (!strcmp(arg, "none"))
+			ld->ld_icf = LD_ICF_NONE;
+		else if (!strcmp(arg, "safe"))
+			ld->ld_icf = LD_ICF_SAFE;
+		else if (!strcmp(arg, "all"))
+			ld->ld_icf = LD_ICF_ALL;
+		else
+			ld_fatal(ld, "unknown ICF mode: %s", arg);
+		break;
 	case KEY_NO_AS_NEEDED:
 		ls->ls_as_needed = 0;
 		break;
@@ -426,6 +470,9 @@ _process_options(struct ld *ld, int key, char *arg)
 	case KEY_PRINT_GC_SECTIONS:
 		ld->ld_gc_print = 1;
 		break;
+	case KEY_PRINT_ICF_SECTIONS:
+		ld->ld_icf_print = 1;
+		break;
 	case KEY_RPATH:
 		ld_path_add_multiple(ld, arg, LPT_RPATH);
 		break;
@@ -440,6 +487,17 @@ _process_options(struct ld *ld, int key, char *arg)
 	case KEY_STATIC:
 		ls->ls_static = 1;
 		break;
+	case KEY_STATS:
+		ld->ld_stats = 1;
+		break;
+	case KEY_THREADS:
+		errno = 0;
+		n = strtoul(arg, &end, 10);
+		if (errno != 0 || *arg == '\0' || *end != '\0' || n == 0 ||
+		    n > LD_MAX_THREADS)
+			ld_fatal(ld, "invalid number of threads: %s", arg);
+		ld->ld_threads = n;
+		break;
 	case KEY_WHOLE_ARCHIVE:
 		ls->ls_whole_archive = 1;
 		break;
@@ -459,6 +517,12 @@ _process_options(struct ld *ld, int key, char *arg)
 		ld->ld_stack_exec_set = 1;
 		ld->ld_stack_exec = 0;
 		break;
+	case KEY_Z_PACK_RELATIVE_RELOCS:
+		ld->ld_relr = 1;
+		break;
+	case KEY_Z_NO_PACK_RELATIVE_RELOCS:
+		ld->ld_relr = 0;
+		break;
 	default:
 		break;
 	}
@@ -56,11 +56,13 @@ enum ld_key {
 	KEY_ENABLE_NEW_DTAGS,
 	KEY_ERR_UNRESOLVE_SYM,
 	KEY_FATAL_WARNINGS,
+	KEY_FILE_CACHE_SIZE,
 	KEY_FINI,
 	KEY_GC_SECTIONS,
 	KEY_GROUP,
 	KEY_HASH_STYLE,
 	KEY_HELP,
+	KEY_ICF,
 	KEY_INIT,
 	KEY_MAP,
 	KEY_NO_AS_NEEDED,
@@ -84,6 +86,7 @@ enum ld_key {
 	KEY_OFORMAT,
 	KEY_PIE,
 	KEY_PRINT_GC_SECTIONS,
+	KEY_PRINT_ICF_SECTIONS,
 	KEY_QMAGIC,
 	KEY_QY,
 	KEY_RELAX,
@@ -98,6 +101,7 @@ enum ld_key {
 	KEY_SYMBOLIC_FUNC,
 	KEY_TBSS,
 	KEY_TDATA,
+	KEY_THREADS,
 	KEY_TTEXT,
 	KEY_TRADITIONAL_FORMAT,
 	KEY_UNRESOLVED_SYMBOLS,
@@ -129,6 +133,8 @@ enum ld_key {
 	KEY_Z_NO_EXEC_STACK,
 	KEY_Z_NO_LAZYLOAD,
 	KEY_Z_ORIGIN,
+	KEY_Z_PACK_RELATIVE_RELOCS,
+	KEY_Z_NO_PACK_RELATIVE_RELOCS,
 	KEY_Z_RECORD,
 	KEY_Z_SYSTEM_LIBRARY,
 	KEY_Z_WEAK_EXTRACT,
@@ -26,8 +26,10 @@
 
 #include "ld.h"
 #include "ld_arch.h"
+#include "ld_build_id.h"
 #include "ld_dynamic.h"
 #include "ld_ehframe.h"
+#include "ld_file.h"
 #include "ld_input.h"
 #include "ld_output.h"
 #include "ld_layout.h"
@@ -48,7 +50,9 @@ static void _alloc_section_data_for_symtab(struct ld *ld,
 static void _alloc_section_data_for_strtab(struct ld *ld, Elf_Scn *scn,
     struct ld_strtab *strtab);
 static void _add_to_shstrtab(struct ld *ld, const char *name);
+static void _copy_and_reloc_input(struct ld *ld, struct ld_input *li);
 static void _copy_and_reloc_input_sections(struct ld *ld);
+static void *_copy_and_reloc_worker(void *arg);
 static Elf_Scn *_create_elf_scn(struct ld *ld, struct ld_output *lo,
     struct ld_output_section *os);
 static void _create_elf_section(struct ld *ld, struct ld_output_section *os);
@@ -96,7 +100,11 @@ ld_output_init(struct ld *ld)
 	else
 		fn = ld->ld_output_file;
 
-	lo->lo_fd = open(fn, O_WRONLY | O_CREAT, S_IRWXU | S_IRWXG | S_IRWXO);
+	/*
+	 * The output file is opened for reading too, so that libelf can
+	 * map it in and assemble its contents in place.
+	 */
+	lo->lo_fd = open(fn, O_RDWR | O_CREAT, S_IRWXU | S_IRWXG | S_IRWXO);
 	if (lo->lo_fd < 0)
 		ld_fatal_std(ld, "can not create output file: open %s", fn);
 
@@ -410,7 +418,7 @@ _alloc_section_data_for_strtab(struct ld *ld, Elf_Scn *scn,
 	size_t sz;
 
 	buf = ld_strtab_getbuf(ld, strtab);
-	sz = ld_strtab_getsize(strtab);
+	sz = ld_strtab_getsize(ld, strtab);
 	if (buf == NULL || sz == 0)
 		return;
 
@@ -426,55 +434,221 @@ _alloc_section_data_for_strtab(struct ld *ld, Elf_Scn *scn,
 }
 
 static void
-_copy_and_reloc_input_sections(struct ld *ld)
+_copy_and_reloc_input(struct ld *ld, struct ld_input *li)
 {
-	struct ld_input *li;
 	struct ld_input_section *is;
 	Elf_Data *d;
 	int i;
 
-	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
-		ld_input_load(ld, li);
-		for (i = 0; (uint64_t) i < li->li_shnum; i++) {
-			is = &li->li_is[i];
+	for (i = 0; (uint64_t) i < li->li_shnum; i++) {
+		is = &li->li_is[i];
 
-			if (is->is_discard || !is->is_need_reloc)
-				continue;
+		if (is->is_discard || !is->is_need_reloc)
+			continue;
 
-			d = is->is_data;
+		d = is->is_data;
 
-			d->d_align = is->is_align;
-			d->d_off = is->is_reloff;
-			d->d_type = ELF_T_BYTE;
-			d->d_size = is->is_size;
-			d->d_version = EV_CURRENT;
+		d->d_align = is->is_align;
+		d->d_off = is->is_reloff;
+		d->d_type = ELF_T_BYTE;
+		d->d_size = is->is_size;
+		d->d_version = EV_CURRENT;
 
-			/*
-			 * Take different actions depending on different types
-			 * of input sections:
-			 *
-			 * For internal input sections, assign the internal
-			 * buffer directly to the data descriptor.
-			 * For relocation sections, they should be ignored
-			 * since they are handled elsewhere.
-			 * For other input sections, load the raw data from
-			 * input object and preform relocation.
-			 */
-			if (is->is_ibuf != NULL) {
-				d->d_buf = is->is_ibuf;
-				/* .eh_frame section needs relocation */
-				if (strcmp(is->is_name, ".eh_frame") == 0)
-					ld_reloc_process_input_section(ld, is,
-					    d->d_buf);
-			} else if (is->is_reloc == NULL) {
-				d->d_buf = ld_input_get_section_rawdata(ld,
-				    is);
+		/*
+		 * Take different actions depending on different types
+		 * of input sections:
+		 *
+		 * For internal input sections, assign the internal
+		 * buffer directly to the data descriptor.
+		 * For relocation sections, they should be ignored
+		 * since they are handled elsewhere.
+		 * For other input sections, load the raw data from
+		 * input object and preform relocation.
+		 */
+		if (is->is_ibuf != NULL) {
+			d->d_buf = is->is_ibuf;
+			/* .eh_frame section needs relocation */
+			if (strcmp(is->is_name, ".eh_frame") == 0)
 				ld_reloc_process_input_section(ld, is,
 				    d->d_buf);
-			}
+		} else if (is->is_reloc == NULL) {
+			d->d_buf = ld_input_get_section_rawdata(ld, is);
+			ld_reloc_process_input_section(ld, is, d->d_buf);
 		}
+	}
+}
+
+/*
+ * Once the sections of an input object are copied and relocated, the
+ * data descriptors of the output sections point into its file image.
+ * While the mapped input files fit into the file cache budget, the
+ * input object stays loaded until the output object is written.
+ * Beyond the budget, its section contents are copied out of the file
+ * image so that it can be unloaded and the file unmapped.
+ */
+static int
+_input_over_budget(struct ld *ld, struct ld_input *li)
+{
+
+	return (li->li_file != NULL &&
+	    ld->ld_fc->fc_size > ld->ld_file_cache_size);
+}
+
+static int
+_data_in_file_image(struct ld_input_section *is)
+{
+	Elf_Data *d;
+
+	if (is->is_discard || !is->is_need_reloc || is->is_ibuf != NULL ||
+	    is->is_reloc != NULL)
+		return (0);
+
+	d = is->is_data;
+
+	return (d->d_buf != NULL);
+}
+
+static void
+_copy_out_input(struct ld *ld, struct ld_input *li)
+{
+	struct ld_input_section *is;
+	Elf_Data *d;
+	uint64_t i, sz;
+	char *p;
+
+	sz = 0;
+	for (i = 0; i < li->li_shnum; i++) {
+		is = &li->li_is[i];
+		if (_data_in_file_image(is)) {
+			d = is->is_data;
+			sz += d->d_size;
+		}
+	}
+	if (sz == 0)
+		return;
+
+	if ((li->li_data = malloc(sz)) == NULL)
+		ld_fatal_std(ld, "malloc");
+
+	p = li->li_data;
+	for (i = 0; i < li->li_shnum; i++) {
+		is = &li->li_is[i];
+		if (!_data_in_file_image(is))
+			continue;
+		d = is->is_data;
+		memcpy(p, d->d_buf, d->d_size);
+		d->d_buf = p;
+		p += d->d_size;
+	}
+}
+
+/*
+ * State shared by the threads started by --threads.  Each thread
+ * repeatedly claims the next unprocessed input object; every input
+ * section is written by exactly one thread, so the output does not
+ * depend on the number of threads used.
+ */
+struct ld_reloc_pool {
+	struct ld *rp_ld;
+	struct ld_input *rp_next;	/* next input object to claim */
+	pthread_mutex_t rp_mutex;	/* protects rp_next, file cache */
+};
+
+static void *
+_copy_and_reloc_worker(void *arg)
+{
+	struct ld_reloc_pool *rp;
+	struct ld_input *li;
+	struct ld *ld;
+	int release;
+
+	rp = arg;
+	ld = rp->rp_ld;
+	for (;;) {
+		/*
+		 * Loading and unloading an input object update the
+		 * state of the file that contains it, which archive
+		 * members share, and of the file cache.
+		 */
+		(void) pthread_mutex_lock(&rp->rp_mutex);
+		if ((li = rp->rp_next) != NULL) {
+			rp->rp_next = STAILQ_NEXT(li, li_next);
+			ld_input_load(ld, li);
+		}
+		(void) pthread_mutex_unlock(&rp->rp_mutex);
+		if (li == NULL)
+			break;
+
+		_copy_and_reloc_input(ld, li);
+
+		(void) pthread_mutex_lock(&rp->rp_mutex);
+		release = _input_over_budget(ld, li);
+		(void) pthread_mutex_unlock(&rp->rp_mutex);
+		if (!release)
+			continue;
+
+		_copy_out_input(ld, li);
+		(void) pthread_mutex_lock(&rp->rp_mutex);
 		ld_input_unload(ld, li);
+		(void) pthread_mutex_unlock(&rp->rp_mutex);
+	}
+
+	return (NULL);
+}
+
+static void
+_copy_and_reloc_input_sections(struct ld *ld)
+{
+	struct ld_reloc_pool rp;
+	struct ld_input *li;
+	pthread_t *tid;
+	size_t i, n;
+	int error;
+
+	if (ld->ld_threads <= 1) {
+		STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+			ld_input_load(ld, li);
+			_copy_and_reloc_input(ld, li);
+			if (_input_over_budget(ld, li)) {
+				_copy_out_input(ld, li);
+				ld_input_unload(ld, li);
+			}
+		}
+		return;
+	}
+
+	memset(&rp, 0, sizeof(rp));
+	rp.rp_ld = ld;
+	rp.rp_next = STAILQ_FIRST(&ld->ld_lilist);
+	n = 0;
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next)
+		n++;
+	if (n == 0)
+		return;
+
+	if ((error = pthread_mutex_init(&rp.rp_mutex, NULL)) != 0) {
+		errno = error;
+		ld_fatal_std(ld, "pthread_mutex_init");
 	}
+
+	/* This thread does its share of the work too. */
+	n = MIN(ld->ld_threads, n) - 1;
+	if ((tid = calloc(n + 1, sizeof(*tid))) == NULL)
+		ld_fatal_std(ld, "calloc");
+	for (i = 0; i < n; i++) {
+		if ((error = pthread_create(&tid[i], NULL,
+		    _copy_and_reloc_worker, &rp)) != 0) {
+			errno = error;
+			ld_fatal_std(ld, "pthread_create");
+		}
+	}
+	(void) _copy_and_reloc_worker(&rp);
+	for (i = 0; i < n; i++)
+		(void) pthread_join(tid[i], NULL);
+
+	(void) pthread_mutex_destroy(&rp.rp_mutex);
+
+	free(tid);
 }
 
 static void
@@ -889,6 +1063,7 @@ _create_phdr(struct ld *ld)
 void
 ld_output_create(struct ld *ld)
 {
+	struct ld_input *li;
 	struct ld_output *lo;
 	GElf_Ehdr eh;
 
@@ -921,6 +1096,10 @@ ld_output_create(struct ld *ld)
 	/* Join and sort dynamic relocation sections. */
 	_join_and_finalize_dynamic_reloc_sections(ld, lo);
 
+	/* Encode packed relative relocations. */
+	if (ld->ld_relr)
+		ld_reloc_finalize_relr(ld);
+
 	/* Finalize sections for dynamically linked output object. */
 	ld_dynamic_finalize(ld);
 
@@ -941,6 +1120,10 @@ ld_output_create(struct ld *ld)
 	if (ld->ld_ehframe_hdr)
 		ld_ehframe_finalize_hdr(ld);
 
+	/* Finalize .note.gnu.build-id section. */
+	if (ld->ld_build_id != LD_BUILD_ID_NONE)
+		ld_build_id_finalize(ld);
+
 	/*
 	 * Join normal relocation sections if the linker is creating a
 	 * relocatable object or if option -emit-relocs is specified.
@@ -961,6 +1144,22 @@ ld_output_create(struct ld *ld)
 	/* Finally write out the output ELF object. */
 	if (elf_update(lo->lo_elf, ELF_C_WRITE) < 0)
 		ld_fatal(ld, "elf_update failed: %s", elf_errmsg(-1));
+
+	/*
+	 * The data descriptors of the output sections point into the
+	 * file images of the input objects that are still loaded, or
+	 * to their copied out section contents.
+	 */
+	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
+		if (li->li_file != NULL && li->li_elf != NULL)
+			ld_input_unload(ld, li);
+		free(li->li_data);
+		li->li_data = NULL;
+	}
+
+	/* Hash the output file into the build ID. */
+	if (ld->ld_build_id != LD_BUILD_ID_NONE)
+		ld_build_id_compute(ld);
 }
 
 static void
@@ -997,7 +1196,7 @@ _update_section_header(struct ld *ld)
 			ld_fatal(ld, "gelf_getshdr failed: %s",
 			    elf_errmsg(-1));
 
-		sh.sh_name = ld_strtab_lookup(st, os->os_name);
+		sh.sh_name = ld_strtab_lookup(ld, st, os->os_name);
 		sh.sh_flags = os->os_flags;
 		sh.sh_addr = os->os_addr;
 		sh.sh_addralign = os->os_align;
@@ -1066,7 +1265,7 @@ _create_symbol_table(struct ld *ld)
 	if (gelf_getshdr(scn_symtab, &sh) == NULL)
 		ld_fatal(ld, "gelf_getshdr failed: %s", elf_errmsg(-1));
 
-	sh.sh_name = ld_strtab_lookup(st, ".symtab");
+	sh.sh_name = ld_strtab_lookup(ld, st, ".symtab");
 	sh.sh_flags = 0;
 	sh.sh_addr = 0;
 	sh.sh_addralign = (lo->lo_ec == ELFCLASS32) ? 4 : 8;
@@ -1127,18 +1326,18 @@ ld_output_create_string_table_section(struct ld *ld, const char *name,
 	if (gelf_getshdr(scn, &sh) == NULL)
 		ld_fatal(ld, "gelf_getshdr failed: %s", elf_errmsg(-1));
 
-	sh.sh_name = ld_strtab_lookup(ld->ld_shstrtab, name);
+	sh.sh_name = ld_strtab_lookup(ld, ld->ld_shstrtab, name);
 	sh.sh_flags = 0;
 	sh.sh_addr = 0;
 	sh.sh_addralign = 1;
 	sh.sh_offset = ls->ls_offset;
-	sh.sh_size = ld_strtab_getsize(st);
+	sh.sh_size = ld_strtab_getsize(ld, st);
 	sh.sh_type = SHT_STRTAB;
 
 	if (!gelf_update_shdr(scn, &sh))
 		ld_fatal(ld, "gelf_update_shdr failed: %s", elf_errmsg(-1));
 
-	sz = ld_strtab_getsize(st);
+	sz = ld_strtab_getsize(ld, st);
 
 	if ((d = elf_newdata(scn)) == NULL)
 		ld_fatal(ld, "elf_newdata failed: %s", elf_errmsg(-1));
@@ -59,7 +59,7 @@ struct ld_output_data_buffer {
 	uint64_t odb_type;		/* buffer data type */
 };
 
-struct ld_reloc_entry_head;
+struct ld_reloc_entry;
 struct ld_symbol;
 
 struct ld_output_section {
@@ -87,8 +87,9 @@ struct ld_output_section {
 					/* output section descriptor */
 	struct ld_output_element *os_pe;    /* parent element */
 	struct ld_output_element_head os_e; /* list of child elements */
-	struct ld_reloc_entry_head *os_reloc; /* list of relocations */
+	struct ld_reloc_entry *os_reloc; /* array of relocations */
 	uint64_t os_num_reloc;		/* number of relocations */
+	uint64_t os_cap_reloc;		/* capacity of os_reloc */
 	STAILQ_ENTRY(ld_output_section) os_next; /* next output section */
 	UT_hash_handle hh;		/* hash handle */
 };
@@ -131,6 +132,7 @@ struct ld_output {
 	struct ld_output_section *lo_dynsym; /* .dynsym section. */
 	struct ld_output_section *lo_dynstr; /* .dynstr section. */
 	struct ld_output_section *lo_hash; /* .hash section. */
+	struct ld_output_section *lo_gnu_hash; /* .gnu.hash section. */
 	struct ld_output_section *lo_verdef; /* .gnu.version.d section */
 	struct ld_output_section *lo_verneed; /* .gnu.version.r section */
 	struct ld_output_section *lo_versym; /* .gnu.version section */
@@ -138,6 +140,7 @@ struct ld_output {
 	struct ld_output_section *lo_plt; /* PLT section */
 	struct ld_output_section *lo_rel_plt; /* PLT relocation section */
 	struct ld_output_section *lo_rel_dyn;  /* Dynamic relocation section */
+	struct ld_output_section *lo_relr_dyn; /* relative relocation section */
 	struct ld_output_section *lo_ehframe_hdr; /* .eh_frame_hdr section */
 	struct ld_output_data_buffer *lo_dynamic_odb; /* .dynamic buffer */
 	struct ld_output_data_buffer *lo_got_odb; /* GOT section data */
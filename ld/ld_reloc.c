@@ -27,6 +27,7 @@
 #include "ld.h"
 #include "ld_arch.h"
 #include "ld_ehframe.h"
+#include "ld_icf.h"
 #include "ld_input.h"
 #include "ld_output.h"
 #include "ld_reloc.h"
@@ -52,8 +53,16 @@ static void _read_rela(struct ld *ld, struct ld_input_section *is,
     Elf_Data *d);
 static void _add_to_gc_search_list(struct ld_state *ls,
     struct ld_input_section *is);
-static uint64_t _reloc_addr(struct ld_reloc_entry *lre);
+static uint64_t _reloc_addr(const struct ld_reloc_entry *lre);
 static int _cmp_reloc(struct ld_reloc_entry *a, struct ld_reloc_entry *b);
+static int _cmp_relr_addr(const void *a, const void *b);
+static int _cmp_relr_offset(const void *a, const void *b);
+static uint64_t _encode_relr(struct ld *ld, struct ld_reloc_entry *lre,
+    uint64_t n, uint8_t *buf);
+static void _sort_reloc(struct ld_reloc_entry *lre,
+    struct ld_reloc_entry *tmp, uint64_t n);
+static struct ld_reloc_entry *_grow_reloc(struct ld *ld,
+    struct ld_reloc_entry *lre, uint64_t *cap, uint64_t n);
 
 void
 ld_reloc_load(struct ld *ld)
@@ -113,10 +122,8 @@ ld_reloc_load(struct ld *ld)
 			/*
 			 * Load and process relocation entries.
 			 */
-			if ((is->is_reloc = malloc(sizeof(*is->is_reloc))) ==
-			    NULL)
-				ld_fatal(ld, "malloc");
-			STAILQ_INIT(is->is_reloc);
+			is->is_reloc = _grow_reloc(ld, NULL, &is->is_cap_reloc,
+			    d->d_size / is->is_entsize);
 
 			if (is->is_type == SHT_REL)
 				_read_rel(ld, is, d);
@@ -136,7 +143,7 @@ ld_reloc_deferred_scan(struct ld *ld)
 {
 	struct ld_input *li;
 	struct ld_input_section *is;
-	struct ld_reloc_entry *lre;
+	uint64_t j;
 	int i;
 
 	if (ld->ld_reloc)
@@ -147,19 +154,31 @@ ld_reloc_deferred_scan(struct ld *ld)
 		if (li->li_name == NULL || li->li_type == LIT_DSO)
 			continue;
 
+		/*
+		 * The section contents are needed for relaxations that
+		 * depend on the instructions being relocated.
+		 */
+		ld_input_load(ld, li);
+
 		for (i = 0; (uint64_t) i < li->li_shnum - 1; i++) {
 			is = &li->li_is[i];
 
 			if (is->is_type != SHT_REL && is->is_type != SHT_RELA)
 				continue;
 
-			if (is->is_reloc == NULL)
+			/*
+			 * Skip relocations of discarded sections, such as
+			 * sections folded into an identical one.
+			 */
+			if (is->is_reloc == NULL || is->is_tis->is_discard)
 				continue;
 
-			STAILQ_FOREACH(lre, is->is_reloc, lre_next) {
-				ld->ld_arch->scan_reloc(ld, is->is_tis, lre);
-			}
+			for (j = 0; j < is->is_num_reloc; j++)
+				ld->ld_arch->scan_reloc(ld, is->is_tis,
+				    &is->is_reloc[j]);
 		}
+
+		ld_input_unload(ld, li);
 	}
 }
 
@@ -230,31 +249,35 @@ static void
 _read_rel(struct ld *ld, struct ld_input_section *is, Elf_Data *d)
 {
 	struct ld_reloc_entry *lre;
-	GElf_Rel r;
+	GElf_Rel r, rels[LD_GELF_BATCH];
 	uint64_t reloc_adjust, sym;
-	int i, len;
+	int i, j, len, n;
 
 	assert(is->is_reloc != NULL);
 
 	reloc_adjust = 0;
 	len = d->d_size / is->is_entsize;
-	for (i = 0; i < len; i++) {
-		if (gelf_getrel(d, i, &r) != &r) {
-			ld_warn(ld, "gelf_getrel failed: %s", elf_errmsg(-1));
-			continue;
+	for (i = j = n = 0; i < len; i++, j++) {
+		if (j == n) {
+			if ((n = gelf_getrels(d, i, LD_GELF_BATCH, rels)) <= 0) {
+				ld_warn(ld, "gelf_getrels failed: %s",
+				    elf_errmsg(-1));
+				break;
+			}
+			j = 0;
 		}
+		r = rels[j];
 		sym = GELF_R_SYM(r.r_info);
 		if (_discard_reloc(ld, is, sym, r.r_offset, &reloc_adjust))
 			continue;
-		if ((lre = calloc(1, sizeof(*lre))) == NULL)
-			ld_fatal(ld, "calloc");
+		assert(is->is_num_reloc < is->is_cap_reloc);
+		lre = &is->is_reloc[is->is_num_reloc++];
 		assert(r.r_offset >= reloc_adjust);
 		lre->lre_offset = r.r_offset - reloc_adjust;
 		lre->lre_type = GELF_R_TYPE(r.r_info);
+		lre->lre_addend = 0;
 		lre->lre_tis = is->is_tis;
 		_scan_reloc(ld, is, sym, lre);
-		STAILQ_INSERT_TAIL(is->is_reloc, lre, lre_next);
-		is->is_num_reloc++;
 	}
 	is->is_tis->is_shrink = reloc_adjust;
 }
@@ -263,32 +286,36 @@ static void
 _read_rela(struct ld *ld, struct ld_input_section *is, Elf_Data *d)
 {
 	struct ld_reloc_entry *lre;
-	GElf_Rela r;
+	GElf_Rela r, relas[LD_GELF_BATCH];
 	uint64_t reloc_adjust, sym;
-	int i, len;
+	int i, j, len, n;
 
 	assert(is->is_reloc != NULL);
 
 	reloc_adjust = 0;
 	len = d->d_size / is->is_entsize;
-	for (i = 0; i < len; i++) {
-		if (gelf_getrela(d, i, &r) != &r) {
-			ld_warn(ld, "gelf_getrel failed: %s", elf_errmsg(-1));
-			continue;
+	for (i = j = n = 0; i < len; i++, j++) {
+		if (j == n) {
+			if ((n = gelf_getrelas(d, i, LD_GELF_BATCH, relas)) <=
+			    0) {
+				ld_warn(ld, "gelf_getrelas failed: %s",
+				    elf_errmsg(-1));
+				break;
+			}
+			j = 0;
 		}
+		r = relas[j];
 		sym = GELF_R_SYM(r.r_info);
 		if (_discard_reloc(ld, is, sym, r.r_offset, &reloc_adjust))
 			continue;
-		if ((lre = calloc(1, sizeof(*lre))) == NULL)
-			ld_fatal(ld, "calloc");
+		assert(is->is_num_reloc < is->is_cap_reloc);
+		lre = &is->is_reloc[is->is_num_reloc++];
 		assert(r.r_offset >= reloc_adjust);
 		lre->lre_offset = r.r_offset - reloc_adjust;
 		lre->lre_type = GELF_R_TYPE(r.r_info);
 		lre->lre_addend = r.r_addend;
 		lre->lre_tis = is->is_tis;
 		_scan_reloc(ld, is, sym, lre);
-		STAILQ_INSERT_TAIL(is->is_reloc, lre, lre_next);
-		is->is_num_reloc++;
 	}
 	is->is_tis->is_shrink = reloc_adjust;
 }
@@ -305,7 +332,7 @@ _scan_reloc(struct ld *ld, struct ld_input_section *is, uint64_t sym,
 
 	lre->lre_sym = li->li_symindex[sym];
 
-	if (!ld->ld_reloc && !ld->ld_gc)
+	if (!ld->ld_reloc && !ld->ld_gc && ld->ld_icf == LD_ICF_NONE)
 		ld->ld_arch->scan_reloc(ld, is->is_tis, lre);
 }
 
@@ -336,6 +363,7 @@ ld_reloc_gc_sections(struct ld *ld)
 	struct ld_symbol *lsb;
 	struct ld_input_section *is;
 	struct ld_reloc_entry *lre;
+	uint64_t i;
 	char *entry;
 
 	/*
@@ -378,7 +406,8 @@ ld_reloc_gc_sections(struct ld *ld)
 	 */
 	STAILQ_FOREACH(is, ls->ls_gc, is_gc_next) {
 		assert(is->is_ris != NULL);
-		STAILQ_FOREACH(lre, is->is_ris->is_reloc, lre_next) {
+		for (i = 0; i < is->is_ris->is_num_reloc; i++) {
+			lre = &is->is_ris->is_reloc[i];
 			if (lre->lre_sym == NULL)
 				continue;
 			lsb = ld_symbols_ref(lre->lre_sym);
@@ -400,7 +429,7 @@ ld_reloc_serialize(struct ld *ld, struct ld_output_section *os, size_t *sz)
 	uint8_t *p;
 	void *b;
 	size_t entsize;
-	uint64_t sym;
+	uint64_t i, sym;
 	unsigned char is_64;
 	unsigned char is_rela;
 
@@ -413,7 +442,8 @@ ld_reloc_serialize(struct ld *ld, struct ld_output_section *os, size_t *sz)
 		ld_fatal_std(ld, "malloc");
 
 	p = b;
-	STAILQ_FOREACH(lre, os->os_reloc, lre_next) {
+	for (i = 0; i < os->os_num_reloc; i++) {
+		lre = &os->os_reloc[i];
 		if (lre->lre_sym != NULL) {
 			lsb = ld_symbols_ref(lre->lre_sym);
 			if (os->os_dynrel)
@@ -461,7 +491,8 @@ ld_reloc_create_entry(struct ld *ld, const char *name,
 {
 	struct ld_input_section *is;
 	struct ld_reloc_entry *lre;
-	int len;
+	uint64_t w;
+	int len, relr;
 
 	/*
 	 * List of internal sections to hold dynamic relocations:
@@ -470,10 +501,31 @@ ld_reloc_create_entry(struct ld *ld, const char *name,
 	 * .rel.plt      contains PLT (*_JMP_SLOT) relocations
 	 * .rel.got      contains GOT (*_GLOB_DATA) relocations
 	 * .rel.data.*   contains *_RELATIVE and absolute relocations
+	 * .relr.dyn     contains packed *_RELATIVE relocations
+	 *
+	 * A *_RELATIVE relocation is packed if option -z
+	 * pack-relative-relocs is specified and its place is word
+	 * aligned, which is known before the layout when the input
+	 * section it applies to is word aligned.
 	 */
 
+	w = ld->ld_arch->reloc_is_64bit ? sizeof(Elf64_Relr) :
+	    sizeof(Elf32_Relr);
+	relr = ld->ld_relr && tis != NULL &&
+	    ld->ld_arch->is_relative_reloc(type) && tis->is_align >= w &&
+	    offset % w == 0;
+	if (relr)
+		name = ".relr.dyn";
+
 	is = ld_input_find_internal_section(ld, name);
-	if (is == NULL) {
+	if (is == NULL && relr) {
+		is = ld_input_add_internal_section(ld, name);
+		is->is_type = SHT_RELR;
+		is->is_flags = SHF_ALLOC;
+		is->is_align = w;
+		is->is_entsize = w;
+		is->is_refed = 1;
+	} else if (is == NULL) {
 		is = ld_input_add_internal_section(ld, name);
 		is->is_dynrel = 1;
 		is->is_type = ld->ld_arch->reloc_is_rela ? SHT_RELA : SHT_REL;
@@ -486,24 +538,27 @@ ld_reloc_create_entry(struct ld *ld, const char *name,
 			is->is_pltrel = 1;
 	}
 
-	if (is->is_reloc == NULL) {
-		is->is_reloc = calloc(1, sizeof(*is->is_reloc));
-		if (is->is_reloc == NULL)
-			ld_fatal_std(ld, "calloc");
-		STAILQ_INIT(is->is_reloc);
-	}
-
-	if ((lre = malloc(sizeof(*lre))) == NULL)
-		ld_fatal_std(ld, "calloc");
+	if (is->is_num_reloc == is->is_cap_reloc || is->is_reloc == NULL)
+		is->is_reloc = _grow_reloc(ld, is->is_reloc, &is->is_cap_reloc,
+		    is->is_num_reloc + 1);
 
+	lre = &is->is_reloc[is->is_num_reloc++];
 	lre->lre_tis = tis;
 	lre->lre_type = type;
 	lre->lre_sym = lsb;
 	lre->lre_offset = offset;
 	lre->lre_addend = addend;
 
-	STAILQ_INSERT_TAIL(is->is_reloc, lre, lre_next);
-	is->is_num_reloc++;
+	/*
+	 * The size of .relr.dyn is reserved for the worst case here and
+	 * trimmed by ld_reloc_size_relr() once all the relocations are
+	 * known.
+	 */
+	if (relr) {
+		is->is_size += w;
+		return;
+	}
+
 	is->is_size += ld->ld_arch->reloc_entsize;
 
 	/* Keep track of the total number of *_RELATIVE relocations. */
@@ -518,6 +573,7 @@ ld_reloc_finalize_dynamic(struct ld *ld, struct ld_output *lo,
 	struct ld_input_section *is;
 	struct ld_output_section *_os;
 	struct ld_reloc_entry *lre;
+	uint64_t i;
 
 	if (!os->os_dynrel || os->os_reloc == NULL)
 		return;
@@ -536,7 +592,9 @@ ld_reloc_finalize_dynamic(struct ld *ld, struct ld_output *lo,
 	if (lo->lo_rel_dyn == NULL)
 		lo->lo_rel_dyn = os;
 
-	STAILQ_FOREACH(lre, os->os_reloc, lre_next) {
+	for (i = 0; i < os->os_num_reloc; i++) {
+		lre = &os->os_reloc[i];
+
 		/*
 		 * Found out the corresponding output section for the input
 		 * section which the relocation applies to.
@@ -560,6 +618,151 @@ ld_reloc_finalize_dynamic(struct ld *ld, struct ld_output *lo,
 	}
 }
 
+/*
+ * Relative relocations in .relr.dyn are encoded as runs, one or more
+ * for each input section they apply to. A run starts with the address
+ * of the first place and goes on with bitmaps for the words that
+ * follow. Since the places of a run keep their distances in the output
+ * object, the size of .relr.dyn is known before the layout. Runs are
+ * deliberately not merged across input sections, e.g. adjacent
+ * .data.rel and .data.rel.local, as this would make the size depend
+ * on the layout it is part of.
+ */
+
+void
+ld_reloc_size_relr(struct ld *ld)
+{
+	struct ld_input_section *is;
+	uint64_t n;
+
+	is = ld_input_find_internal_section(ld, ".relr.dyn");
+	if (is == NULL || is->is_reloc == NULL)
+		return;
+
+	qsort(is->is_reloc, is->is_num_reloc, sizeof(*is->is_reloc),
+	    _cmp_relr_offset);
+
+	n = _encode_relr(ld, is->is_reloc, is->is_num_reloc, NULL);
+	is->is_size = n * is->is_entsize;
+	if (is->is_size == 0) {
+		is->is_discard = 1;
+		return;
+	}
+
+	if (is->is_output != NULL)
+		ld->ld_output->lo_relr_dyn = is->is_output;
+}
+
+void
+ld_reloc_finalize_relr(struct ld *ld)
+{
+	struct ld_input_section *is;
+	uint64_t n;
+
+	is = ld_input_find_internal_section(ld, ".relr.dyn");
+	if (is == NULL || is->is_reloc == NULL || is->is_discard)
+		return;
+
+	qsort(is->is_reloc, is->is_num_reloc, sizeof(*is->is_reloc),
+	    _cmp_relr_addr);
+
+	assert(is->is_ibuf != NULL);
+	n = _encode_relr(ld, is->is_reloc, is->is_num_reloc, is->is_ibuf);
+	assert(n * is->is_entsize == is->is_size);
+}
+
+static uint64_t
+_encode_relr(struct ld *ld, struct ld_reloc_entry *lre, uint64_t n,
+    uint8_t *buf)
+{
+	struct ld_output *lo;
+	struct ld_input_section *tis;
+	uint64_t a, base, bitmap, i, nbits, nent, w;
+
+	lo = ld->ld_output;
+
+	w = ld->ld_arch->reloc_is_64bit ? sizeof(Elf64_Relr) :
+	    sizeof(Elf32_Relr);
+	nbits = w * 8 - 1;
+
+	/*
+	 * Count the entries only when `buf' is NULL, in which case the
+	 * offsets of the places in their input sections are used.
+	 */
+#define	_RELR_ADDR(r)	(buf != NULL ? _reloc_addr(r) : (r)->lre_offset)
+#define	_RELR_PUT(v)							\
+	do {								\
+		if (buf != NULL && w == 8)				\
+			WRITE_64(buf + nent * w, (v));			\
+		else if (buf != NULL)					\
+			WRITE_32(buf + nent * w, (v));			\
+		nent++;							\
+	} while (0)
+
+	nent = 0;
+	i = 0;
+	while (i < n) {
+		tis = lre[i].lre_tis;
+		if (tis->is_discard || tis->is_output == NULL) {
+			i++;
+			continue;
+		}
+
+		a = _RELR_ADDR(&lre[i]);
+		_RELR_PUT(a);
+		base = a + w;
+		i++;
+
+		while (i < n && lre[i].lre_tis == tis) {
+			bitmap = 0;
+			for (; i < n && lre[i].lre_tis == tis; i++) {
+				a = _RELR_ADDR(&lre[i]);
+				if (a < base)
+					continue; /* duplicate */
+				if (a - base >= nbits * w)
+					break;
+				bitmap |= (uint64_t) 1 << ((a - base) / w);
+			}
+			if (bitmap == 0)
+				break;
+			_RELR_PUT((bitmap << 1) | 1);
+			base += nbits * w;
+		}
+	}
+
+#undef	_RELR_ADDR
+#undef	_RELR_PUT
+
+	return (nent);
+}
+
+static int
+_cmp_relr_offset(const void *a, const void *b)
+{
+	const struct ld_reloc_entry *x, *y;
+
+	x = a;
+	y = b;
+
+	if ((uintptr_t) x->lre_tis != (uintptr_t) y->lre_tis)
+		return ((uintptr_t) x->lre_tis < (uintptr_t) y->lre_tis ?
+		    -1 : 1);
+
+	return (x->lre_offset < y->lre_offset ? -1 :
+	    x->lre_offset > y->lre_offset);
+}
+
+static int
+_cmp_relr_addr(const void *a, const void *b)
+{
+	uint64_t x, y;
+
+	x = _reloc_addr(a);
+	y = _reloc_addr(b);
+
+	return (x < y ? -1 : x > y);
+}
+
 void
 ld_reloc_join(struct ld *ld, struct ld_output_section *os,
     struct ld_input_section *is)
@@ -567,22 +770,50 @@ ld_reloc_join(struct ld *ld, struct ld_output_section *os,
 
 	assert(is->is_reloc != NULL);
 
-	if (os->os_reloc == NULL) {
-		if ((os->os_reloc = malloc(sizeof(*os->os_reloc))) == NULL)
-			ld_fatal_std(ld, "malloc");
-		STAILQ_INIT(os->os_reloc);
-	}
+	if (os->os_reloc == NULL ||
+	    os->os_num_reloc + is->is_num_reloc > os->os_cap_reloc)
+		os->os_reloc = _grow_reloc(ld, os->os_reloc, &os->os_cap_reloc,
+		    os->os_num_reloc + is->is_num_reloc);
 
-	STAILQ_CONCAT(os->os_reloc, is->is_reloc);
+	memcpy(&os->os_reloc[os->os_num_reloc], is->is_reloc,
+	    is->is_num_reloc * sizeof(*is->is_reloc));
 	os->os_num_reloc += is->is_num_reloc;
 
-	is->is_num_reloc = 0;
+	is->is_num_reloc = is->is_cap_reloc = 0;
 	free(is->is_reloc);
 	is->is_reloc = NULL;
 }
 
+/*
+ * Grow the relocation array `lre' to hold at least `n' entries,
+ * updating its capacity `*cap'.  An array is allocated even when `n'
+ * is zero, since a non-NULL array marks a section as having been
+ * loaded.
+ */
+static struct ld_reloc_entry *
+_grow_reloc(struct ld *ld, struct ld_reloc_entry *lre, uint64_t *cap,
+    uint64_t n)
+{
+	uint64_t c;
+
+	if (lre != NULL && n <= *cap)
+		return (lre);
+
+	c = *cap;
+	if (c < n)
+		c = c * 2 > n ? c * 2 : n;
+	if (c == 0)
+		c = 1;
+
+	if ((lre = realloc(lre, c * sizeof(*lre))) == NULL)
+		ld_fatal_std(ld, "realloc");
+	*cap = c;
+
+	return (lre);
+}
+
 static uint64_t
-_reloc_addr(struct ld_reloc_entry *lre)
+_reloc_addr(const struct ld_reloc_entry *lre)
 {
 
 	return (lre->lre_tis->is_output->os_addr + lre->lre_tis->is_reloff +
@@ -636,16 +867,52 @@ _cmp_reloc(struct ld_reloc_entry *a, struct ld_reloc_entry *b)
 	return (0);
 }
 
+/*
+ * A stable merge sort, which keeps relocations that compare equal
+ * in the order they were created.
+ */
+static void
+_sort_reloc(struct ld_reloc_entry *lre, struct ld_reloc_entry *tmp,
+    uint64_t n)
+{
+	uint64_t i, j, k, m;
+
+	if (n < 2)
+		return;
+
+	m = n / 2;
+	_sort_reloc(lre, tmp, m);
+	_sort_reloc(lre + m, tmp, n - m);
+
+	/* Nothing to do if the two halves are already in order. */
+	if (_cmp_reloc(&lre[m - 1], &lre[m]) <= 0)
+		return;
+
+	memcpy(tmp, lre, m * sizeof(*lre));
+	for (i = 0, j = m, k = 0; i < m && j < n; k++) {
+		if (_cmp_reloc(&lre[j], &tmp[i]) < 0)
+			lre[k] = lre[j++];
+		else
+			lre[k] = tmp[i++];
+	}
+	if (i < m)
+		memcpy(&lre[k], &tmp[i], (m - i) * sizeof(*lre));
+}
+
 void
 ld_reloc_sort(struct ld *ld, struct ld_output_section *os)
 {
+	struct ld_reloc_entry *tmp;
 
 	_ld = ld;
 
-	if (os->os_reloc == NULL)
+	if (os->os_reloc == NULL || os->os_num_reloc < 2)
 		return;
 
-	STAILQ_SORT(os->os_reloc, ld_reloc_entry, lre_next, _cmp_reloc);
+	if ((tmp = malloc((os->os_num_reloc / 2) * sizeof(*tmp))) == NULL)
+		ld_fatal_std(ld, "malloc");
+	_sort_reloc(os->os_reloc, tmp, os->os_num_reloc);
+	free(tmp);
 }
 
 int
@@ -810,6 +1077,7 @@ ld_reloc_process_input_section(struct ld *ld, struct ld_input_section *is,
 	struct ld_output_section *os;
 	struct ld_reloc_entry *lre;
 	struct ld_symbol *lsb;
+	uint64_t j;
 	int i;
 
 	if (is->is_type == SHT_REL || is->is_type == SHT_RELA)
@@ -838,7 +1106,8 @@ ld_reloc_process_input_section(struct ld *ld, struct ld_input_section *is,
 
 	assert(ris->is_reloc != NULL);
 
-	STAILQ_FOREACH(lre, ris->is_reloc, lre_next) {
+	for (j = 0; j < ris->is_num_reloc; j++) {
+		lre = &ris->is_reloc[j];
 		lsb = ld_symbols_ref(lre->lre_sym);
 
 		/*
@@ -30,17 +30,18 @@ struct ld_symbol;
 struct ld_input_section;
 struct ld_output_section;
 
+/*
+ * Relocation entries are kept in arrays, one for each input and output
+ * section that has relocations.
+ */
 struct ld_reloc_entry {
 	struct ld_input_section *lre_tis; /* input section to apply to */
 	struct ld_symbol *lre_sym;	/* reloc symbol */
 	uint64_t lre_type;		/* reloc type */
 	uint64_t lre_offset;		/* reloc offset */
 	uint64_t lre_addend;		/* reloc addend */
-	STAILQ_ENTRY(ld_reloc_entry) lre_next; /* next reloc */
 };
 
-STAILQ_HEAD(ld_reloc_entry_head, ld_reloc_entry);
-
 enum ld_tls_relax {
 	TLS_RELAX_NONE,
 	TLS_RELAX_INIT_EXEC,
@@ -54,6 +55,7 @@ void	ld_reloc_deferred_scan(struct ld *);
 void	ld_reloc_finalize(struct ld *, struct ld_output_section *);
 void	ld_reloc_finalize_dynamic(struct ld *, struct ld_output *,
     struct ld_output_section *);
+void	ld_reloc_finalize_relr(struct ld *);
 void	ld_reloc_gc_sections(struct ld *);
 void	ld_reloc_join(struct ld *, struct ld_output_section *,
     struct ld_input_section *);
@@ -67,3 +69,4 @@ int	ld_reloc_require_dynamic_reloc(struct ld *, struct ld_reloc_entry *);
 int	ld_reloc_require_glob_dat(struct ld *, struct ld_reloc_entry *);
 int	ld_reloc_relative_relax(struct ld *, struct ld_reloc_entry *);
 void	*ld_reloc_serialize(struct ld *, struct ld_output_section *, size_t *);
+void	ld_reloc_size_relr(struct ld *);
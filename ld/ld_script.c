@@ -398,6 +398,9 @@ ld_script_cleanup(struct ld *ld)
 
 	lds = ld->ld_scp;
 
+	/* The compiled version script is allocated from the arena. */
+	ld->ld_vm = NULL;
+
 	if (lds->lds_entry_point != NULL) {
 		free(lds->lds_entry_point);
 		lds->lds_entry_point = NULL;
@@ -636,6 +639,10 @@ ld_script_version_alloc_entry(struct ld *ld, char *sym, void *extern_block)
 
 	ignore = 0;
 	for (p = ldve->ldve_sym; *p != '\0'; p++) {
+		if (ignore) {
+			ignore = 0;
+			continue;
+		}
 		switch (*p) {
 		case '\\':
 			/* Ignore the next char */
@@ -644,11 +651,8 @@ ld_script_version_alloc_entry(struct ld *ld, char *sym, void *extern_block)
 		case '?':
 		case '*':
 		case '[':
-			if (!ignore) {
-				ldve->ldve_glob = 1;
-				goto done;
-			} else
-				ignore = 0;
+			ldve->ldve_glob = 1;
+			goto done;
 		}
 	}
 
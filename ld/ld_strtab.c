@@ -29,25 +29,24 @@
 
 ELFTC_VCSID("$Id$");
 
-#define	_DEFAULT_STRTAB_SIZE	512
-
 struct ld_str {
 	char *s;
 	size_t off, len;
+	struct ld_str *tail;		/* string this one is a suffix of */
 	UT_hash_handle hh;
 };
 
 struct ld_strtab {
 	struct ld_str *st_pool;
 	char *st_buf;
-	size_t st_cap;
 	size_t st_size;
+	size_t st_count;		/* number of strings in st_pool */
 	unsigned char st_suffix;
+	unsigned char st_dirty;		/* st_buf needs to be rebuilt */
 };
 
-
-static void _resize_strtab(struct ld *ld, struct ld_strtab *st,
-    size_t newsize);
+static void _build_strtab(struct ld *ld, struct ld_strtab *st);
+static int _cmp_reversed(const void *a, const void *b);
 
 struct ld_strtab *
 ld_strtab_alloc(struct ld *ld, unsigned char suffix)
@@ -56,16 +55,9 @@ ld_strtab_alloc(struct ld *ld, unsigned char suffix)
 
 	if ((st = calloc(1, sizeof(*st))) == NULL)
 		ld_fatal_std(ld, "calloc");
-	
-	st->st_size = 0;
-	if (suffix) {
-		st->st_suffix = 1;
-		st->st_cap = _DEFAULT_STRTAB_SIZE;
-		if ((st->st_buf = calloc(1, st->st_cap)) == NULL)
-			ld_fatal_std(ld, "calloc");
-		ld_strtab_insert(ld, st, "");
-	} else
-		st->st_size = 1;
+
+	st->st_size = 1;
+	st->st_suffix = suffix;
 
 	return (st);
 }
@@ -78,9 +70,6 @@ ld_strtab_free(struct ld_strtab *st)
 	if (st == NULL)
 		return;
 
-	free(st->st_buf);
-	free(st);
-
 	if (st->st_pool != NULL) {
 		HASH_ITER(hh, st->st_pool, str, tmp) {
 			HASH_DELETE(hh, st->st_pool, str);
@@ -88,6 +77,9 @@ ld_strtab_free(struct ld_strtab *st)
 			free(str);
 		}
 	}
+
+	free(st->st_buf);
+	free(st);
 }
 
 char *
@@ -98,8 +90,11 @@ ld_strtab_getbuf(struct ld *ld, struct ld_strtab *st)
 
 	assert(st != NULL);
 
-	if (st->st_suffix)
+	if (st->st_suffix) {
+		if (st->st_dirty)
+			_build_strtab(ld, st);
 		return (st->st_buf);
+	}
 
 	if (st->st_buf == NULL) {
 		if ((st->st_buf = malloc(st->st_size)) == NULL)
@@ -120,20 +115,13 @@ ld_strtab_getbuf(struct ld *ld, struct ld_strtab *st)
 }
 
 size_t
-ld_strtab_getsize(struct ld_strtab *st)
+ld_strtab_getsize(struct ld *ld, struct ld_strtab *st)
 {
 
-	return (st->st_size);
-}
-
-static void
-_resize_strtab(struct ld *ld, struct ld_strtab *st, size_t newsize)
-{
+	if (st->st_suffix && st->st_dirty)
+		_build_strtab(ld, st);
 
-	assert(st != NULL && st->st_suffix);
-	if ((st->st_buf = realloc(st->st_buf, newsize)) == NULL)
-		ld_fatal_std(ld, "realloc");
-	st->st_cap = newsize;
+	return (st->st_size);
 }
 
 size_t
@@ -168,60 +156,72 @@ ld_strtab_insert_no_suffix(struct ld *ld, struct ld_strtab *st, char *s)
 	return (str->off);
 }
 
+/*
+ * Add a string to a string table that shares storage between strings
+ * and their suffixes.  The strings are only collected here; the table
+ * contents and string offsets are computed by _build_strtab() when
+ * they are next asked for.
+ */
 void
 ld_strtab_insert(struct ld *ld, struct ld_strtab *st, const char *s)
 {
-	const char *r;
-	char *b, *c;
-	size_t len, slen;
-	int append;
+	struct ld_str *str;
+	char *k;
 
-	assert(st != NULL && st->st_buf != NULL && st->st_suffix);
+	assert(st != NULL && st->st_suffix);
 
-	if (s == NULL)
+	if (s == NULL || *s == '\0')
 		return;
 
-	slen = strlen(s);
-	append = 0;
-	b = st->st_buf;
-	for (c = b; c < b + st->st_size;) {
-		len = strlen(c);
-		if (!append && len >= slen) {
-			r = c + (len - slen);
-			if (strcmp(r, s) == 0)
-				return;
-		} else if (len < slen && len != 0) {
-			r = s + (slen - len);
-			if (strcmp(c, r) == 0) {
-				st->st_size -= len + 1;
-				memmove(c, c + len + 1, st->st_size - (c - b));
-				append = 1;
-				continue;
-			}
-		}
-		c += len + 1;
+	/*
+	 * uthash wants a modifiable key, so search with the copy that
+	 * is added to the pool.
+	 */
+	if ((k = strdup(s)) == NULL)
+		ld_fatal_std(ld, "strdup");
+
+	HASH_FIND_STR(st->st_pool, k, str);
+	if (str != NULL) {
+		free(k);
+		return;
 	}
 
-	while (st->st_size + slen + 1 >= st->st_cap)
-		_resize_strtab(ld, st, st->st_cap * 2);
+	if ((str = calloc(1, sizeof(*str))) == NULL)
+		ld_fatal_std(ld, "calloc");
 
-	b = st->st_buf;
-	strncpy(&b[st->st_size], s, slen);
-	b[st->st_size + slen] = '\0';
-	st->st_size += slen + 1;
+	str->s = k;
+	str->len = strlen(s);
+	HASH_ADD_KEYPTR(hh, st->st_pool, str->s, str->len, str);
+
+	st->st_count++;
+	st->st_dirty = 1;
 }
 
 size_t
-ld_strtab_lookup(struct ld_strtab *st, const char *s)
+ld_strtab_lookup(struct ld *ld, struct ld_strtab *st, const char *s)
 {
+	struct ld_str *str;
 	const char *b, *c, *r;
+	char *k;
 	size_t len, slen;
 
-	assert(st != NULL && st->st_buf != NULL && st->st_suffix);
+	assert(st != NULL && st->st_suffix);
 
-	if (s == NULL)
+	if (s == NULL || *s == '\0')
 		return (0);
 
+	if (st->st_dirty)
+		_build_strtab(ld, st);
+
+	/* Search with a modifiable copy, as in ld_strtab_insert(). */
+	if ((k = strdup(s)) == NULL)
+		ld_fatal_std(ld, "strdup");
+	HASH_FIND_STR(st->st_pool, k, str);
+	free(k);
+	if (str != NULL)
+		return (str->off);
+
+	/* Look for a string that was not inserted, but is a suffix. */
 	slen = strlen(s);
 	b = st->st_buf;
 	for (c = b; c < b + st->st_size;) {
@@ -236,3 +236,104 @@ ld_strtab_lookup(struct ld_strtab *st, const char *s)
 
 	return (-1);
 }
+
+/*
+ * Compare two strings backwards, ordering a string after the strings
+ * it is a suffix of.
+ */
+static int
+_cmp_reversed(const void *a, const void *b)
+{
+	const struct ld_str *sa, *sb;
+	const unsigned char *pa, *pb;
+	size_t n;
+
+	sa = *(const struct ld_str * const *) a;
+	sb = *(const struct ld_str * const *) b;
+
+	pa = (const unsigned char *) sa->s + sa->len;
+	pb = (const unsigned char *) sb->s + sb->len;
+	n = sa->len < sb->len ? sa->len : sb->len;
+	while (n-- > 0) {
+		pa--;
+		pb--;
+		if (*pa != *pb)
+			return (*pa > *pb ? -1 : 1);
+	}
+
+	if (sa->len == sb->len)
+		return (0);
+
+	return (sa->len > sb->len ? -1 : 1);
+}
+
+/*
+ * Lay out the strings of a suffix-merging string table.
+ *
+ * Sorting the strings by their reversed contents places every string
+ * right after the strings that end with it, so each string only
+ * needs to be compared with its predecessor to find a string to share
+ * storage with.  The remaining strings are placed in the order they
+ * were inserted.
+ */
+static void
+_build_strtab(struct ld *ld, struct ld_strtab *st)
+{
+	struct ld_str **sorted, *str, *prev, *tmp;
+	size_t i, off;
+	char *p;
+
+	assert(st->st_suffix);
+
+	sorted = NULL;
+	if (st->st_count > 0) {
+		if ((sorted = malloc(st->st_count * sizeof(*sorted))) == NULL)
+			ld_fatal_std(ld, "malloc");
+		i = 0;
+		HASH_ITER(hh, st->st_pool, str, tmp)
+			sorted[i++] = str;
+		assert(i == st->st_count);
+
+		qsort(sorted, st->st_count, sizeof(*sorted), _cmp_reversed);
+
+		prev = NULL;
+		for (i = 0; i < st->st_count; i++) {
+			str = sorted[i];
+			str->tail = NULL;
+			if (prev != NULL && prev->len > str->len &&
+			    memcmp(prev->s + prev->len - str->len, str->s,
+			    str->len) == 0)
+				str->tail = prev->tail != NULL ? prev->tail :
+				    prev;
+			prev = str;
+		}
+		free(sorted);
+	}
+
+	off = 1;
+	HASH_ITER(hh, st->st_pool, str, tmp) {
+		if (str->tail != NULL)
+			continue;
+		str->off = off;
+		off += str->len + 1;
+	}
+
+	free(st->st_buf);
+	if ((st->st_buf = malloc(off)) == NULL)
+		ld_fatal_std(ld, "malloc");
+	st->st_size = off;
+
+	p = st->st_buf;
+	*p++ = '\0';
+	HASH_ITER(hh, st->st_pool, str, tmp) {
+		if (str->tail != NULL) {
+			str->off = str->tail->off + str->tail->len - str->len;
+			continue;
+		}
+		memcpy(p, str->s, str->len + 1);
+		p += str->len + 1;
+	}
+	assert(p == st->st_buf + off);
+
+	st->st_dirty = 0;
+}
@@ -30,6 +30,6 @@ struct ld_strtab *ld_strtab_alloc(struct ld *, unsigned char);
 void	ld_strtab_free(struct ld_strtab *);
 void	ld_strtab_insert(struct ld *, struct ld_strtab *, const char *);
 size_t	ld_strtab_insert_no_suffix(struct ld *, struct ld_strtab *, char *);
-size_t	ld_strtab_lookup(struct ld_strtab *, const char *);
+size_t	ld_strtab_lookup(struct ld *, struct ld_strtab *, const char *);
 char	*ld_strtab_getbuf(struct ld *, struct ld_strtab *);
-size_t	ld_strtab_getsize(struct ld_strtab *);
+size_t	ld_strtab_getsize(struct ld *, struct ld_strtab *);
@@ -25,9 +25,11 @@
  */
 
 #include "ld.h"
+#include "ld_arena.h"
 #include "ld_dynamic.h"
 #include "ld_file.h"
 #include "ld_input.h"
+#include "ld_merge.h"
 #include "ld_output.h"
 #include "ld_symbols.h"
 #include "ld_symver.h"
@@ -37,32 +39,70 @@
 ELFTC_VCSID("$Id$");
 
 #define	_INIT_SYMTAB_SIZE	128
+#define	_SYMBOL_BATCH		16	/* files decoded per thread at once */
+
+/*
+ * An input object whose symbols are to be decoded, and the state
+ * shared by the threads decoding them.
+ */
+struct ld_symbol_job {
+	struct ld_input *sj_li;		/* input object */
+	Elf *sj_e;			/* ELF descriptor */
+	Elf_Data *sj_d;			/* symbol table data */
+	size_t sj_strndx;		/* string table index */
+};
+
+struct ld_symbol_pool {
+	struct ld *sp_ld;
+	struct ld_symbol_job *sp_job;	/* jobs */
+	size_t sp_count;		/* number of jobs */
+	size_t sp_next;			/* next job to claim */
+	pthread_mutex_t sp_mutex;	/* protects sp_next */
+};
+
+struct ld_symbol_worker {
+	struct ld_symbol_pool *sw_pool;	/* shared state */
+	struct ld_arena_chunk *sw_arena; /* chunks for the symbols */
+};
 
 static void _load_symbols(struct ld *ld, struct ld_file *lf);
 static void _load_archive_symbols(struct ld *ld, struct ld_file *lf);
+static struct ld_file *_load_symbols_parallel(struct ld *ld,
+    struct ld_file *lf);
 static void _load_elf_symbols(struct ld *ld, struct ld_input *li, Elf *e);
-static void _unload_symbols(struct ld_input *li);
-static void _add_elf_symbol(struct ld *ld, struct ld_input *li, Elf *e,
-    GElf_Sym *sym, size_t strndx, int i);
+static int _init_elf_symbols(struct ld *ld, struct ld_input *li, Elf *e,
+    struct ld_symbol_job *sj);
+static void _decode_elf_symbols(struct ld *ld, struct ld_arena_chunk **ac,
+    struct ld_symbol_job *sj);
+static void _decode_elf_symbols_parallel(struct ld *ld,
+    struct ld_symbol_job *job, size_t count);
+static void *_decode_worker(void *arg);
+static void _merge_elf_symbols(struct ld *ld, struct ld_input *li);
+static void _add_elf_symbol(struct ld *ld, struct ld_arena_chunk **ac,
+    struct ld_input *li, Elf *e, GElf_Sym *sym, size_t strndx, int i);
 static void _add_to_dynsym_table(struct ld *ld, struct ld_symbol *lsb);
 static void _write_to_dynsym_table(struct ld *ld, struct ld_symbol *lsb);
 static void _add_to_symbol_table(struct ld *ld, struct ld_symbol *lsb);
 static void _free_symbol_table(struct ld_symbol_table *symtab);
 struct ld_symbol_table *_alloc_symbol_table(struct ld *ld);
 static int _archive_member_extracted(struct ld_archive *la, off_t off);
+static void _index_archive_symbols(struct ld *ld, struct ld_file *lf);
 static struct ld_archive_member * _extract_archive_member(struct ld *ld,
     struct ld_file *lf, struct ld_archive *la, off_t off);
 static void _print_extracted_member(struct ld *ld,
     struct ld_archive_member *lam, struct ld_symbol *lsb);
 static void _resolve_and_add_symbol(struct ld *ld, struct ld_symbol *lsb);
 static struct ld_symbol *_alloc_symbol(struct ld *ld);
-static void _free_symbol(struct ld_symbol *lsb);
 static struct ld_symbol *_find_symbol(struct ld_symbol *tbl, char *name);
 static void _update_symbol(struct ld_symbol *lsb);
+static void _add_undef_symbol(struct ld *ld, struct ld_symbol *lsb);
 
-#define	_add_symbol(tbl, s) do {				\
-	HASH_ADD_KEYPTR(hh, (tbl), (s)->lsb_longname,		\
+#define	_add_symbol(ld, s) do {					\
+	HASH_ADD_KEYPTR(hh, (ld)->ld_sym, (s)->lsb_longname,	\
 	    strlen((s)->lsb_longname), (s));			\
+	if ((s)->lsb_shndx == SHN_UNDEF ||			\
+	    (s)->lsb_shndx == SHN_COMMON)			\
+		_add_undef_symbol((ld), (s));			\
 	} while (0)
 #define _remove_symbol(tbl, s) do {				\
 	HASH_DEL((tbl), (s));					\
@@ -79,34 +119,26 @@ static void _update_symbol(struct ld_symbol *lsb);
 	(_s)->lsb_ref = (s);					\
 	} while (0)
 
+/*
+ * Symbols and their names are allocated from the arena, and are
+ * released along with it by ld_arena_cleanup().
+ */
 void
 ld_symbols_cleanup(struct ld *ld)
 {
-	struct ld_input *li;
-	struct ld_symbol *lsb, *_lsb;
 
 	HASH_CLEAR(hh, ld->ld_sym);
 
-	STAILQ_FOREACH(li, &ld->ld_lilist, li_next) {
-		_unload_symbols(li);
-	}
+	free(ld->ld_undef);
+	ld->ld_undef = NULL;
+	ld->ld_undef_num = ld->ld_undef_cap = 0;
 
 	if (ld->ld_ext_symbols != NULL) {
-		STAILQ_FOREACH_SAFE(lsb, ld->ld_ext_symbols, lsb_next, _lsb) {
-			STAILQ_REMOVE(ld->ld_ext_symbols, lsb, ld_symbol,
-			    lsb_next);
-			_free_symbol(lsb);
-		}
 		free(ld->ld_ext_symbols);
 		ld->ld_ext_symbols = NULL;
 	}
 
 	if (ld->ld_var_symbols != NULL) {
-		STAILQ_FOREACH_SAFE(lsb, ld->ld_var_symbols, lsb_next, _lsb) {
-			STAILQ_REMOVE(ld->ld_var_symbols, lsb, ld_symbol,
-			    lsb_next);
-			_free_symbol(lsb);
-		}
 		free(ld->ld_var_symbols);
 		ld->ld_var_symbols = NULL;
 	}
@@ -137,10 +169,7 @@ ld_symbols_add_extern(struct ld *ld, char *name)
 		return;
 
 	lsb = _alloc_symbol(ld);
-	if ((lsb->lsb_name = strdup(name)) == NULL)
-		ld_fatal_std(ld, "strdup");
-	if ((lsb->lsb_longname = strdup(name)) == NULL)
-		ld_fatal_std(ld, "strdup");
+	lsb->lsb_name = lsb->lsb_longname = ld_arena_strdup(ld, name);
 
 	if (ld->ld_ext_symbols == NULL) {
 		ld->ld_ext_symbols = malloc(sizeof(*ld->ld_ext_symbols));
@@ -150,7 +179,7 @@ ld_symbols_add_extern(struct ld *ld, char *name)
 	}
 	STAILQ_INSERT_TAIL(ld->ld_ext_symbols, lsb, lsb_next);
 
-	_add_symbol(ld->ld_sym, lsb);
+	_add_symbol(ld, lsb);
 }
 
 void
@@ -160,10 +189,8 @@ ld_symbols_add_variable(struct ld *ld, struct ld_script_variable *ldv,
 	struct ld_symbol *lsb;
 
 	lsb = _alloc_symbol(ld);
-	if ((lsb->lsb_name = strdup(ldv->ldv_name)) == NULL)
-		ld_fatal_std(ld, "strdup");
-	if ((lsb->lsb_longname = strdup(ldv->ldv_name)) == NULL)
-		ld_fatal_std(ld, "strdup");
+	lsb->lsb_name = lsb->lsb_longname = ld_arena_strdup(ld,
+	    ldv->ldv_name);
 	lsb->lsb_var = ldv;
 	lsb->lsb_bind = STB_GLOBAL;
 	lsb->lsb_shndx = SHN_ABS;
@@ -192,10 +219,7 @@ ld_symbols_add_internal(struct ld *ld, const char *name, uint64_t size,
 	struct ld_symbol *lsb;
 
 	lsb = _alloc_symbol(ld);
-	if ((lsb->lsb_name = strdup(name)) == NULL)
-		ld_fatal_std(ld, "strdup");
-	if ((lsb->lsb_longname = strdup(name)) == NULL)
-		ld_fatal_std(ld, "strdup");
+	lsb->lsb_name = lsb->lsb_longname = ld_arena_strdup(ld, name);
 	lsb->lsb_size = size;
 	lsb->lsb_value = value;
 	lsb->lsb_shndx = shndx;
@@ -227,7 +251,7 @@ void
 ld_symbols_resolve(struct ld *ld)
 {
 	struct ld_state *ls;
-	struct ld_file *lf;
+	struct ld_file *lf, *_lf;
 	struct ld_symbol *lsb, *_lsb;
 
 	if (TAILQ_EMPTY(&ld->ld_lflist)) {
@@ -253,6 +277,17 @@ ld_symbols_resolve(struct ld *ld)
 		}
 		ls->ls_group_level = lf->lf_group_level;
 
+		/* Load symbols of object files in parallel if we can. */
+		if (ld->ld_threads > 1) {
+			_lf = _load_symbols_parallel(ld, lf);
+			if (ls->ls_arch_conflict)
+				return;
+			if (_lf != lf) {
+				lf = _lf;
+				continue;
+			}
+		}
+
 		/* Load symbols. */
 		ld_file_load(ld, lf);
 		if (ls->ls_arch_conflict) {
@@ -334,9 +369,7 @@ ld_symbols_build_symtab(struct ld *ld)
 			continue;
 		if (os->os_rel)
 			continue;
-		os->os_secsym = calloc(1, sizeof(*os->os_secsym));
-		if (os->os_secsym == NULL)
-			ld_fatal_std(ld, "calloc");
+		os->os_secsym = _alloc_symbol(ld);
 		os->os_secsym->lsb_name = NULL;
 		os->os_secsym->lsb_size = 0;
 		os->os_secsym->lsb_value = os->os_addr;
@@ -349,9 +382,7 @@ ld_symbols_build_symtab(struct ld *ld)
 		/* Create STT_SECTION symbols for relocation sections. */
 		if (os->os_r != NULL && !ld->ld_reloc) {
 			_os = os->os_r;
-			_os->os_secsym = calloc(1, sizeof(*_os->os_secsym));
-			if (_os->os_secsym == NULL)
-				ld_fatal_std(ld, "calloc");
+			_os->os_secsym = _alloc_symbol(ld);
 			_os->os_secsym->lsb_name = NULL;
 			_os->os_secsym->lsb_size = 0;
 			_os->os_secsym->lsb_value = _os->os_addr;
@@ -604,12 +635,8 @@ ld_symbols_in_dso(struct ld_symbol *lsb)
 static struct ld_symbol *
 _alloc_symbol(struct ld *ld)
 {
-	struct ld_symbol *s;
-
-	if ((s = calloc(1, sizeof(*s))) == NULL)
-		ld_fatal_std(ld, "calloc");
 
-	return (s);
+	return (ld_arena_calloc(ld, 1, sizeof(struct ld_symbol)));
 }
 
 static struct ld_symbol *
@@ -621,10 +648,26 @@ _find_symbol(struct ld_symbol *tbl, char *name)
 	return (s);
 }
 
+static void
+_add_undef_symbol(struct ld *ld, struct ld_symbol *lsb)
+{
+	struct ld_symbol **p;
+
+	if (ld->ld_undef_num == ld->ld_undef_cap) {
+		ld->ld_undef_cap = ld->ld_undef_cap ? ld->ld_undef_cap * 2 :
+		    256;
+		if ((p = realloc(ld->ld_undef, ld->ld_undef_cap *
+		    sizeof(*p))) == NULL)
+			ld_fatal_std(ld, "realloc");
+		ld->ld_undef = p;
+	}
+	ld->ld_undef[ld->ld_undef_num++] = lsb;
+}
+
 #define _prefer_new()	do {			\
 	_resolve_symbol(_lsb, lsb);		\
 	_remove_symbol(ld->ld_sym, _lsb);	\
-	_add_symbol(ld->ld_sym, lsb);		\
+	_add_symbol(ld, lsb);			\
 	} while (0)
 
 #define _prefer_old()	_resolve_symbol(lsb, _lsb)
@@ -681,7 +724,7 @@ _resolve_and_add_symbol(struct ld *ld, struct ld_symbol *lsb)
 	 * and they are both undefined, there is still a chance that they are
 	 * the same symbol. We will solve that when we see the definition.
 	 */
-	_add_symbol(ld->ld_sym, lsb);
+	_add_symbol(ld, lsb);
 
 	return;
 
@@ -872,11 +915,10 @@ found:
 }
 
 static void
-_add_elf_symbol(struct ld *ld, struct ld_input *li, Elf *e, GElf_Sym *sym,
-    size_t strndx, int i)
+_add_elf_symbol(struct ld *ld, struct ld_arena_chunk **ac, struct ld_input *li,
+    Elf *e, GElf_Sym *sym, size_t strndx, int i)
 {
 	struct ld_symbol *lsb;
-	struct ld_symbol_defver *dv;
 	char *name;
 	int j, len, ndx;
 	unsigned char st_bind;
@@ -908,10 +950,9 @@ _add_elf_symbol(struct ld *ld, struct ld_input *li, Elf *e, GElf_Sym *sym,
 		}
 	}
 
-	lsb = _alloc_symbol(ld);
+	lsb = ld_arena_calloc_r(ld, ac, 1, sizeof(*lsb));
 
-	if ((lsb->lsb_name = strdup(name)) == NULL)
-		ld_fatal_std(ld, "strdup");
+	lsb->lsb_name = ld_arena_strdup_r(ld, ac, name);
 	lsb->lsb_value = sym->st_value;
 	lsb->lsb_size = sym->st_size;
 	lsb->lsb_bind = GELF_ST_BIND(sym->st_info);
@@ -955,36 +996,20 @@ _add_elf_symbol(struct ld *ld, struct ld_input *li, Elf *e, GElf_Sym *sym,
 	}
 
 	/* Build "long" symbol name which is used for hash key. */
-	if (lsb->lsb_ver == NULL || j < 2) {
-		lsb->lsb_longname = strdup(lsb->lsb_name);
-		if (lsb->lsb_longname == NULL)
-			ld_fatal_std(ld, "strdup");
-	} else {
+	if (lsb->lsb_ver == NULL || j < 2)
+		lsb->lsb_longname = lsb->lsb_name;
+	else {
 		len = strlen(lsb->lsb_name) + strlen(lsb->lsb_ver) + 2;
-		if ((lsb->lsb_longname = malloc(len)) == NULL)
-			ld_fatal_std(ld, "malloc");
+		lsb->lsb_longname = ld_arena_calloc_r(ld, ac, len, 1);
 		snprintf(lsb->lsb_longname, len, "%s@%s", lsb->lsb_name,
 		    lsb->lsb_ver);
 	}
 
-	/* Keep track of default versions. */
-	if (lsb->lsb_default) {
-		if ((dv = calloc(1, sizeof(*dv))) == NULL)
-			ld_fatal(ld, "calloc");
-		dv->dv_name = lsb->lsb_name;
-		dv->dv_longname = lsb->lsb_longname;
-		dv->dv_ver = lsb->lsb_ver;
-		HASH_ADD_KEYPTR(hh, ld->ld_defver, dv->dv_name,
-		    strlen(dv->dv_name), dv);
-	}
-
 	/*
-	 * Insert symbol to input object internal symbol list and
-	 * perform symbol resolving.
+	 * Insert symbol to input object internal symbol list. Symbol
+	 * resolving is done by _merge_elf_symbols().
 	 */
 	ld_input_add_symbol(ld, li, lsb);
-	if (lsb->lsb_bind != STB_LOCAL)
-		_resolve_and_add_symbol(ld, lsb);
 }
 
 static int
@@ -1044,7 +1069,9 @@ _extract_archive_member(struct ld *ld, struct ld_file *lf,
 	/* Load the symbols of this member. */
 	_load_elf_symbols(ld, li, e);
 
-	elf_end(e);
+	/* Keep the descriptor for the passes over the input objects. */
+	lam->lam_elf = e;
+	ld->ld_fc->fc_mmiss++;
 
 	return (lam);
 }
@@ -1073,53 +1100,154 @@ _print_extracted_member(struct ld *ld, struct ld_archive_member *lam,
 	printf("%s (%s)\n", c2, lsb->lsb_name);
 }
 
+/*
+ * Build an index from symbol names to the archive members defining
+ * them.  The index is kept for the lifetime of the link, since an
+ * archive in a group may be searched several times.  As with other
+ * linkers, the first member listed for a name in the archive symbol
+ * table is the one that gets extracted.
+ */
+static void
+_index_archive_symbols(struct ld *ld, struct ld_file *lf)
+{
+	struct ld_archive *la;
+	struct ld_archive_symbol *las;
+	Elf_Arsym *as;
+	size_t c, i;
+
+	la = lf->lf_ar;
+	if ((as = elf_getarsym(lf->lf_elf, &c)) == NULL)
+		ld_fatal(ld, "%s: elf_getarsym failed: %s", lf->lf_name,
+		    elf_errmsg(-1));
+
+	for (i = 0; i < c; i++) {
+		if (as[i].as_name == NULL)
+			break;
+		HASH_FIND_STR(la->la_s, as[i].as_name, las);
+		if (las != NULL)
+			continue;
+		if ((las = calloc(1, sizeof(*las))) == NULL)
+			ld_fatal_std(ld, "calloc");
+		if ((las->las_name = strdup(as[i].as_name)) == NULL)
+			ld_fatal_std(ld, "strdup");
+		las->las_off = as[i].as_off;
+		las->las_idx = i;
+		HASH_ADD_KEYPTR(hh, la->la_s, las->las_name,
+		    strlen(las->las_name), las);
+	}
+
+	if ((la->la_pending = calloc((c + 63) / 64,
+	    sizeof(*la->la_pending))) == NULL)
+		ld_fatal_std(ld, "calloc");
+
+	la->la_indexed = 1;
+}
+
 static void
 _load_archive_symbols(struct ld *ld, struct ld_file *lf)
 {
 	struct ld_state *ls;
 	struct ld_archive *la;
 	struct ld_archive_member *lam;
+	struct ld_archive_symbol *las;
 	struct ld_symbol *lsb;
 	Elf_Arsym *as;
-	size_t c;
-	int extracted, i;
+	size_t c, i, j, n;
+	int again;
 
 	assert(lf != NULL && lf->lf_type == LFT_ARCHIVE);
 	assert(lf->lf_ar != NULL);
 
 	ls = &ld->ld_state;
 	la = lf->lf_ar;
+	if (!la->la_indexed)
+		_index_archive_symbols(ld, lf);
 	if ((as = elf_getarsym(lf->lf_elf, &c)) == NULL)
 		ld_fatal(ld, "%s: elf_getarsym failed: %s", lf->lf_name,
 		    elf_errmsg(-1));
+
+#define	_PENDING(i)	(la->la_pending[(i) / 64] & (1ULL << ((i) % 64)))
+#define	_SET_PENDING(i)	(la->la_pending[(i) / 64] |= 1ULL << ((i) % 64))
+#define	_CLR_PENDING(i)	(la->la_pending[(i) / 64] &= ~(1ULL << ((i) % 64)))
+
+	/*
+	 * Mark the archive symbol table entries of the symbols that are
+	 * still undefined (or common).  Entries that have since been
+	 * resolved are dropped from the worklist.
+	 */
+	for (i = j = 0; i < ld->ld_undef_num; i++) {
+		lsb = ld->ld_undef[i];
+		if (lsb->lsb_ref != NULL || (lsb->lsb_shndx != SHN_UNDEF &&
+		    lsb->lsb_shndx != SHN_COMMON))
+			continue;
+		ld->ld_undef[j++] = lsb;
+		HASH_FIND_STR(la->la_s, lsb->lsb_longname, las);
+		if (las != NULL)
+			_SET_PENDING(las->las_idx);
+	}
+	ld->ld_undef_num = j;
+
+	/*
+	 * Visit the marked entries in archive symbol table order, in
+	 * passes, so that members are extracted in the same order as by
+	 * repeated scans of the whole table.  Symbols introduced by an
+	 * extracted member are visited in the current pass if their
+	 * entry is still ahead, and in the next pass otherwise.
+	 */
 	do {
-		extracted = 0;
-		for (i = 0; (size_t) i < c; i++) {
-			if (as[i].as_name == NULL)
-				break;
+		again = 0;
+		for (i = 0; i < c; i++) {
+			if (i % 64 == 0 && la->la_pending[i / 64] == 0) {
+				i += 63;
+				continue;
+			}
+			if (!_PENDING(i))
+				continue;
+			_CLR_PENDING(i);
 			if (_archive_member_extracted(la, as[i].as_off))
 				continue;
-			if ((lsb = _find_symbol(ld->ld_sym, as[i].as_name)) !=
-			    NULL) {
-				lam = _extract_archive_member(ld, lf, la,
-				    as[i].as_off);
-				extracted = 1;
-				ls->ls_extracted[ls->ls_group_level] = 1;
-				if (ld->ld_print_linkmap)
-					_print_extracted_member(ld, lam, lsb);
+			if ((lsb = _find_symbol(ld->ld_sym, as[i].as_name)) ==
+			    NULL || (lsb->lsb_shndx != SHN_UNDEF &&
+			    lsb->lsb_shndx != SHN_COMMON))
+				continue;
+			n = ld->ld_undef_num;
+			lam = _extract_archive_member(ld, lf, la, as[i].as_off);
+			ls->ls_extracted[ls->ls_group_level] = 1;
+			if (ld->ld_print_linkmap)
+				_print_extracted_member(ld, lam, lsb);
+			for (; n < ld->ld_undef_num; n++) {
+				HASH_FIND_STR(la->la_s,
+				    ld->ld_undef[n]->lsb_longname, las);
+				if (las == NULL)
+					continue;
+				_SET_PENDING(las->las_idx);
+				if (las->las_idx < i)
+					again = 1;
 			}
 		}
-	} while (extracted);
+	} while (again);
+
+#undef	_PENDING
+#undef	_SET_PENDING
+#undef	_CLR_PENDING
 }
 
-static void
-_load_elf_symbols(struct ld *ld, struct ld_input *li, Elf *e)
+/*
+ * Symbols are loaded in three steps. _init_elf_symbols() reads the
+ * sections and the version information of an input object and locates
+ * its symbol table. _decode_elf_symbols() then builds the symbol
+ * records of the object, which touches nothing but the object itself
+ * and may run on any thread. Finally _merge_elf_symbols() enters the
+ * records into the global symbol table, in input order.
+ */
+static int
+_init_elf_symbols(struct ld *ld, struct ld_input *li, Elf *e,
+    struct ld_symbol_job *sj)
 {
 	struct ld_input_section *is;
 	Elf_Scn *scn_sym, *scn_dynamic;
 	Elf_Scn *scn_versym, *scn_verneed, *scn_verdef;
 	Elf_Data *d;
-	GElf_Sym sym;
 	GElf_Shdr shdr;
 	size_t dyn_strndx, strndx;
 	int elferr, i;
@@ -1155,7 +1283,7 @@ _load_elf_symbols(struct ld *ld, struct ld_input *li, Elf *e)
 	}
 
 	if (scn_sym == NULL || strndx == SHN_UNDEF)
-		return;
+		return (0);
 
 	ld_symver_load_symbol_version_info(ld, li, e, scn_versym, scn_verneed,
 	    scn_verdef);
@@ -1167,7 +1295,7 @@ _load_elf_symbols(struct ld *ld, struct ld_input *li, Elf *e)
 	if (gelf_getshdr(scn_sym, &shdr) != &shdr) {
 		ld_warn(ld, "%s: gelf_getshdr failed: %s", li->li_name,
 		    elf_errmsg(-1));
-		return;
+		return (0);
 	}
 
 	(void) elf_errno();
@@ -1177,53 +1305,227 @@ _load_elf_symbols(struct ld *ld, struct ld_input *li, Elf *e)
 			ld_warn(ld, "%s: elf_getdata failed: %s", li->li_name,
 			    elf_errmsg(elferr));
 		/* Empty symbol table section? */
-		return;
+		return (0);
 	}
 
 	li->li_symnum = d->d_size / shdr.sh_entsize;
-	for (i = 0; (uint64_t) i < li->li_symnum; i++) {
-		if (gelf_getsym(d, i, &sym) != &sym)
-			ld_warn(ld, "%s: gelf_getsym failed: %s", li->li_name,
-			    elf_errmsg(-1));
-		_add_elf_symbol(ld, li, e, &sym, strndx, i);
-	}
 
+	sj->sj_li = li;
+	sj->sj_e = e;
+	sj->sj_d = d;
+	sj->sj_strndx = strndx;
+
+	return (1);
 }
 
 static void
-_load_symbols(struct ld *ld, struct ld_file *lf)
+_decode_elf_symbols(struct ld *ld, struct ld_arena_chunk **ac,
+    struct ld_symbol_job *sj)
 {
-
-	if (lf->lf_type == LFT_ARCHIVE)
-		_load_archive_symbols(ld, lf);
-	else {
-		lf->lf_input = ld_input_alloc(ld, lf, lf->lf_name);
-		_load_elf_symbols(ld, lf->lf_input, lf->lf_elf);
+	struct ld_input *li;
+	GElf_Sym syms[LD_GELF_BATCH];
+	int i, j, n;
+
+	li = sj->sj_li;
+	for (i = 0; (uint64_t) i < li->li_symnum; i += n) {
+		if ((n = gelf_getsyms(sj->sj_d, i, LD_GELF_BATCH, syms)) <= 0) {
+			ld_warn(ld, "%s: gelf_getsyms failed: %s",
+			    li->li_name, elf_errmsg(-1));
+			break;
+		}
+		for (j = 0; j < n; j++)
+			_add_elf_symbol(ld, ac, li, sj->sj_e, &syms[j],
+			    sj->sj_strndx, i + j);
 	}
 }
 
 static void
-_unload_symbols(struct ld_input *li)
+_merge_elf_symbols(struct ld *ld, struct ld_input *li)
 {
-	int i;
+	struct ld_symbol *lsb;
+	struct ld_symbol_defver *dv;
+	size_t i;
 
 	if (li->li_symindex == NULL)
 		return;
 
-	for (i = 0; (uint64_t) i < li->li_symnum; i++)
-		_free_symbol(li->li_symindex[i]);
+	for (i = 0; i < li->li_symnum; i++) {
+		if ((lsb = li->li_symindex[i]) == NULL)
+			continue;
+
+		/* Keep track of default versions. */
+		if (lsb->lsb_default) {
+			if ((dv = calloc(1, sizeof(*dv))) == NULL)
+				ld_fatal(ld, "calloc");
+			dv->dv_name = lsb->lsb_name;
+			dv->dv_longname = lsb->lsb_longname;
+			dv->dv_ver = lsb->lsb_ver;
+			HASH_ADD_KEYPTR(hh, ld->ld_defver, dv->dv_name,
+			    strlen(dv->dv_name), dv);
+		}
+
+		if (lsb->lsb_bind != STB_LOCAL)
+			_resolve_and_add_symbol(ld, lsb);
+	}
 }
 
 static void
-_free_symbol(struct ld_symbol *lsb)
+_load_elf_symbols(struct ld *ld, struct ld_input *li, Elf *e)
 {
+	struct ld_symbol_job sj;
 
-	if (lsb == NULL)
+	if (!_init_elf_symbols(ld, li, e, &sj))
 		return;
+	_decode_elf_symbols(ld, &ld->ld_arena, &sj);
+	_merge_elf_symbols(ld, li);
+}
 
-	free(lsb->lsb_name);
-	free(lsb->lsb_longname);
-	free(lsb);
+static void *
+_decode_worker(void *arg)
+{
+	struct ld_symbol_worker *sw;
+	struct ld_symbol_pool *sp;
+	struct ld_symbol_job *sj;
+
+	sw = arg;
+	sp = sw->sw_pool;
+	for (;;) {
+		(void) pthread_mutex_lock(&sp->sp_mutex);
+		sj = sp->sp_next < sp->sp_count ? &sp->sp_job[sp->sp_next++] :
+		    NULL;
+		(void) pthread_mutex_unlock(&sp->sp_mutex);
+		if (sj == NULL)
+			break;
+		_decode_elf_symbols(sp->sp_ld, &sw->sw_arena, sj);
+	}
+
+	return (NULL);
+}
+
+static void
+_decode_elf_symbols_parallel(struct ld *ld, struct ld_symbol_job *job,
+    size_t count)
+{
+	struct ld_symbol_pool sp;
+	struct ld_symbol_worker *sw;
+	pthread_t *tid;
+	size_t i, n;
+	int error;
+
+	if (count == 0)
+		return;
+
+	memset(&sp, 0, sizeof(sp));
+	sp.sp_ld = ld;
+	sp.sp_job = job;
+	sp.sp_count = count;
+
+	if ((error = pthread_mutex_init(&sp.sp_mutex, NULL)) != 0) {
+		errno = error;
+		ld_fatal_std(ld, "pthread_mutex_init");
+	}
+
+	/* This thread does its share of the work too. */
+	n = MIN(ld->ld_threads, count);
+	if ((sw = calloc(n, sizeof(*sw))) == NULL)
+		ld_fatal_std(ld, "calloc");
+	if ((tid = calloc(n, sizeof(*tid))) == NULL)
+		ld_fatal_std(ld, "calloc");
+	for (i = 0; i < n; i++)
+		sw[i].sw_pool = &sp;
+	for (i = 1; i < n; i++) {
+		if ((error = pthread_create(&tid[i], NULL, _decode_worker,
+		    &sw[i])) != 0) {
+			errno = error;
+			ld_fatal_std(ld, "pthread_create");
+		}
+	}
+	(void) _decode_worker(&sw[0]);
+	for (i = 1; i < n; i++)
+		(void) pthread_join(tid[i], NULL);
+
+	(void) pthread_mutex_destroy(&sp.sp_mutex);
+
+	for (i = 0; i < n; i++)
+		ld_arena_join(ld, sw[i].sw_arena);
+
+	free(tid);
+	free(sw);
+}
+
+/*
+ * Load the symbols of the run of object files and shared libraries
+ * starting at `lf', all of the same archive group level. Symbols of
+ * up to _SYMBOL_BATCH files per thread are decoded in parallel, then
+ * merged into the symbol table in the order of the files, so that
+ * symbol resolution does not depend on the number of threads. Return
+ * the file following the run.
+ */
+static struct ld_file *
+_load_symbols_parallel(struct ld *ld, struct ld_file *lf)
+{
+	struct ld_state *ls;
+	struct ld_symbol_job *job;
+	struct ld_file **run;
+	size_t i, max, n, nj;
+
+	ls = &ld->ld_state;
+
+	max = (size_t) ld->ld_threads * _SYMBOL_BATCH;
+	if ((run = calloc(max, sizeof(*run))) == NULL)
+		ld_fatal_std(ld, "calloc");
+	if ((job = calloc(max, sizeof(*job))) == NULL)
+		ld_fatal_std(ld, "calloc");
+
+	/*
+	 * Reading the sections of a shared library may add the libraries
+	 * it needs right after it in the file list, so the run is built
+	 * while the files are read.
+	 */
+	n = nj = 0;
+	for (; lf != NULL && n < max; lf = TAILQ_NEXT(lf, lf_next)) {
+		if (n > 0 && lf->lf_group_level != run[0]->lf_group_level)
+			break;
+		ld_file_load(ld, lf);
+		if (ls->ls_arch_conflict) {
+			ld_file_unload(ld, lf);
+			break;
+		}
+		if (lf->lf_type == LFT_ARCHIVE || lf->lf_type == LFT_BINARY) {
+			ld_file_unload(ld, lf);
+			break;
+		}
+		run[n++] = lf;
+		lf->lf_input = ld_input_alloc(ld, lf, lf->lf_name);
+		if (_init_elf_symbols(ld, lf->lf_input, lf->lf_elf, &job[nj]))
+			nj++;
+	}
+
+	if (!ls->ls_arch_conflict) {
+		_decode_elf_symbols_parallel(ld, job, nj);
+		for (i = 0; i < n; i++)
+			_merge_elf_symbols(ld, run[i]->lf_input);
+	}
+
+	for (i = 0; i < n; i++)
+		ld_file_unload(ld, run[i]);
+
+	free(job);
+	free(run);
+
+	return (lf);
+}
+
+static void
+_load_symbols(struct ld *ld, struct ld_file *lf)
+{
+
+	if (lf->lf_type == LFT_ARCHIVE)
+		_load_archive_symbols(ld, lf);
+	else {
+		lf->lf_input = ld_input_alloc(ld, lf, lf->lf_name);
+		_load_elf_symbols(ld, lf->lf_input, lf->lf_elf);
+	}
 }
 
 static void
@@ -1245,6 +1547,20 @@ _update_symbol(struct ld_symbol *lsb)
 		is = lsb->lsb_is;
 		if (is == NULL || (os = is->is_output) == NULL)
 			return;
+		if (is->is_merge != NULL) {
+			/*
+			 * The section was merged: section symbols refer to
+			 * the merged section, whose offsets the relocation
+			 * addends already are, and other symbols move with
+			 * the piece they are defined in.
+			 */
+			if (lsb->lsb_type == STT_SECTION)
+				lsb->lsb_value = 0;
+			else
+				lsb->lsb_value = ld_merge_offset(is,
+				    lsb->lsb_value);
+			is = is->is_merge->ms_leader;
+		}
 		lsb->lsb_value += os->os_addr + is->is_reloff;
 		lsb->lsb_shndx = elf_ndxscn(os->os_scn);
 	}
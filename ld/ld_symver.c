@@ -25,6 +25,7 @@
  */
 
 #include "ld.h"
+#include "ld_arena.h"
 #include "ld_input.h"
 #include "ld_layout.h"
 #include "ld_output.h"
@@ -44,8 +45,55 @@ ELFTC_VCSID("$Id$");
 #define	Elf_Verneed	Elf32_Verneed
 #define	Elf_Vernaux	Elf32_Vernaux
 
+/*
+ * Version script patterns are compiled into a matcher the first time
+ * a symbol is looked up. Patterns are numbered in script order and
+ * the lowest numbered match wins, except that a pattern without glob
+ * characters always takes precedence over a glob pattern. Patterns
+ * without glob characters are kept in a hash table, patterns of the
+ * form "prefix*" terminate at a node of a byte trie, and the remaining
+ * patterns hang off the trie node of their literal prefix, so that
+ * fnmatch(3) is only called for names that share that prefix. Patterns
+ * inside an extern "C++" block have their own hash table and trie and
+ * are matched against the demangled symbol name.
+ */
+
+#define	_VS_C		0	/* patterns matching the symbol name */
+#define	_VS_CPP		1	/* patterns matching the demangled name */
+
+struct ld_symver_pattern {
+	char *vp_name;			/* pattern */
+	unsigned vp_id;			/* pattern number */
+	uint16_t vp_ndx;		/* resulting version index */
+	struct ld_symver_pattern *vp_next; /* next pattern */
+	UT_hash_handle hh;		/* hash handle (exact names) */
+};
+
+struct ld_symver_node {
+	unsigned char vn_c;		/* byte leading to this node */
+	struct ld_symver_node *vn_child; /* first child */
+	struct ld_symver_node *vn_sibling; /* next sibling */
+	struct ld_symver_pattern *vn_prefix; /* first "prefix*" pattern */
+	struct ld_symver_pattern *vn_glob; /* other patterns */
+	struct ld_symver_pattern *vn_gtail; /* last of the other patterns */
+};
+
+struct ld_symver_matcher {
+	struct ld_symver_pattern *vm_exact[2]; /* exact name hash */
+	struct ld_symver_node vm_root[2]; /* prefix trie */
+	unsigned vm_cpp;		/* number of C++ patterns */
+};
+
 static void _add_version_name(struct ld *ld, struct ld_input *li, int ndx,
     const char *name);
+static void _compile_version_pattern(struct ld *ld,
+    struct ld_symver_matcher *vm, struct ld_script_version_entry *ldve,
+    unsigned id, uint16_t ndx);
+static void _compile_version_script(struct ld *ld);
+static char *_demangle_symbol(struct ld *ld, const char *name);
+static struct ld_symver_pattern *_match_version_glob(
+    struct ld_symver_node *root, const char *name,
+    struct ld_symver_pattern *best);
 static struct ld_symver_vda *_alloc_vda(struct ld *ld, const char *name,
     struct ld_symver_verdef *svd);
 static struct ld_symver_vna *_alloc_vna(struct ld *ld, const char *name,
@@ -152,14 +200,21 @@ ld_symver_create_verneed_section(struct ld *ld)
 			if (svd->svd_flags & VER_FLG_BASE)
 				continue;
 
-			/* Skip version definition that is never ref'ed. */
-			if (svd->svd_ref == 0)
-				continue;
-
 			/* Invalid Verdef? */
 			if ((sda = STAILQ_FIRST(&svd->svd_aux)) == NULL)
 				continue;
 
+			/*
+			 * Skip version definition that is never ref'ed. The
+			 * glibc dynamic linker refuses to load an object
+			 * with DT_RELR unless it depends on version
+			 * GLIBC_ABI_DT_RELR, which is therefore taken as
+			 * ref'ed if .relr.dyn is created.
+			 */
+			if (svd->svd_ref == 0 && (lo->lo_relr_dyn == NULL ||
+			    strcmp(sda->sda_name, "GLIBC_ABI_DT_RELR") != 0))
+				continue;
+
 			if (lo->lo_vnlist == NULL) {
 				lo->lo_vnlist = calloc(1,
 				    sizeof(*lo->lo_vnlist));
@@ -781,13 +836,184 @@ _load_verdef(struct ld *ld, struct ld_input *li, Elf_Verdef *vd)
 	return (svd);
 }
 
+static void
+_compile_version_pattern(struct ld *ld, struct ld_symver_matcher *vm,
+    struct ld_script_version_entry *ldve, unsigned id, uint16_t ndx)
+{
+	struct ld_symver_node *vn, *_vn;
+	struct ld_symver_pattern *vp, *_vp;
+	char *name, *p, *q;
+	size_t i, len;
+	int t;
+
+	/* Java names are not demangled and match like C names. */
+	t = ldve->ldve_lang == VL_CPP ? _VS_CPP : _VS_C;
+	if (t == _VS_CPP)
+		vm->vm_cpp++;
+
+	vp = ld_arena_calloc(ld, 1, sizeof(*vp));
+	vp->vp_id = id;
+	vp->vp_ndx = ndx;
+
+	name = ldve->ldve_sym;
+	if (!ldve->ldve_glob) {
+		/*
+		 * Strip the escapes so the pattern can be looked up by
+		 * the name it matches. Only the first occurrence of a
+		 * name matters.
+		 */
+		vp->vp_name = ld_arena_strdup(ld, name);
+		for (p = q = vp->vp_name; *p != '\0'; p++) {
+			if (*p == '\\' && p[1] != '\0')
+				p++;
+			*q++ = *p;
+		}
+		*q = '\0';
+		HASH_FIND_STR(vm->vm_exact[t], vp->vp_name, _vp);
+		if (_vp == NULL)
+			HASH_ADD_KEYPTR(hh, vm->vm_exact[t], vp->vp_name,
+			    strlen(vp->vp_name), vp);
+		return;
+	}
+	vp->vp_name = name;
+
+	/* Walk down the trie along the literal prefix. */
+	len = strcspn(name, "*?[\\");
+	vn = &vm->vm_root[t];
+	for (i = 0; i < len; i++) {
+		for (_vn = vn->vn_child; _vn != NULL; _vn = _vn->vn_sibling)
+			if (_vn->vn_c == (unsigned char) name[i])
+				break;
+		if (_vn == NULL) {
+			_vn = ld_arena_calloc(ld, 1, sizeof(*_vn));
+			_vn->vn_c = (unsigned char) name[i];
+			_vn->vn_sibling = vn->vn_child;
+			vn->vn_child = _vn;
+		}
+		vn = _vn;
+	}
+
+	/*
+	 * Identical "prefix*" patterns match the same names, so only
+	 * the first one is kept. The other patterns are kept in script
+	 * order.
+	 */
+	if (name[len] == '*' && name[len + 1] == '\0') {
+		if (vn->vn_prefix == NULL)
+			vn->vn_prefix = vp;
+	} else {
+		if (vn->vn_gtail != NULL)
+			vn->vn_gtail->vp_next = vp;
+		else
+			vn->vn_glob = vp;
+		vn->vn_gtail = vp;
+	}
+}
+
+static void
+_compile_version_script(struct ld *ld)
+{
+	struct ld_symver_matcher *vm;
+	struct ld_script_version_node *ldvn;
+	struct ld_script_version_entry *ldve;
+	unsigned id;
+	uint16_t ndx, ret_ndx;
+
+	vm = ld_arena_calloc(ld, 1, sizeof(*vm));
+
+	id = 0;
+	ndx = 2;
+	STAILQ_FOREACH(ldvn, &ld->ld_scp->lds_vn, ldvn_next) {
+		STAILQ_FOREACH(ldve, ldvn->ldvn_e, ldve_next) {
+			assert(ldve->ldve_sym != NULL);
+			if (ldve->ldve_local)
+				ret_ndx = 0;
+			else if (ldvn->ldvn_name != NULL)
+				ret_ndx = ndx;
+			else
+				ret_ndx = 1;
+			_compile_version_pattern(ld, vm, ldve, id++, ret_ndx);
+		}
+		if (ldvn->ldvn_name != NULL)
+			ndx++;
+	}
+
+	ld->ld_vm = vm;
+}
+
+static char *
+_demangle_symbol(struct ld *ld, const char *name)
+{
+	char *buf;
+	size_t sz;
+
+	/*
+	 * Names that are not mangled match extern "C++" patterns as
+	 * they are.
+	 */
+	if (strncmp(name, "_Z", 2) != 0)
+		return (NULL);
+
+	sz = strlen(name) * 2 + 64;
+	for (;;) {
+		if ((buf = malloc(sz)) == NULL)
+			ld_fatal_std(ld, "malloc");
+		if (elftc_demangle(name, buf, sz, 0) == 0)
+			return (buf);
+		free(buf);
+		if (errno != ENAMETOOLONG)
+			return (NULL);
+		sz *= 2;
+	}
+}
+
+static struct ld_symver_pattern *
+_match_version_glob(struct ld_symver_node *root, const char *name,
+    struct ld_symver_pattern *best)
+{
+	struct ld_symver_node *vn;
+	struct ld_symver_pattern *vp;
+	const char *p;
+
+	/*
+	 * The "prefix*" pattern on the path matches. The other patterns
+	 * on the path share their literal prefix with the name and need
+	 * a closer look, unless an earlier pattern matched already.
+	 */
+	vn = root;
+	p = name;
+	for (;;) {
+		vp = vn->vn_prefix;
+		if (vp != NULL && (best == NULL || vp->vp_id < best->vp_id))
+			best = vp;
+		for (vp = vn->vn_glob; vp != NULL; vp = vp->vp_next) {
+			if (best != NULL && vp->vp_id >= best->vp_id)
+				break;
+			if (fnmatch(vp->vp_name, name, 0) == 0) {
+				best = vp;
+				break;
+			}
+		}
+		if (*p == '\0')
+			break;
+		for (vn = vn->vn_child; vn != NULL; vn = vn->vn_sibling)
+			if (vn->vn_c == (unsigned char) *p)
+				break;
+		if (vn == NULL)
+			break;
+		p++;
+	}
+
+	return (best);
+}
+
 uint16_t
 ld_symver_search_version_script(struct ld *ld, struct ld_symbol *lsb)
 {
 	struct ld_script *lds;
-	struct ld_script_version_node *ldvn;
-	struct ld_script_version_entry *ldve, *ldve_g;
-	uint16_t ndx, ret_ndx, ret_ndx_g;
+	struct ld_symver_matcher *vm;
+	struct ld_symver_pattern *vp, *_vp;
+	char *cname, *dname;
 
 	/* If the symbol version index was known, return it directly. */
 	if (lsb->lsb_vndx_known)
@@ -804,51 +1030,44 @@ ld_symver_search_version_script(struct ld *ld, struct ld_symbol *lsb)
 		return (1);
 	}
 
-	/* Search for a match in the version patterns. */
-	ndx = 2;
-	ldve_g = NULL;
-	ret_ndx_g = 0;
-	STAILQ_FOREACH(ldvn, &lds->lds_vn, ldvn_next) {
-		STAILQ_FOREACH(ldve, ldvn->ldvn_e, ldve_next) {
-			assert(ldve->ldve_sym != NULL);
-			if (fnmatch(ldve->ldve_sym, lsb->lsb_name, 0) == 0) {
-				if (ldve->ldve_local)
-					ret_ndx = 0;
-				else if (ldvn->ldvn_name != NULL)
-					ret_ndx = ndx;
-				else
-					ret_ndx = 1;
-
-				/*
-				 * If the version name is a globbing pattern,
-				 * we only consider it is a match when there
-				 * doesn't exist a exact match.
-				 */
-				if (ldve->ldve_glob) {
-					if (ldve_g == NULL) {
-						ldve_g = ldve;
-						ret_ndx_g = ret_ndx;
-					}
-				} else {
-					lsb->lsb_vndx = ret_ndx;
-					return (ret_ndx);
-				}
-			}
-		}
-		if (ldvn->ldvn_name != NULL)
-			ndx++;
+	if (ld->ld_vm == NULL)
+		_compile_version_script(ld);
+	vm = ld->ld_vm;
+
+	/*
+	 * The symbol version index is cached in the symbol, so the name
+	 * is demangled at most once per symbol.
+	 */
+	dname = NULL;
+	cname = lsb->lsb_name;
+	if (vm->vm_cpp > 0 && (dname = _demangle_symbol(ld, lsb->lsb_name)) !=
+	    NULL)
+		cname = dname;
+
+	/* Search for an exact match in the version patterns. */
+	HASH_FIND_STR(vm->vm_exact[_VS_C], lsb->lsb_name, vp);
+	if (vm->vm_cpp > 0) {
+		HASH_FIND_STR(vm->vm_exact[_VS_CPP], cname, _vp);
+		if (_vp != NULL && (vp == NULL || _vp->vp_id < vp->vp_id))
+			vp = _vp;
 	}
 
 	/* There is no exact match, check if there is a globbing match. */
-	if (ldve_g != NULL) {
-		lsb->lsb_vndx = ret_ndx_g;
-		return (ret_ndx_g);
+	if (vp == NULL) {
+		vp = _match_version_glob(&vm->vm_root[_VS_C], lsb->lsb_name,
+		    NULL);
+		if (vm->vm_cpp > 0)
+			vp = _match_version_glob(&vm->vm_root[_VS_CPP], cname,
+			    vp);
 	}
 
+	free(dname);
+
 	/*
-	 * Symbol doesn't match any version definition, set version
+	 * If the symbol doesn't match any version definition, set version
 	 * to *global*.
 	 */
-	lsb->lsb_vndx = 1;
-	return (1);
+	lsb->lsb_vndx = vp != NULL ? vp->vp_ndx : 1;
+
+	return (lsb->lsb_vndx);
 }
@@ -35,6 +35,10 @@
 
 #include "_elftc.h"
 
+#if	ELFTC_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 /*
  * Library-private data structures.
  */
@@ -45,16 +49,27 @@ struct _libelf_globals {
 	int		libelf_arch;
 	unsigned int	libelf_byteorder;
 	int		libelf_class;
-	int		libelf_error;
 	int		libelf_fillchar;
 	unsigned int	libelf_version;
-	char		libelf_msg[LIBELF_MSG_SIZE];
 };
 
 extern struct _libelf_globals _libelf;
 
 #define	LIBELF_PRIVATE(N)	(_libelf.libelf_##N)
 
+/*
+ * Error state is kept per-thread, so that threads working on
+ * unrelated descriptors do not see each other's errors.
+ */
+struct _libelf_thread_globals {
+	int		libelf_error;
+	char		libelf_msg[LIBELF_MSG_SIZE];
+};
+
+extern ELFTC_THREAD_LOCAL struct _libelf_thread_globals _libelf_thread;
+
+#define	LIBELF_THREAD_PRIVATE(N)	(_libelf_thread.libelf_##N)
+
 #define	LIBELF_ELF_ERROR_MASK			0xFF
 #define	LIBELF_OS_ERROR_SHIFT			8
 
@@ -62,11 +77,27 @@ extern struct _libelf_globals _libelf;
 	((O) << LIBELF_OS_ERROR_SHIFT))
 
 #define	LIBELF_SET_ERROR(E, O) do {					\
-		LIBELF_PRIVATE(error) = LIBELF_ERROR(ELF_E_##E, (O));	\
+		LIBELF_THREAD_PRIVATE(error) =				\
+		    LIBELF_ERROR(ELF_E_##E, (O));			\
 	} while (0)
 
+/*
+ * Each descriptor carries a lock that serializes the lazy loading of
+ * its contents, so that threads may read a shared descriptor.
+ */
+#if	ELFTC_HAVE_PTHREADS
+#define	LIBELF_LOCK(E)		(void) pthread_mutex_lock(&(E)->e_lock)
+#define	LIBELF_UNLOCK(E)	(void) pthread_mutex_unlock(&(E)->e_lock)
+#else
+#define	LIBELF_LOCK(E)		do { } while (0)
+#define	LIBELF_UNLOCK(E)	do { } while (0)
+#endif
+
 #define	LIBELF_ADJUST_AR_SIZE(S)	(((S) + 1U) & ~1U)
 
+#define	LIBELF_SCN_INDEX_MIN	16	/* initial size of e_scnndx[] */
+#define	LIBELF_OUTPUT_CHUNK	65536	/* elf_update() write granularity */
+
 /*
  * Flags for library internal use.  These use the upper 16 bits of the
  * `e_flags' field.
@@ -79,6 +110,7 @@ extern struct _libelf_globals _libelf;
 #define	LIBELF_F_RAWFILE_MMAP	0x100000 /* whether e_rawfile was mmap'ed */
 #define	LIBELF_F_SHDRS_LOADED	0x200000 /* whether all shdrs were read in */
 #define	LIBELF_F_SPECIAL_FILE	0x400000 /* non-regular file */
+#define	LIBELF_F_DATA_SHARED	0x800000 /* data points into e_rawfile */
 
 struct _Elf {
 	int		e_activations;	/* activation count */
@@ -92,6 +124,9 @@ struct _Elf {
 	char		*e_rawfile;	/* uninterpreted bytes */
 	size_t		e_rawsize;	/* size of uninterpreted bytes */
 	unsigned int	e_version;	/* file version */
+#if	ELFTC_HAVE_PTHREADS
+	pthread_mutex_t	e_lock;		/* see LIBELF_LOCK() */
+#endif
 
 	/*
 	 * Header information for archive members.  See the
@@ -123,6 +158,8 @@ struct _Elf {
 				Elf64_Phdr *e_phdr64;
 			} e_phdr;
 			STAILQ_HEAD(, _Elf_Scn)	e_scn;	/* section list */
+			Elf_Scn	**e_scnndx;	/* sections, by index */
+			size_t	e_scnndxsz;	/* size of e_scnndx[] */
 			size_t	e_nphdr;	/* number of Phdr entries */
 			size_t	e_nscn;		/* number of sections */
 			size_t	e_strndx;	/* string table section index */
@@ -154,6 +191,8 @@ struct _Elf_Scn {
 	uint64_t	s_offset;	/* managed by elf_update() */
 	uint64_t	s_rawoff;	/* original offset in the file */
 	uint64_t	s_size;		/* managed by elf_update() */
+	struct _Libelf_Data *s_strdata;	/* string table, for elf_strptr() */
+	uint64_t	s_strsize;	/* sh_size when s_strdata was set */
 };
 
 
@@ -201,8 +240,11 @@ size_t	_libelf_fsize(Elf_Type _t, int _elfclass, unsigned int _version,
     size_t count);
 int	(*_libelf_get_translator(Elf_Type _t, int _direction, int _elfclass))
 	    (char *_dst, size_t dsz, char *_src, size_t _cnt, int _byteswap);
+int	_libelf_getdata_array(Elf_Data *_d, Elf_Type _t, int _ndx, int _count,
+    int *_ec);
 void	*_libelf_getphdr(Elf *_e, int _elfclass);
 void	*_libelf_getshdr(Elf_Scn *_scn, int _elfclass);
+int	_libelf_grow_scn_index(Elf *_e, size_t _nscn);
 void	_libelf_init_elf(Elf *_e, Elf_Kind _kind);
 int	_libelf_load_section_headers(Elf *e, void *ehdr);
 int	_libelf_malign(Elf_Type _t, int _elfclass);
@@ -217,6 +259,8 @@ int	_libelf_setphnum(Elf *_e, void *_eh, int _elfclass, size_t _phnum);
 int	_libelf_setshnum(Elf *_e, void *_eh, int _elfclass, size_t _shnum);
 int	_libelf_setshstrndx(Elf *_e, void *_eh, int _elfclass,
     size_t _shstrndx);
+int	_libelf_swap_fields(char *_dst, const char *_src, size_t _count,
+    size_t _size, const unsigned char *_layout, size_t _nfields);
 Elf_Data *_libelf_xlate(Elf_Data *_d, const Elf_Data *_s,
     unsigned int _encoding, int _elfclass, int _direction);
 int	_libelf_xlate_shtype(uint32_t _sht);
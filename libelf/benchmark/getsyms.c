@@ -0,0 +1,123 @@
+/*
+ * Compare the cost of retrieving symbols one at a time using
+ * gelf_getsym(3) with that of retrieving them in batches using
+ * gelf_getsyms(3).
+ *
+ * The symbol tables of the ELF objects named on the command line are
+ * repeatedly walked using each interface, and the time taken per
+ * symbol is reported in nanoseconds.
+ *
+ *	cc -O2 -I /usr/include/libelf -o getsyms getsyms.c -lelf
+ *
+ * $Id$
+ */
+
+#include <sys/time.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <gelf.h>
+#include <libelf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define	BATCH		256	/* symbols retrieved per gelf_getsyms() */
+#define	MINTIME		0.25	/* seconds per measurement */
+
+static double
+now(void)
+{
+	struct timeval tv;
+
+	(void) gettimeofday(&tv, NULL);
+	return (tv.tv_sec + tv.tv_usec / 1e6);
+}
+
+/*
+ * Return the time taken, in nanoseconds, to retrieve each of the
+ * `count' symbols in `d'.
+ */
+static double
+measure(Elf_Data *d, int count, int batched)
+{
+	GElf_Sym sym, syms[BATCH];
+	double elapsed, start;
+	unsigned long sum;
+	size_t iter;
+	int i, n;
+
+	sum = 0;
+	iter = 0;
+	start = now();
+	do {
+		if (batched) {
+			for (i = 0; i < count; i += n) {
+				if ((n = gelf_getsyms(d, i, BATCH, syms)) <= 0)
+					errx(1, "gelf_getsyms() failed: %s",
+					    elf_errmsg(-1));
+				sum += syms[n - 1].st_value;
+			}
+		} else {
+			for (i = 0; i < count; i++) {
+				if (gelf_getsym(d, i, &sym) != &sym)
+					errx(1, "gelf_getsym() failed: %s",
+					    elf_errmsg(-1));
+				sum += sym.st_value;
+			}
+		}
+		iter++;
+	} while ((elapsed = now() - start) < MINTIME);
+
+	if (sum == 1)		/* keep the loops from being elided */
+		(void) putchar(' ');
+
+	return (elapsed * 1e9 / ((double) iter * count));
+}
+
+int
+main(int argc, char **argv)
+{
+	Elf *e;
+	Elf_Data *d;
+	Elf_Scn *scn;
+	GElf_Shdr shdr;
+	int count, fd, i;
+
+	if (argc < 2)
+		errx(1, "usage: getsyms file...");
+
+	if (elf_version(EV_CURRENT) == EV_NONE)
+		errx(1, "elf_version() failed: %s", elf_errmsg(-1));
+
+	printf("file\tsymbols\tgetsym ns\tgetsyms ns\n");
+	for (i = 1; i < argc; i++) {
+		if ((fd = open(argv[i], O_RDONLY)) < 0)
+			err(1, "%s", argv[i]);
+		if ((e = elf_begin(fd, ELF_C_READ, NULL)) == NULL)
+			errx(1, "%s: elf_begin() failed: %s", argv[i],
+			    elf_errmsg(-1));
+
+		scn = NULL;
+		while ((scn = elf_nextscn(e, scn)) != NULL) {
+			if (gelf_getshdr(scn, &shdr) != &shdr)
+				errx(1, "gelf_getshdr() failed: %s",
+				    elf_errmsg(-1));
+			if (shdr.sh_type != SHT_SYMTAB ||
+			    (d = elf_getdata(scn, NULL)) == NULL ||
+			    shdr.sh_entsize == 0)
+				continue;
+			if ((count = (int) (d->d_size / gelf_fsize(e,
+			    ELF_T_SYM, 1, EV_CURRENT))) == 0)
+				continue;
+			printf("%s\t%d", argv[i], count);
+			printf("\t%.2f", measure(d, count, 0));
+			printf("\t\t%.2f\n", measure(d, count, 1));
+		}
+
+		(void) elf_end(e);
+		(void) close(fd);
+	}
+
+	return (0);
+}
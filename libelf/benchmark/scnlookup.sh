@@ -0,0 +1,47 @@
+#!/bin/sh
+# $Id$
+
+# Measure the cost of looking up sections by index in objects with a
+# large number of sections.  An object with one section per function
+# is generated, and the time taken by nm(1) to resolve the section of
+# every symbol is reported.
+
+n=3			# number of repetitions
+NM=${NM:-"nm"}		# nm(1) implementations to compare
+CC=${CC:-"cc"}
+
+test $# -ge 1 || {
+    echo "usage: $0 number_of_sections [work_dir]"
+    exit 0
+}
+
+nscn=$1
+dir=${2:-/tmp}/scnlookup.$$
+src=$dir/scn.c
+obj=$dir/scn.o
+
+mkdir -p $dir || exit 1
+
+awk -v n=$nscn 'BEGIN {
+    for (i = 0; i < n; i++)
+	printf "int f%d(void) { return %d; }\n", i, i;
+}' > $src
+
+$CC -c -ffunction-sections -o $obj $src || exit 1
+
+echo "object=$obj, `readelf -h $obj | awk '/Number of section headers/ { print $NF }'` sections"
+echo "best time of $n repetitions"
+echo "program	real	user	system"
+for nm in $NM; do
+    echo -n "$nm	"
+    num=0
+    while [ $num -lt $n ]; do
+	{ time -p $nm $obj > /dev/null; } 2>> $dir/times
+	num=`expr $num + 1`
+    done
+    awk '/^real/ { r = $2 } /^user/ { u = $2 } /^sys/ { print r "\t" u "\t" $2 }' \
+	$dir/times | sort -n | head -n 1
+    rm -f $dir/times
+done
+
+rm -rf $dir
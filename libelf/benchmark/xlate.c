@@ -0,0 +1,135 @@
+/*
+ * Measure the throughput of the ELF(3) data translation routines.
+ *
+ * For each ELF type listed below, a buffer of file data in the
+ * non-native byte order is repeatedly translated to its in-memory
+ * representation and back again, and the rates achieved are reported
+ * in megabytes per second of file data.
+ *
+ * To compare implementations, build this program against each
+ * libelf(3) in turn, for example:
+ *
+ *	cc -O2 -I /usr/include/libelf -o xlate xlate.c -lelf
+ *
+ * $Id$
+ */
+
+#include <sys/time.h>
+
+#include <err.h>
+#include <gelf.h>
+#include <libelf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define	BUFSIZE		(4 * 1024 * 1024)	/* bytes of file data */
+#define	MINTIME		0.25			/* seconds per measurement */
+
+static struct {
+	const char	*name;
+	Elf_Type	type;
+} types[] = {
+	{ "HALF",	ELF_T_HALF },
+	{ "WORD",	ELF_T_WORD },
+	{ "XWORD",	ELF_T_XWORD },
+	{ "SYM",	ELF_T_SYM },
+	{ "REL",	ELF_T_REL },
+	{ "RELA",	ELF_T_RELA },
+	{ "DYN",	ELF_T_DYN },
+	{ "SHDR",	ELF_T_SHDR },
+	{ "PHDR",	ELF_T_PHDR }
+};
+
+static double
+now(void)
+{
+	struct timeval tv;
+
+	(void) gettimeofday(&tv, NULL);
+	return (tv.tv_sec + tv.tv_usec / 1e6);
+}
+
+/*
+ * Return the rate, in MB/s, at which `fsz' bytes of file data are
+ * translated in direction `tof'.  The size of the in-memory data is
+ * returned in `*mszp' when translating to memory, and is used as the
+ * source size when translating to the file representation.
+ */
+static double
+measure(int elfclass, Elf_Type t, unsigned int encoding, char *file,
+    size_t fsz, char *mem, size_t *mszp, int tof)
+{
+	Elf_Data dst, src, *r;
+	double elapsed, start;
+	size_t n;
+
+	n = 0;
+	start = now();
+	do {
+		src.d_type = dst.d_type = t;
+		src.d_version = dst.d_version = EV_CURRENT;
+		if (tof) {
+			src.d_buf = mem; src.d_size = *mszp;
+			dst.d_buf = file; dst.d_size = fsz;
+			r = (elfclass == ELFCLASS32 ? elf32_xlatetof :
+			    elf64_xlatetof)(&dst, &src, encoding);
+		} else {
+			src.d_buf = file; src.d_size = fsz;
+			dst.d_buf = mem; dst.d_size = 2 * BUFSIZE;
+			r = (elfclass == ELFCLASS32 ? elf32_xlatetom :
+			    elf64_xlatetom)(&dst, &src, encoding);
+			*mszp = dst.d_size;
+		}
+		if (r == NULL)
+			errx(1, "translation failed: %s", elf_errmsg(-1));
+		n++;
+	} while ((elapsed = now() - start) < MINTIME);
+
+	return ((double) n * fsz / elapsed / (1024 * 1024));
+}
+
+int
+main(void)
+{
+	size_t fsz, i, msz;
+	unsigned int encoding;
+	int elfclass;
+	char *file, *mem;
+	union { uint16_t h; char c[2]; } u;
+
+	if (elf_version(EV_CURRENT) == EV_NONE)
+		errx(1, "elf_version() failed: %s", elf_errmsg(-1));
+
+	/* Use the byte order opposite to that of the host. */
+	u.h = 1;
+	encoding = u.c[0] ? ELFDATA2MSB : ELFDATA2LSB;
+
+	if ((file = malloc(BUFSIZE)) == NULL ||
+	    (mem = malloc(2 * BUFSIZE)) == NULL)
+		err(1, "malloc");
+
+	for (i = 0; i < BUFSIZE; i++)
+		file[i] = (char) (i * 7 + 1);
+
+	printf("type\tclass\ttom MB/s\ttof MB/s\n");
+	for (elfclass = ELFCLASS32; elfclass <= ELFCLASS64; elfclass++) {
+		for (i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+			if (types[i].type == ELF_T_XWORD &&
+			    elfclass == ELFCLASS32)
+				continue;
+			fsz = (elfclass == ELFCLASS32 ? elf32_fsize :
+			    elf64_fsize)(types[i].type, 1, EV_CURRENT);
+			fsz *= BUFSIZE / fsz;
+			printf("%s\t%d", types[i].name,
+			    elfclass == ELFCLASS32 ? 32 : 64);
+			printf("\t%.1f", measure(elfclass, types[i].type,
+			    encoding, file, fsz, mem, &msz, 0));
+			printf("\t\t%.1f\n", measure(elfclass, types[i].type,
+			    encoding, file, fsz, mem, &msz, 1));
+		}
+	}
+
+	return (0);
+}
@@ -34,7 +34,8 @@ struct _libelf_globals _libelf = {
 	.libelf_arch		= LIBELF_ARCH,
 	.libelf_byteorder	= LIBELF_BYTEORDER,
 	.libelf_class		= LIBELF_CLASS,
-	.libelf_error		= 0,
 	.libelf_fillchar	= 0,
 	.libelf_version		= EV_NONE
 };
+
+ELFTC_THREAD_LOCAL struct _libelf_thread_globals _libelf_thread;
@@ -33,8 +33,32 @@
 
 ELFTC_VCSID("$Id$");
 
-Elf_Data *
-elf_getdata(Elf_Scn *s, Elf_Data *ed)
+/*
+ * Check whether section data of type `t' starting at offset `off'
+ * in the file image can be handed to the application without being
+ * translated, i.e., whether its file and memory representations are
+ * identical and the data is suitably aligned in memory.
+ */
+static int
+_libelf_data_is_shareable(Elf *e, Elf_Type t, size_t fsz, size_t msz,
+    uint64_t off)
+{
+	if (t == ELF_T_BYTE)
+		return (1);
+
+	if (e->e_byteorder != LIBELF_PRIVATE(byteorder) || fsz != msz)
+		return (0);
+
+	/* Types whose translators also validate their contents. */
+	if (t == ELF_T_GNUHASH || t == ELF_T_VDEF || t == ELF_T_VNEED)
+		return (0);
+
+	return (((uintptr_t) (e->e_rawfile + off) %
+	    _libelf_malign(t, e->e_class)) == 0);
+}
+
+static Elf_Data *
+_libelf_getdata(Elf_Scn *s, Elf_Data *ed)
 {
 	Elf *e;
 	unsigned int sh_type;
@@ -129,6 +153,20 @@ elf_getdata(Elf_Scn *s, Elf_Data *ed)
 		return (&d->d_data);
         }
 
+	/*
+	 * If the application asked for it, reference the file's
+	 * contents directly when no translation would be needed.
+	 * elf_flagdata(3) makes a private copy of the data if the
+	 * descriptor is later marked dirty.
+	 */
+	if ((e->e_flags & ELF_F_NOCOPY) &&
+	    _libelf_data_is_shareable(e, elftype, fsz, msz, sh_offset)) {
+		d->d_data.d_buf = e->e_rawfile + sh_offset;
+		d->d_flags |= LIBELF_F_DATA_SHARED;
+		STAILQ_INSERT_TAIL(&s->s_data, d, d_next);
+		return (&d->d_data);
+	}
+
 	if ((d->d_data.d_buf = malloc(msz*count)) == NULL) {
 		(void) _libelf_release_data(d);
 		LIBELF_SET_ERROR(RESOURCE, 0);
@@ -151,6 +189,24 @@ elf_getdata(Elf_Scn *s, Elf_Data *ed)
 	return (&d->d_data);
 }
 
+Elf_Data *
+elf_getdata(Elf_Scn *s, Elf_Data *ed)
+{
+	Elf *e;
+	Elf_Data *d;
+
+	if (s == NULL || (e = s->s_elf) == NULL) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (NULL);
+	}
+
+	LIBELF_LOCK(e);
+	d = _libelf_getdata(s, ed);
+	LIBELF_UNLOCK(e);
+
+	return (d);
+}
+
 Elf_Data *
 elf_newdata(Elf_Scn *s)
 {
@@ -194,8 +250,8 @@ elf_newdata(Elf_Scn *s)
  * `s'.
  */
 
-Elf_Data *
-elf_rawdata(Elf_Scn *s, Elf_Data *ed)
+static Elf_Data *
+_libelf_rawdata(Elf_Scn *s, Elf_Data *ed)
 {
 	Elf *e;
 	int elf_class;
@@ -254,3 +310,21 @@ elf_rawdata(Elf_Scn *s, Elf_Data *ed)
 
 	return (&d->d_data);
 }
+
+Elf_Data *
+elf_rawdata(Elf_Scn *s, Elf_Data *ed)
+{
+	Elf *e;
+	Elf_Data *d;
+
+	if (s == NULL || (e = s->s_elf) == NULL) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (NULL);
+	}
+
+	LIBELF_LOCK(e);
+	d = _libelf_rawdata(s, ed);
+	LIBELF_UNLOCK(e);
+
+	return (d);
+}
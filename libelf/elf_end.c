@@ -43,27 +43,28 @@ elf_end(Elf *e)
 {
 	Elf *sv;
 	Elf_Scn *scn, *tscn;
+	int activations, reclaim;
 
 	if (e == NULL || e->e_activations == 0)
 		return (0);
 
-	if (--e->e_activations > 0)
-		return (e->e_activations);
+	/*
+	 * If we still have open child descriptors, we need to defer
+	 * reclaiming resources till all the child descriptors for the
+	 * archive are closed.  Archive members may be closed from other
+	 * threads, so this check is made with the archive's lock held.
+	 */
+	LIBELF_LOCK(e);
+	activations = --e->e_activations;
+	reclaim = activations == 0 && (e->e_kind != ELF_K_AR ||
+	    e->e_u.e_ar.e_nchildren == 0);
+	LIBELF_UNLOCK(e);
 
-	assert(e->e_activations == 0);
+	if (activations > 0)
+		return (activations);
 
-	while (e && e->e_activations == 0) {
+	while (e && reclaim) {
 		switch (e->e_kind) {
-		case ELF_K_AR:
-			/*
-			 * If we still have open child descriptors, we
-			 * need to defer reclaiming resources till all
-			 * the child descriptors for the archive are
-			 * closed.
-			 */
-			if (e->e_u.e_ar.e_nchildren > 0)
-				return (0);
-			break;
 		case ELF_K_ELF:
 			/*
 			 * Reclaim all section descriptors.
@@ -88,8 +89,12 @@ elf_end(Elf *e)
 		}
 
 		sv = e;
-		if ((e = e->e_parent) != NULL)
-			e->e_u.e_ar.e_nchildren--;
+		if ((e = e->e_parent) != NULL) {
+			LIBELF_LOCK(e);
+			reclaim = --e->e_u.e_ar.e_nchildren == 0 &&
+			    e->e_activations == 0;
+			LIBELF_UNLOCK(e);
+		}
 		sv = _libelf_release_elf(sv);
 	}
 
@@ -37,7 +37,7 @@ elf_errno(void)
 {
 	int old;
 
-	old = LIBELF_PRIVATE(error);
-	LIBELF_PRIVATE(error) = 0;
+	old = LIBELF_THREAD_PRIVATE(error);
+	LIBELF_THREAD_PRIVATE(error) = 0;
 	return (old & LIBELF_ELF_ERROR_MASK);
 }
@@ -26,7 +26,10 @@
 
 #include <sys/cdefs.h>
 
+#include <errno.h>
 #include <libelf.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "_libelf.h"
 
@@ -57,6 +60,7 @@ elf_flagarhdr(Elf_Arhdr *a, Elf_Cmd c, unsigned int flags)
 unsigned int
 elf_flagdata(Elf_Data *d, Elf_Cmd c, unsigned int flags)
 {
+	void *buf;
 	unsigned int r;
 	struct _Libelf_Data *ld;
 
@@ -71,6 +75,23 @@ elf_flagdata(Elf_Data *d, Elf_Cmd c, unsigned int flags)
 
 	ld = (struct _Libelf_Data *) d;
 
+	/*
+	 * Data descriptors that share their buffer with the
+	 * underlying file image need a private copy before the
+	 * application can modify their contents.
+	 */
+	if (c == ELF_C_SET && (flags & ELF_F_DIRTY) &&
+	    (ld->d_flags & LIBELF_F_DATA_SHARED)) {
+		if ((buf = malloc(d->d_size)) == NULL) {
+			LIBELF_SET_ERROR(RESOURCE, errno);
+			return (0);
+		}
+		(void) memcpy(buf, d->d_buf, d->d_size);
+		d->d_buf = buf;
+		ld->d_flags &= ~LIBELF_F_DATA_SHARED;
+		ld->d_flags |= LIBELF_F_DATA_MALLOCED;
+	}
+
 	if (c == ELF_C_SET)
 		r = ld->d_flags |= flags;
 	else
@@ -119,7 +140,7 @@ elf_flagelf(Elf *e, Elf_Cmd c, unsigned int flags)
 	if ((c != ELF_C_SET && c != ELF_C_CLR) ||
 	    (e->e_kind != ELF_K_ELF) ||
 	    (flags & ~(ELF_F_ARCHIVE | ELF_F_ARCHIVE_SYSV |
-	    ELF_F_DIRTY | ELF_F_LAYOUT)) != 0) {
+	    ELF_F_DIRTY | ELF_F_LAYOUT | ELF_F_NOCOPY)) != 0) {
 		LIBELF_SET_ERROR(ARGUMENT, 0);
 		return (0);
 	}
@@ -35,13 +35,19 @@ ELFTC_VCSID("$Id$");
 Elf_Arhdr *
 elf_getarhdr(Elf *e)
 {
+	Elf_Arhdr *arh;
+
 	if (e == NULL) {
 		LIBELF_SET_ERROR(ARGUMENT, 0);
 		return (NULL);
 	}
 
+	LIBELF_LOCK(e);
 	if (e->e_flags & LIBELF_F_AR_HEADER)
-		return (e->e_hdr.e_arhdr);
+		arh = e->e_hdr.e_arhdr;
+	else
+		arh = _libelf_ar_gethdr(e);
+	LIBELF_UNLOCK(e);
 
-	return (_libelf_ar_gethdr(e));
+	return (arh);
 }
@@ -41,9 +41,13 @@ elf_getarsym(Elf *ar, size_t *ptr)
 	n = 0;
 	symtab = NULL;
 
-	if (ar == NULL || ar->e_kind != ELF_K_AR)
+	if (ar == NULL || ar->e_kind != ELF_K_AR) {
 		LIBELF_SET_ERROR(ARGUMENT, 0);
-	else if ((symtab = ar->e_u.e_ar.e_symtab) != NULL)
+		goto done;
+	}
+
+	LIBELF_LOCK(ar);
+	if ((symtab = ar->e_u.e_ar.e_symtab) != NULL)
 		n = ar->e_u.e_ar.e_symtabsz;
 	else if (ar->e_u.e_ar.e_rawsymtab)
 		symtab = (ar->e_flags & LIBELF_F_AR_VARIANT_SVR4) ?
@@ -51,6 +55,9 @@ elf_getarsym(Elf *ar, size_t *ptr)
 		    _libelf_ar_process_bsd_symtab(ar, &n);
 	else
 		LIBELF_SET_ERROR(ARCHIVE, 0);
+	LIBELF_UNLOCK(ar);
+
+done:
 
 	if (ptr)
 		*ptr = n;
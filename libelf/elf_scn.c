@@ -39,27 +39,20 @@
 ELFTC_VCSID("$Id$");
 
 /*
- * Load an ELF section table and create a list of Elf_Scn structures.
+ * Check that the section header table of an ELF object lies within
+ * the file, and return its offset.
  */
-int
-_libelf_load_section_headers(Elf *e, void *ehdr)
+static int
+_libelf_check_section_headers(Elf *e, void *ehdr, uint64_t *shoff)
 {
-	int ec, swapbytes;
-	size_t fsz, i, shnum;
-	uint64_t shoff;
-	char *src;
+	int ec;
+	size_t fsz, shnum;
 	Elf32_Ehdr *eh32;
 	Elf64_Ehdr *eh64;
-	Elf_Scn *scn;
-	int (*xlator)(char *_d, size_t _dsz, char *_s, size_t _c, int _swap);
-
-	assert(e != NULL);
-	assert(ehdr != NULL);
-	assert((e->e_flags & LIBELF_F_SHDRS_LOADED) == 0);
 
 #define	CHECK_EHDR(E,EH)	do {				\
 		if (fsz != (EH)->e_shentsize ||			\
-		    shoff + fsz * shnum > e->e_rawsize) {	\
+		    *shoff + fsz * shnum > e->e_rawsize) {	\
 			LIBELF_SET_ERROR(HEADER, 0);		\
 			return (0);				\
 		}						\
@@ -73,63 +66,105 @@ _libelf_load_section_headers(Elf *e, void *ehdr)
 
 	if (ec == ELFCLASS32) {
 		eh32 = (Elf32_Ehdr *) ehdr;
-		shoff = (uint64_t) eh32->e_shoff;
+		*shoff = (uint64_t) eh32->e_shoff;
 		CHECK_EHDR(e, eh32);
 	} else {
 		eh64 = (Elf64_Ehdr *) ehdr;
-		shoff = eh64->e_shoff;
+		*shoff = eh64->e_shoff;
 		CHECK_EHDR(e, eh64);
 	}
 
-	xlator = _libelf_get_translator(ELF_T_SHDR, ELF_TOMEMORY, ec);
+	return (1);
+}
+
+/*
+ * Create the descriptor for section `ndx' from its entry in the
+ * section header table at offset `shoff' in the raw file.
+ */
+static Elf_Scn *
+_libelf_load_section_header(Elf *e, uint64_t shoff, size_t ndx)
+{
+	int ec;
+	size_t fsz;
+	Elf_Scn *scn;
+	int (*xlator)(char *_d, size_t _dsz, char *_s, size_t _c, int _swap);
 
-	swapbytes = e->e_byteorder != LIBELF_PRIVATE(byteorder);
-	src = e->e_rawfile + shoff;
+	ec = e->e_class;
+	fsz = _libelf_fsize(ELF_T_SHDR, ec, e->e_version, (size_t) 1);
 
-	/*
-	 * If the file is using extended numbering then section #0
-	 * would have already been read in.
-	 */
+	if ((scn = _libelf_allocate_scn(e, ndx)) == NULL)
+		return (NULL);
 
-	i = 0;
-	if (!STAILQ_EMPTY(&e->e_u.e_elf.e_scn)) {
-		assert(STAILQ_FIRST(&e->e_u.e_elf.e_scn) ==
-		    STAILQ_LAST(&e->e_u.e_elf.e_scn, _Elf_Scn, s_next));
+	xlator = _libelf_get_translator(ELF_T_SHDR, ELF_TOMEMORY, ec);
+	(*xlator)((char *) &scn->s_shdr, sizeof(scn->s_shdr),
+	    e->e_rawfile + shoff + ndx * fsz, (size_t) 1,
+	    e->e_byteorder != LIBELF_PRIVATE(byteorder));
 
-		i = 1;
-		src += fsz;
+	if (ec == ELFCLASS32) {
+		scn->s_offset = scn->s_rawoff =
+		    scn->s_shdr.s_shdr32.sh_offset;
+		scn->s_size = scn->s_shdr.s_shdr32.sh_size;
+	} else {
+		scn->s_offset = scn->s_rawoff =
+		    scn->s_shdr.s_shdr64.sh_offset;
+		scn->s_size = scn->s_shdr.s_shdr64.sh_size;
 	}
 
-	for (; i < shnum; i++, src += fsz) {
-		if ((scn = _libelf_allocate_scn(e, i)) == NULL)
+	return (scn);
+}
+
+/*
+ * Load an ELF section table and create a list of Elf_Scn structures.
+ *
+ * Descriptors for individual sections may already have been created
+ * by elf_getscn(), or, if the file is using extended numbering, when
+ * the ELF header was read in; these are retained.
+ */
+int
+_libelf_load_section_headers(Elf *e, void *ehdr)
+{
+	size_t i, shnum;
+	uint64_t shoff;
+
+	assert(e != NULL);
+	assert(ehdr != NULL);
+	assert((e->e_flags & LIBELF_F_SHDRS_LOADED) == 0);
+
+	if (!_libelf_check_section_headers(e, ehdr, &shoff))
+		return (0);
+
+	shnum = e->e_u.e_elf.e_nscn;
+
+	if (!_libelf_grow_scn_index(e, shnum))
+		return (0);
+
+	for (i = 0; i < shnum; i++)
+		if (e->e_u.e_elf.e_scnndx[i] == NULL &&
+		    _libelf_load_section_header(e, shoff, i) == NULL)
 			return (0);
 
-		(*xlator)((char *) &scn->s_shdr, sizeof(scn->s_shdr), src,
-		    (size_t) 1, swapbytes);
-
-		if (ec == ELFCLASS32) {
-			scn->s_offset = scn->s_rawoff =
-			    scn->s_shdr.s_shdr32.sh_offset;
-			scn->s_size = scn->s_shdr.s_shdr32.sh_size;
-		} else {
-			scn->s_offset = scn->s_rawoff =
-			    scn->s_shdr.s_shdr64.sh_offset;
-			scn->s_size = scn->s_shdr.s_shdr64.sh_size;
-		}
-	}
+	/*
+	 * Descriptors created by earlier calls to elf_getscn() were
+	 * appended in the order they were asked for.  Relink the list
+	 * in index order for elf_nextscn() and elf_update().
+	 */
+	STAILQ_INIT(&e->e_u.e_elf.e_scn);
+	for (i = 0; i < shnum; i++)
+		STAILQ_INSERT_TAIL(&e->e_u.e_elf.e_scn,
+		    e->e_u.e_elf.e_scnndx[i], s_next);
 
 	e->e_flags |= LIBELF_F_SHDRS_LOADED;
 
 	return (1);
 }
 
-
 Elf_Scn *
 elf_getscn(Elf *e, size_t index)
 {
 	int ec;
 	void *ehdr;
 	Elf_Scn *s;
+	uint64_t shoff;
 
 	if (e == NULL || e->e_kind != ELF_K_ELF ||
 	    ((ec = e->e_class) != ELFCLASS32 && ec != ELFCLASS64)) {
@@ -140,17 +175,35 @@ elf_getscn(Elf *e, size_t index)
 	if ((ehdr = _libelf_ehdr(e, ec, 0)) == NULL)
 		return (NULL);
 
+	s = NULL;
+
+	LIBELF_LOCK(e);
+
+	/*
+	 * Until the full section list is needed, only create the
+	 * descriptor for the section being asked for.
+	 */
 	if (e->e_cmd != ELF_C_WRITE &&
 	    (e->e_flags & LIBELF_F_SHDRS_LOADED) == 0 &&
-	    _libelf_load_section_headers(e, ehdr) == 0)
-		return (NULL);
+	    index < e->e_u.e_elf.e_nscn &&
+	    (index >= e->e_u.e_elf.e_scnndxsz ||
+	    e->e_u.e_elf.e_scnndx[index] == NULL) &&
+	    (!_libelf_check_section_headers(e, ehdr, &shoff) ||
+	    _libelf_load_section_header(e, shoff, index) == NULL))
+		goto done;
+
+	if (index >= e->e_u.e_elf.e_scnndxsz ||
+	    (s = e->e_u.e_elf.e_scnndx[index]) == NULL) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		goto done;
+	}
 
-	STAILQ_FOREACH(s, &e->e_u.e_elf.e_scn, s_next)
-		if (s->s_ndx == index)
-			return (s);
+	assert(s->s_ndx == index);
 
-	LIBELF_SET_ERROR(ARGUMENT, 0);
-	return (NULL);
+done:
+	LIBELF_UNLOCK(e);
+
+	return (s);
 }
 
 size_t
@@ -221,12 +274,31 @@ elf_newscn(Elf *e)
 Elf_Scn *
 elf_nextscn(Elf *e, Elf_Scn *s)
 {
+	int ec, error;
+	void *ehdr;
+
 	if (e == NULL || (e->e_kind != ELF_K_ELF) ||
-	    (s && s->s_elf != e)) {
+	    (s && s->s_elf != e) ||
+	    ((ec = e->e_class) != ELFCLASS32 && ec != ELFCLASS64)) {
 		LIBELF_SET_ERROR(ARGUMENT, 0);
 		return (NULL);
 	}
 
+	if ((ehdr = _libelf_ehdr(e, ec, 0)) == NULL)
+		return (NULL);
+
+	/* Iteration needs descriptors for all sections. */
+	error = 0;
+	LIBELF_LOCK(e);
+	if (e->e_cmd != ELF_C_WRITE &&
+	    (e->e_flags & LIBELF_F_SHDRS_LOADED) == 0 &&
+	    _libelf_load_section_headers(e, ehdr) == 0)
+		error = 1;
+	LIBELF_UNLOCK(e);
+
+	if (error)
+		return (NULL);
+
 	return (s == NULL ? elf_getscn(e, (size_t) 1) :
 	    STAILQ_NEXT(s, s_next));
 }
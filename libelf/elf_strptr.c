@@ -33,6 +33,60 @@
 
 ELFTC_VCSID("$Id$");
 
+/*
+ * The contents of a string table section that is held in a single
+ * data descriptor are remembered in its section descriptor, so that
+ * subsequent lookups need not revalidate the section.  The cached
+ * values are ignored once the section or its data is marked dirty.
+ */
+#define	LIBELF_STRTAB_CACHED(S)	((S)->s_strdata != NULL &&		\
+	(((S)->s_flags | (S)->s_strdata->d_flags) & ELF_F_DIRTY) == 0)
+
+static char *
+_libelf_strptr_cached(Elf *e, size_t scndx, size_t offset)
+{
+	char *p;
+	Elf_Scn *s;
+	Elf_Data *d;
+
+	p = NULL;
+
+	LIBELF_LOCK(e);
+
+	if (scndx < e->e_u.e_elf.e_scnndxsz &&
+	    (s = e->e_u.e_elf.e_scnndx[scndx]) != NULL &&
+	    LIBELF_STRTAB_CACHED(s)) {
+		d = &s->s_strdata->d_data;
+		if (offset < s->s_strsize && offset < d->d_size)
+			p = (char *) d->d_buf + offset;
+	}
+
+	LIBELF_UNLOCK(e);
+
+	return (p);
+}
+
+static void
+_libelf_strptr_cache(Elf_Scn *s, GElf_Shdr *shdr)
+{
+	struct _Libelf_Data *ld;
+
+	LIBELF_LOCK(s->s_elf);
+
+	if ((s->s_flags & ELF_F_DIRTY) == 0 &&
+	    (ld = STAILQ_FIRST(&s->s_data)) != NULL &&
+	    STAILQ_NEXT(ld, d_next) == NULL &&
+	    (ld->d_flags & ELF_F_DIRTY) == 0 &&
+	    ld->d_data.d_type == ELF_T_BYTE &&
+	    ld->d_data.d_buf != NULL &&
+	    ld->d_data.d_off == 0) {
+		s->s_strdata = ld;
+		s->s_strsize = shdr->sh_size;
+	}
+
+	LIBELF_UNLOCK(s->s_elf);
+}
+
 /*
  * Convert an ELF section#,offset pair to a string pointer.
  */
@@ -40,6 +94,7 @@ ELFTC_VCSID("$Id$");
 char *
 elf_strptr(Elf *e, size_t scndx, size_t offset)
 {
+	char *p;
 	Elf_Scn *s;
 	Elf_Data *d;
 	size_t alignment, count;
@@ -50,6 +105,9 @@ elf_strptr(Elf *e, size_t scndx, size_t offset)
 		return (NULL);
 	}
 
+	if ((p = _libelf_strptr_cached(e, scndx, offset)) != NULL)
+		return (p);
+
 	if ((s = elf_getscn(e, scndx)) == NULL ||
 	    gelf_getshdr(s, &shdr) == NULL)
 		return (NULL);
@@ -60,6 +118,10 @@ elf_strptr(Elf *e, size_t scndx, size_t offset)
 		return (NULL);
 	}
 
+	/* Remember the section's contents for later lookups. */
+	if (elf_getdata(s, NULL) != NULL)
+		_libelf_strptr_cache(s, &shdr);
+
 	d = NULL;
 	if (e->e_flags & ELF_F_LAYOUT) {
 
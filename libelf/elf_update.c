@@ -31,6 +31,7 @@
 #include <errno.h>
 #include <gelf.h>
 #include <libelf.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -41,6 +42,10 @@
 #include <sys/mman.h>
 #endif
 
+#if	ELFTC_HAVE_POSIX_FALLOCATE
+#include <fcntl.h>
+#endif
+
 ELFTC_VCSID("$Id$");
 
 /*
@@ -696,26 +701,236 @@ _libelf_resync_elf(Elf *e, struct _Elf_Extent_List *extents)
 	return (rc);
 }
 
+/*
+ * The destination for the contents of an ELF object being written
+ * out.  File content is either assembled in an in-memory image
+ * of the new file, or is written to the underlying file descriptor
+ * one extent at a time.
+ */
+struct _Elf_Output {
+	char		*o_image;  /* In-memory image, if any. */
+	int		o_fd;	   /* Descriptor written to otherwise. */
+	int		o_sparse;  /* Whether zero gaps may be left as holes. */
+	uint64_t	o_offset;  /* Current offset in the output. */
+};
+
+/*
+ * Write out a buffer to the output file descriptor.
+ */
+
+static int
+_libelf_output_write(struct _Elf_Output *o, const char *buf, size_t sz)
+{
+	ssize_t n;
+
+	assert(o->o_image == NULL);
+
+	while (sz > 0) {
+		if ((n = write(o->o_fd, buf, sz)) <= 0) {
+			if (n < 0 && errno == EINTR)
+				continue;
+			LIBELF_SET_ERROR(IO, errno);
+			return (0);
+		}
+		buf += n;
+		sz -= (size_t) n;
+		o->o_offset += (uint64_t) n;
+	}
+
+	return (1);
+}
+
+/*
+ * Move the output to offset `off' without writing anything, leaving
+ * the existing file content (or a hole) in place.
+ */
+
+static int
+_libelf_output_skip(struct _Elf_Output *o, uint64_t off)
+{
+	assert(o->o_image == NULL);
+	assert(off >= o->o_offset);
+
+	if (off == o->o_offset)
+		return (1);
+
+	if (lseek(o->o_fd, (off_t) off, SEEK_SET) < 0) {
+		LIBELF_SET_ERROR(IO, errno);
+		return (0);
+	}
+
+	o->o_offset = off;
+
+	return (1);
+}
+
+/*
+ * Advance the output to offset `off', filling the gap with the fill
+ * character set by elf_fill(3).
+ */
+
+static int
+_libelf_output_fill(struct _Elf_Output *o, uint64_t off)
+{
+	size_t sz;
+	char fill[BUFSIZ];
+
+	assert(off >= o->o_offset);
+
+	if (o->o_image) {
+		if (!o->o_sparse || LIBELF_PRIVATE(fillchar) != 0)
+			(void) memset(o->o_image + o->o_offset,
+			    LIBELF_PRIVATE(fillchar), off - o->o_offset);
+		o->o_offset = off;
+		return (1);
+	}
+
+	if (o->o_sparse && LIBELF_PRIVATE(fillchar) == 0)
+		return (_libelf_output_skip(o, off));
+
+	sz = off - o->o_offset;
+	(void) memset(fill, LIBELF_PRIVATE(fillchar),
+	    sz < sizeof(fill) ? sz : sizeof(fill));
+
+	while (o->o_offset < off) {
+		sz = off - o->o_offset;
+		if (sz > sizeof(fill))
+			sz = sizeof(fill);
+		if (!_libelf_output_write(o, fill, sz))
+			return (0);
+	}
+
+	return (1);
+}
+
+/*
+ * Copy `sz' bytes from `buf' to offset `off' of the output.
+ */
+
+static int
+_libelf_output_copy(struct _Elf_Output *o, uint64_t off, const char *buf,
+    size_t sz)
+{
+	if (!_libelf_output_fill(o, off))
+		return (0);
+
+	if (o->o_image == NULL)
+		return (_libelf_output_write(o, buf, sz));
+
+	(void) memcpy(o->o_image + off, buf, sz);
+	o->o_offset += sz;
+
+	return (1);
+}
+
+/*
+ * Write out the file representation of the contents of data
+ * descriptor `d' at offset `off' of the output.
+ *
+ * When writing to a file descriptor, data that does not need
+ * translation is written out directly from the descriptor's buffer.
+ * Other data is translated a chunk at a time where the data type
+ * permits it.
+ */
+
+static int
+_libelf_output_data(Elf *e, struct _Elf_Output *o, uint64_t off,
+    Elf_Data *d)
+{
+	int ec;
+	char *buf;
+	Elf_Data dst, src;
+	size_t chunk, fsz, msz, n, nobjects;
+
+	ec = e->e_class;
+
+	msz = _libelf_msize(d->d_type, ec, e->e_version);
+	fsz = _libelf_fsize(d->d_type, ec, e->e_version, (size_t) 1);
+
+	assert(d->d_size % msz == 0);
+
+	nobjects = d->d_size / msz;
+
+	if (!_libelf_output_fill(o, off))
+		return (0);
+
+	dst.d_version = e->e_version;
+
+	if (o->o_image) {
+		dst.d_buf  = o->o_image + off;
+		dst.d_size = nobjects * fsz;
+
+		if (_libelf_xlate(&dst, d, e->e_byteorder, ec, ELF_TOFILE) ==
+		    NULL)
+			return (0);
+
+		o->o_offset += dst.d_size;
+		return (1);
+	}
+
+	if (d->d_type == ELF_T_BYTE || (msz == fsz &&
+	    e->e_byteorder == LIBELF_PRIVATE(byteorder)))
+		return (_libelf_output_write(o, d->d_buf, nobjects * fsz));
+
+	/*
+	 * Types without a fixed size memory representation need to be
+	 * translated in one go.
+	 */
+	if (msz == 1)
+		chunk = nobjects;
+	else if ((chunk = LIBELF_OUTPUT_CHUNK / fsz) == 0)
+		chunk = 1;
+	if (chunk > nobjects)
+		chunk = nobjects;
+
+	if ((buf = malloc(chunk * fsz)) == NULL) {
+		LIBELF_SET_ERROR(RESOURCE, errno);
+		return (0);
+	}
+
+	src = *d;
+
+	for (; nobjects > 0; nobjects -= n) {
+		n = nobjects < chunk ? nobjects : chunk;
+
+		src.d_size = n * msz;
+
+		dst.d_buf  = buf;
+		dst.d_size = n * fsz;
+
+		if (_libelf_xlate(&dst, &src, e->e_byteorder, ec,
+		    ELF_TOFILE) == NULL ||
+		    !_libelf_output_write(o, buf, dst.d_size)) {
+			free(buf);
+			return (0);
+		}
+
+		src.d_buf = (char *) src.d_buf + src.d_size;
+	}
+
+	free(buf);
+
+	return (1);
+}
+
 /*
  * Write out the contents of an ELF section.
  */
 
-static size_t
-_libelf_write_scn(Elf *e, char *nf, struct _Elf_Extent *ex)
+static off_t
+_libelf_write_scn(Elf *e, struct _Elf_Output *o, struct _Elf_Extent *ex)
 {
 	int ec;
 	Elf_Scn *s;
 	int elftype;
-	Elf_Data *d, dst;
+	Elf_Data *d;
 	uint32_t sh_type;
 	struct _Libelf_Data *ld;
 	uint64_t sh_off, sh_size;
-	size_t fsz, msz, nobjects, rc;
 
 	assert(ex->ex_type == ELF_EXTENT_SECTION);
 
 	s = ex->ex_desc;
-	rc = ex->ex_start;
 
 	if ((ec = e->e_class) == ELFCLASS32) {
 		sh_type = s->s_shdr.s_shdr32.sh_type;
@@ -729,7 +944,7 @@ _libelf_write_scn(Elf *e, char *nf, struct _Elf_Extent *ex)
 	 * Ignore sections that do not allocate space in the file.
 	 */
 	if (sh_type == SHT_NOBITS || sh_type == SHT_NULL || sh_size == 0)
-		return (rc);
+		return (ex->ex_start);
 
 	elftype = _libelf_xlate_shtype(sh_type);
 	assert(elftype >= ELF_T_FIRST && elftype <= ELF_T_LAST);
@@ -754,23 +969,16 @@ _libelf_write_scn(Elf *e, char *nf, struct _Elf_Extent *ex)
 
 			d = &ld->d_data;
 
-			if ((uint64_t) rc < sh_off + d->d_off)
-				(void) memset(nf + rc,
-				    LIBELF_PRIVATE(fillchar), sh_off +
-				    d->d_off - rc);
-			rc = sh_off + d->d_off;
-
 			assert(d->d_buf != NULL);
 			assert(d->d_type == ELF_T_BYTE);
 			assert(d->d_version == e->e_version);
 
-			(void) memcpy(nf + rc,
-			    e->e_rawfile + s->s_rawoff + d->d_off, d->d_size);
-
-			rc += d->d_size;
+			if (!_libelf_output_copy(o, sh_off + d->d_off,
+			    e->e_rawfile + s->s_rawoff + d->d_off, d->d_size))
+				return ((off_t) -1);
 		}
 
-		return (rc);
+		return ((off_t) o->o_offset);
 	}
 
 	/*
@@ -779,39 +987,18 @@ _libelf_write_scn(Elf *e, char *nf, struct _Elf_Extent *ex)
 	 * descriptors for this step.
 	 */
 
-	dst.d_version = e->e_version;
-
 	STAILQ_FOREACH(ld, &s->s_data, d_next) {
 
 		d = &ld->d_data;
 
-		msz = _libelf_msize(d->d_type, ec, e->e_version);
-
-		if ((uint64_t) rc < sh_off + d->d_off)
-			(void) memset(nf + rc,
-			    LIBELF_PRIVATE(fillchar), sh_off + d->d_off - rc);
-
-		rc = sh_off + d->d_off;
-
 		assert(d->d_buf != NULL);
 		assert(d->d_version == e->e_version);
-		assert(d->d_size % msz == 0);
-
-		nobjects = d->d_size / msz;
-
-		fsz = _libelf_fsize(d->d_type, ec, e->e_version, nobjects);
 
-		dst.d_buf    = nf + rc;
-		dst.d_size   = fsz;
-
-		if (_libelf_xlate(&dst, d, e->e_byteorder, ec, ELF_TOFILE) ==
-		    NULL)
+		if (!_libelf_output_data(e, o, sh_off + d->d_off, d))
 			return ((off_t) -1);
-
-		rc += fsz;
 	}
 
-	return ((off_t) rc);
+	return ((off_t) o->o_offset);
 }
 
 /*
@@ -819,12 +1006,11 @@ _libelf_write_scn(Elf *e, char *nf, struct _Elf_Extent *ex)
  */
 
 static off_t
-_libelf_write_ehdr(Elf *e, char *nf, struct _Elf_Extent *ex)
+_libelf_write_ehdr(Elf *e, struct _Elf_Output *o, struct _Elf_Extent *ex)
 {
 	int ec;
 	void *ehdr;
-	size_t fsz, msz;
-	Elf_Data dst, src;
+	Elf_Data src;
 
 	assert(ex->ex_type == ELF_EXTENT_EHDR);
 	assert(ex->ex_start == 0); /* Ehdr always comes first. */
@@ -834,25 +1020,17 @@ _libelf_write_ehdr(Elf *e, char *nf, struct _Elf_Extent *ex)
 	ehdr = _libelf_ehdr(e, ec, 0);
 	assert(ehdr != NULL);
 
-	fsz = _libelf_fsize(ELF_T_EHDR, ec, e->e_version, (size_t) 1);
-	msz = _libelf_msize(ELF_T_EHDR, ec, e->e_version);
-
-	(void) memset(&dst, 0, sizeof(dst));
 	(void) memset(&src, 0, sizeof(src));
 
 	src.d_buf     = ehdr;
-	src.d_size    = msz;
+	src.d_size    = _libelf_msize(ELF_T_EHDR, ec, e->e_version);
 	src.d_type    = ELF_T_EHDR;
-	src.d_version = dst.d_version = e->e_version;
+	src.d_version = e->e_version;
 
-	dst.d_buf     = nf;
-	dst.d_size    = fsz;
-
-	if (_libelf_xlate(&dst, &src, e->e_byteorder, ec, ELF_TOFILE) ==
-	    NULL)
+	if (!_libelf_output_data(e, o, ex->ex_start, &src))
 		return ((off_t) -1);
 
-	return ((off_t) fsz);
+	return ((off_t) o->o_offset);
 }
 
 /*
@@ -860,14 +1038,14 @@ _libelf_write_ehdr(Elf *e, char *nf, struct _Elf_Extent *ex)
  */
 
 static off_t
-_libelf_write_phdr(Elf *e, char *nf, struct _Elf_Extent *ex)
+_libelf_write_phdr(Elf *e, struct _Elf_Output *o, struct _Elf_Extent *ex)
 {
 	int ec;
 	void *ehdr;
 	Elf32_Ehdr *eh32;
 	Elf64_Ehdr *eh64;
-	Elf_Data dst, src;
-	size_t fsz, phnum;
+	Elf_Data src;
+	size_t phnum;
 	uint64_t phoff;
 
 	assert(ex->ex_type == ELF_EXTENT_PHDR);
@@ -890,36 +1068,33 @@ _libelf_write_phdr(Elf *e, char *nf, struct _Elf_Extent *ex)
 	assert(ex->ex_start == phoff);
 	assert(phoff % _libelf_falign(ELF_T_PHDR, ec) == 0);
 
-	(void) memset(&dst, 0, sizeof(dst));
 	(void) memset(&src, 0, sizeof(src));
 
-	fsz = _libelf_fsize(ELF_T_PHDR, ec, e->e_version, phnum);
-	assert(fsz > 0);
-
 	src.d_buf = _libelf_getphdr(e, ec);
-	src.d_version = dst.d_version = e->e_version;
+	src.d_version = e->e_version;
 	src.d_type = ELF_T_PHDR;
 	src.d_size = phnum * _libelf_msize(ELF_T_PHDR, ec,
 	    e->e_version);
 
-	dst.d_size = fsz;
-	dst.d_buf = nf + ex->ex_start;
-
-	if (_libelf_xlate(&dst, &src, e->e_byteorder, ec, ELF_TOFILE) ==
-	    NULL)
+	if (!_libelf_output_data(e, o, phoff, &src))
 		return ((off_t) -1);
 
-	return (phoff + fsz);
+	return ((off_t) o->o_offset);
 }
 
 /*
  * Write out an ELF section header table.
+ *
+ * When writing to a file descriptor, the table is assembled in a
+ * temporary buffer first, so that it can be written out in one
+ * operation.
  */
 
 static off_t
-_libelf_write_shdr(Elf *e, char *nf, struct _Elf_Extent *ex)
+_libelf_write_shdr(Elf *e, struct _Elf_Output *o, struct _Elf_Extent *ex)
 {
 	int ec;
+	char *nf;
 	void *ehdr;
 	Elf_Scn *scn;
 	uint64_t shoff;
@@ -946,6 +1121,20 @@ _libelf_write_shdr(Elf *e, char *nf, struct _Elf_Extent *ex)
 	assert(shoff % _libelf_falign(ELF_T_SHDR, ec) == 0);
 	assert(ex->ex_start == shoff);
 
+	fsz = _libelf_fsize(ELF_T_SHDR, ec, e->e_version, (size_t) 1);
+
+	assert(ex->ex_size == nscn * fsz);
+
+	if (!_libelf_output_fill(o, shoff))
+		return ((off_t) -1);
+
+	if (o->o_image)
+		nf = o->o_image + shoff;
+	else if ((nf = malloc(nscn * fsz)) == NULL) {
+		LIBELF_SET_ERROR(RESOURCE, errno);
+		return ((off_t) -1);
+	}
+
 	(void) memset(&dst, 0, sizeof(dst));
 	(void) memset(&src, 0, sizeof(src));
 
@@ -953,8 +1142,6 @@ _libelf_write_shdr(Elf *e, char *nf, struct _Elf_Extent *ex)
 	src.d_size = _libelf_msize(ELF_T_SHDR, ec, e->e_version);
 	src.d_version = dst.d_version = e->e_version;
 
-	fsz = _libelf_fsize(ELF_T_SHDR, ec, e->e_version, (size_t) 1);
-
 	STAILQ_FOREACH(scn, &e->e_u.e_elf.e_scn, s_next) {
 		if (ec == ELFCLASS32)
 			src.d_buf = &scn->s_shdr.s_shdr32;
@@ -962,27 +1149,130 @@ _libelf_write_shdr(Elf *e, char *nf, struct _Elf_Extent *ex)
 			src.d_buf = &scn->s_shdr.s_shdr64;
 
 		dst.d_size = fsz;
-		dst.d_buf = nf + ex->ex_start + scn->s_ndx * fsz;
+		dst.d_buf = nf + scn->s_ndx * fsz;
 
 		if (_libelf_xlate(&dst, &src, e->e_byteorder, ec,
 		    ELF_TOFILE) == NULL)
-			return ((off_t) -1);
+			goto error;
+	}
+
+	if (o->o_image)
+		o->o_offset += nscn * fsz;
+	else {
+		if (!_libelf_output_write(o, nf, nscn * fsz))
+			goto error;
+		free(nf);
+	}
+
+	return ((off_t) o->o_offset);
+
+ error:
+	if (o->o_image == NULL)
+		free(nf);
+	return ((off_t) -1);
+}
+
+/*
+ * Check whether an object opened in ELF_C_RDWR mode can be updated
+ * in place.
+ *
+ * The file is overwritten while its original contents are still
+ * mapped in, so this is only possible if no section needs to be
+ * copied from the original file to a different location in the new
+ * one.  Sections that have neither moved nor been brought into
+ * memory may then be left untouched in the file.
+ */
+
+static int
+_libelf_can_update_in_place(Elf *e, struct _Elf_Extent_List *extents)
+{
+	Elf_Scn *s;
+	struct _Elf_Extent *ex;
+	struct _Libelf_Data *ld;
+
+	assert(e->e_cmd == ELF_C_RDWR);
+
+	if (e->e_flags & (LIBELF_F_SPECIAL_FILE | LIBELF_F_RAWFILE_MALLOC))
+		return (0);
+
+	SLIST_FOREACH(ex, extents, ex_next) {
+		if (ex->ex_type != ELF_EXTENT_SECTION)
+			continue;
+
+		s = ex->ex_desc;
+
+		if (STAILQ_EMPTY(&s->s_data)) {
+			if (s->s_offset != s->s_rawoff)
+				return (0);
+			continue;
+		}
+
+		STAILQ_FOREACH(ld, &s->s_data, d_next)
+			if (ld->d_flags & LIBELF_F_DATA_SHARED)
+				return (0);
+	}
+
+	return (1);
+}
+
+#if	ELFTC_HAVE_MMAP
+/*
+ * Extend the (empty) regular file `fd' to `newsize' bytes and map it
+ * in for writing.  NULL is returned if the file cannot be mapped, for
+ * example because it was not opened for reading, in which case it is
+ * left empty and the caller falls back to write(2).
+ *
+ * The blocks of the file are allocated up front where possible, since
+ * running out of space while storing to a sparse mapping would raise
+ * SIGBUS instead of failing a write(2).
+ */
+
+static char *
+_libelf_map_output(int fd, off_t newsize)
+{
+	void *m;
+
+	if (newsize <= 0 || ftruncate(fd, newsize) < 0)
+		return (NULL);
+
+#if	ELFTC_HAVE_POSIX_FALLOCATE
+	if (posix_fallocate(fd, (off_t) 0, newsize) != 0) {
+		(void) ftruncate(fd, (off_t) 0);
+		return (NULL);
 	}
+#endif
 
-	return (ex->ex_start + nscn * fsz);
+	if ((m = mmap(NULL, (size_t) newsize, PROT_READ | PROT_WRITE,
+	    MAP_SHARED, fd, (off_t) 0)) == MAP_FAILED) {
+		(void) ftruncate(fd, (off_t) 0);
+		return (NULL);
+	}
+
+	return (m);
 }
+#endif	/* ELFTC_HAVE_MMAP */
 
 /*
  * Write out the file image.
  *
+ * Objects opened with ELF_C_WRITE are assembled directly in a shared
+ * mapping of the underlying file when it is a regular file that can
+ * be mapped, so that each byte is copied just once.  Otherwise they
+ * are written out to the file one extent at a time.  Gaps in the
+ * coverage of a regular file are left as holes when the fill
+ * character is zero.
+ *
  * The original file could have been mapped in with an ELF_C_RDWR
  * command and the application could have added new content or
- * re-arranged its sections before calling elf_update().  Consequently
- * its not safe to work `in place' on the original file.  So we
- * malloc() the required space for the updated ELF object and build
- * the object there and write it out to the underlying file at the
- * end.  Note that the application may have opened the underlying file
- * in ELF_C_RDWR and only retrieved/modified a few sections.  We take
+ * re-arranged its sections before calling elf_update().  If no
+ * section content needs to be copied to a new location in the file
+ * (see _libelf_can_update_in_place()), the file is updated in place
+ * and sections that are unchanged are not rewritten.  Otherwise it
+ * is not safe to work `in place' on the original file, so we
+ * malloc() the required space for the updated ELF object, build the
+ * object there and write it out to the underlying file at the end.
+ * Note that the application may have opened the underlying file in
+ * ELF_C_RDWR and only retrieved/modified a few sections.  We take
  * care to avoid translating file sections unnecessarily.
  *
  * Gaps in the coverage of the file by the file's sections will be
@@ -993,45 +1283,91 @@ static off_t
 _libelf_write_elf(Elf *e, off_t newsize, struct _Elf_Extent_List *extents)
 {
 	off_t nrc, rc;
+	int inplace, mapped;
 	char *newfile;
 	Elf_Scn *scn, *tscn;
 	struct _Elf_Extent *ex;
+	struct _Elf_Output o;
 
 	assert(e->e_kind == ELF_K_ELF);
 	assert(e->e_cmd == ELF_C_RDWR || e->e_cmd == ELF_C_WRITE);
 	assert(e->e_fd >= 0);
 
-	if ((newfile = malloc((size_t) newsize)) == NULL) {
-		LIBELF_SET_ERROR(RESOURCE, errno);
-		return ((off_t) -1);
+	newfile = NULL;
+	mapped = 0;
+	inplace = e->e_cmd == ELF_C_RDWR &&
+	    _libelf_can_update_in_place(e, extents);
+
+	o.o_fd = e->e_fd;
+	o.o_image = NULL;
+	o.o_offset = 0;
+	o.o_sparse = 0;
+
+	if (e->e_cmd == ELF_C_RDWR && !inplace) {
+		if ((newfile = malloc((size_t) newsize)) == NULL) {
+			LIBELF_SET_ERROR(RESOURCE, errno);
+			return ((off_t) -1);
+		}
+		o.o_image = newfile;
+	} else if ((e->e_flags & LIBELF_F_SPECIAL_FILE) == 0) {
+		/*
+		 * For regular files, throw away existing file content
+		 * unless the file is being updated in place.
+		 */
+		if (!inplace) {
+			if (ftruncate(e->e_fd, (off_t) 0) < 0) {
+				LIBELF_SET_ERROR(IO, errno);
+				return ((off_t) -1);
+			}
+			o.o_sparse = 1;
+		}
+#if	ELFTC_HAVE_MMAP
+		if (e->e_cmd == ELF_C_WRITE &&
+		    (o.o_image = _libelf_map_output(e->e_fd, newsize)) != NULL)
+			mapped = 1;
+#endif
+		if (!mapped && lseek(e->e_fd, (off_t) 0, SEEK_SET) < 0) {
+			LIBELF_SET_ERROR(IO, errno);
+			return ((off_t) -1);
+		}
 	}
 
 	nrc = rc = 0;
 	SLIST_FOREACH(ex, extents, ex_next) {
 
-		/* Fill inter-extent gaps. */
-		if (ex->ex_start > (size_t) rc)
-			(void) memset(newfile + rc, LIBELF_PRIVATE(fillchar),
-			    ex->ex_start - rc);
+		assert(o.o_offset == (uint64_t) rc);
+
+		/*
+		 * Leave sections that are unchanged in place.
+		 */
+		if (inplace && ex->ex_type == ELF_EXTENT_SECTION &&
+		    STAILQ_EMPTY(&((Elf_Scn *) ex->ex_desc)->s_data)) {
+			if (!_libelf_output_fill(&o, ex->ex_start) ||
+			    !_libelf_output_skip(&o, ex->ex_start +
+			    ex->ex_size))
+				goto error;
+			rc = (off_t) o.o_offset;
+			continue;
+		}
 
 		switch (ex->ex_type) {
 		case ELF_EXTENT_EHDR:
-			if ((nrc = _libelf_write_ehdr(e, newfile, ex)) < 0)
+			if ((nrc = _libelf_write_ehdr(e, &o, ex)) < 0)
 				goto error;
 			break;
 
 		case ELF_EXTENT_PHDR:
-			if ((nrc = _libelf_write_phdr(e, newfile, ex)) < 0)
+			if ((nrc = _libelf_write_phdr(e, &o, ex)) < 0)
 				goto error;
 			break;
 
 		case ELF_EXTENT_SECTION:
-			if ((nrc = _libelf_write_scn(e, newfile, ex)) < 0)
+			if ((nrc = _libelf_write_scn(e, &o, ex)) < 0)
 				goto error;
 			break;
 
 		case ELF_EXTENT_SHDR:
-			if ((nrc = _libelf_write_shdr(e, newfile, ex)) < 0)
+			if ((nrc = _libelf_write_shdr(e, &o, ex)) < 0)
 				goto error;
 			break;
 
@@ -1048,34 +1384,61 @@ _libelf_write_elf(Elf *e, off_t newsize, struct _Elf_Extent_List *extents)
 
 	assert(rc == newsize);
 
-	/*
-	 * For regular files, throw away existing file content and
-	 * unmap any existing mappings.
-	 */
-	if ((e->e_flags & LIBELF_F_SPECIAL_FILE) == 0) {
-		if (ftruncate(e->e_fd, (off_t) 0) < 0 ||
-		    lseek(e->e_fd, (off_t) 0, SEEK_SET)) {
+#if	ELFTC_HAVE_MMAP
+	if (mapped) {
+		mapped = 0;
+		if (munmap(o.o_image, (size_t) newsize) < 0) {
 			LIBELF_SET_ERROR(IO, errno);
 			goto error;
 		}
-#if	ELFTC_HAVE_MMAP
-		if (e->e_flags & LIBELF_F_RAWFILE_MMAP) {
-			assert(e->e_rawfile != NULL);
-			assert(e->e_cmd == ELF_C_RDWR);
-			if (munmap(e->e_rawfile, e->e_rawsize) < 0) {
+	}
+#endif
+
+	if (newfile) {
+		/*
+		 * For regular files, throw away existing file content
+		 * and unmap any existing mappings.
+		 */
+		if ((e->e_flags & LIBELF_F_SPECIAL_FILE) == 0) {
+			if (ftruncate(e->e_fd, (off_t) 0) < 0 ||
+			    lseek(e->e_fd, (off_t) 0, SEEK_SET)) {
 				LIBELF_SET_ERROR(IO, errno);
 				goto error;
 			}
-		}
+#if	ELFTC_HAVE_MMAP
+			if (e->e_flags & LIBELF_F_RAWFILE_MMAP) {
+				assert(e->e_rawfile != NULL);
+				assert(e->e_cmd == ELF_C_RDWR);
+				if (munmap(e->e_rawfile, e->e_rawsize) < 0) {
+					LIBELF_SET_ERROR(IO, errno);
+					goto error;
+				}
+			}
 #endif
-	}
+		}
 
-	/*
-	 * Write out the new contents.
-	 */
-	if (write(e->e_fd, newfile, (size_t) newsize) != newsize) {
-		LIBELF_SET_ERROR(IO, errno);
-		goto error;
+		/*
+		 * Write out the new contents.
+		 */
+		o.o_image = NULL;
+		if (!_libelf_output_write(&o, newfile, (size_t) newsize))
+			goto error;
+	} else if (inplace) {
+		/*
+		 * Discard any content beyond the end of the new file,
+		 * and the mapping of the old contents.
+		 */
+		if (ftruncate(e->e_fd, newsize) < 0) {
+			LIBELF_SET_ERROR(IO, errno);
+			goto error;
+		}
+#if	ELFTC_HAVE_MMAP
+		assert(e->e_flags & LIBELF_F_RAWFILE_MMAP);
+		if (munmap(e->e_rawfile, e->e_rawsize) < 0) {
+			LIBELF_SET_ERROR(IO, errno);
+			goto error;
+		}
+#endif
 	}
 
 	/*
@@ -1143,7 +1506,12 @@ _libelf_write_elf(Elf *e, off_t newsize, struct _Elf_Extent_List *extents)
 	return (rc);
 
  error:
-	free(newfile);
+	if (newfile)
+		free(newfile);
+#if	ELFTC_HAVE_MMAP
+	if (mapped)
+		(void) munmap(o.o_image, (size_t) newsize);
+#endif
 
 	return ((off_t) -1);
 }
@@ -75,12 +75,20 @@ size_t		gelf_fsize(Elf *_elf, Elf_Type _type, size_t _count,
 			unsigned int _version);
 int		gelf_getclass(Elf *_elf);
 GElf_Dyn	*gelf_getdyn(Elf_Data *_data, int _index, GElf_Dyn *_dst);
+int		gelf_getdyns(Elf_Data *_data, int _index, int _count,
+			GElf_Dyn *_dst);
 GElf_Ehdr	*gelf_getehdr(Elf *_elf, GElf_Ehdr *_dst);
 GElf_Phdr	*gelf_getphdr(Elf *_elf, int _index, GElf_Phdr *_dst);
 GElf_Rel	*gelf_getrel(Elf_Data *_src, int _index, GElf_Rel *_dst);
 GElf_Rela	*gelf_getrela(Elf_Data *_src, int _index, GElf_Rela *_dst);
+int		gelf_getrelas(Elf_Data *_src, int _index, int _count,
+			GElf_Rela *_dst);
+int		gelf_getrels(Elf_Data *_src, int _index, int _count,
+			GElf_Rel *_dst);
 GElf_Shdr	*gelf_getshdr(Elf_Scn *_scn, GElf_Shdr *_dst);
 GElf_Sym	*gelf_getsym(Elf_Data *_src, int _index, GElf_Sym *_dst);
+int		gelf_getsyms(Elf_Data *_src, int _index, int _count,
+			GElf_Sym *_dst);
 GElf_Sym	*gelf_getsymshndx(Elf_Data *_src, Elf_Data *_shindexsrc,
 			int _index, GElf_Sym *_dst, Elf32_Word *_shindexdst);
 void *		gelf_newehdr(Elf *_elf, int _class);
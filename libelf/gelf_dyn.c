@@ -29,6 +29,7 @@
 #include <assert.h>
 #include <gelf.h>
 #include <limits.h>
+#include <string.h>
 
 #include "_libelf.h"
 
@@ -93,6 +94,33 @@ gelf_getdyn(Elf_Data *ed, int ndx, GElf_Dyn *dst)
 	return (dst);
 }
 
+int
+gelf_getdyns(Elf_Data *ed, int ndx, int count, GElf_Dyn *dst)
+{
+	int ec, i, n;
+	Elf32_Dyn *dyn32;
+
+	if (dst == NULL) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (-1);
+	}
+
+	if ((n = _libelf_getdata_array(ed, ELF_T_DYN, ndx, count, &ec)) <= 0)
+		return (n);
+
+	if (ec == ELFCLASS32) {
+		dyn32 = (Elf32_Dyn *) ed->d_buf + ndx;
+		for (i = 0; i < n; i++, dyn32++, dst++) {
+			dst->d_tag      = dyn32->d_tag;
+			dst->d_un.d_val = (Elf64_Xword) dyn32->d_un.d_val;
+		}
+	} else
+		(void) memcpy(dst, (Elf64_Dyn *) ed->d_buf + ndx,
+		    (size_t) n * sizeof(*dst));
+
+	return (n);
+}
+
 int
 gelf_update_dyn(Elf_Data *ed, int ndx, GElf_Dyn *ds)
 {
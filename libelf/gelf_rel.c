@@ -29,6 +29,7 @@
 #include <assert.h>
 #include <gelf.h>
 #include <limits.h>
+#include <string.h>
 
 #include "_libelf.h"
 
@@ -95,6 +96,35 @@ gelf_getrel(Elf_Data *ed, int ndx, GElf_Rel *dst)
 	return (dst);
 }
 
+int
+gelf_getrels(Elf_Data *ed, int ndx, int count, GElf_Rel *dst)
+{
+	int ec, i, n;
+	Elf32_Rel *rel32;
+
+	if (dst == NULL) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (-1);
+	}
+
+	if ((n = _libelf_getdata_array(ed, ELF_T_REL, ndx, count, &ec)) <= 0)
+		return (n);
+
+	if (ec == ELFCLASS32) {
+		rel32 = (Elf32_Rel *) ed->d_buf + ndx;
+		for (i = 0; i < n; i++, rel32++, dst++) {
+			dst->r_offset = (Elf64_Addr) rel32->r_offset;
+			dst->r_info   = ELF64_R_INFO(
+			    (Elf64_Xword) ELF32_R_SYM(rel32->r_info),
+			    ELF32_R_TYPE(rel32->r_info));
+		}
+	} else
+		(void) memcpy(dst, (Elf64_Rel *) ed->d_buf + ndx,
+		    (size_t) n * sizeof(*dst));
+
+	return (n);
+}
+
 int
 gelf_update_rel(Elf_Data *ed, int ndx, GElf_Rel *dr)
 {
@@ -29,6 +29,7 @@
 #include <assert.h>
 #include <gelf.h>
 #include <limits.h>
+#include <string.h>
 
 #include "_libelf.h"
 
@@ -96,6 +97,36 @@ gelf_getrela(Elf_Data *ed, int ndx, GElf_Rela *dst)
 	return (dst);
 }
 
+int
+gelf_getrelas(Elf_Data *ed, int ndx, int count, GElf_Rela *dst)
+{
+	int ec, i, n;
+	Elf32_Rela *rela32;
+
+	if (dst == NULL) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (-1);
+	}
+
+	if ((n = _libelf_getdata_array(ed, ELF_T_RELA, ndx, count, &ec)) <= 0)
+		return (n);
+
+	if (ec == ELFCLASS32) {
+		rela32 = (Elf32_Rela *) ed->d_buf + ndx;
+		for (i = 0; i < n; i++, rela32++, dst++) {
+			dst->r_offset = (Elf64_Addr) rela32->r_offset;
+			dst->r_info   = ELF64_R_INFO(
+			    (Elf64_Xword) ELF32_R_SYM(rela32->r_info),
+			    ELF32_R_TYPE(rela32->r_info));
+			dst->r_addend = (Elf64_Sxword) rela32->r_addend;
+		}
+	} else
+		(void) memcpy(dst, (Elf64_Rela *) ed->d_buf + ndx,
+		    (size_t) n * sizeof(*dst));
+
+	return (n);
+}
+
 int
 gelf_update_rela(Elf_Data *ed, int ndx, GElf_Rela *dr)
 {
@@ -29,6 +29,7 @@
 #include <assert.h>
 #include <gelf.h>
 #include <limits.h>
+#include <string.h>
 
 #include "_libelf.h"
 
@@ -98,6 +99,39 @@ gelf_getsym(Elf_Data *ed, int ndx, GElf_Sym *dst)
 	return (dst);
 }
 
+int
+gelf_getsyms(Elf_Data *ed, int ndx, int count, GElf_Sym *dst)
+{
+	int ec, i, n;
+	Elf32_Sym *sym32;
+
+	if (dst == NULL) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (-1);
+	}
+
+	if ((n = _libelf_getdata_array(ed, ELF_T_SYM, ndx, count, &ec)) <= 0)
+		return (n);
+
+	if (ec == ELFCLASS32) {
+		sym32 = (Elf32_Sym *) ed->d_buf + ndx;
+		for (i = 0; i < n; i++, sym32++, dst++) {
+			dst->st_name  = sym32->st_name;
+			dst->st_value = (Elf64_Addr) sym32->st_value;
+			dst->st_size  = (Elf64_Xword) sym32->st_size;
+			dst->st_info  = ELF64_ST_INFO(
+			    ELF32_ST_BIND(sym32->st_info),
+			    ELF32_ST_TYPE(sym32->st_info));
+			dst->st_other = sym32->st_other;
+			dst->st_shndx = sym32->st_shndx;
+		}
+	} else
+		(void) memcpy(dst, (Elf64_Sym *) ed->d_buf + ndx,
+		    (size_t) n * sizeof(*dst));
+
+	return (n);
+}
+
 int
 gelf_update_sym(Elf_Data *ed, int ndx, GElf_Sym *gs)
 {
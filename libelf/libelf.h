@@ -175,6 +175,7 @@ enum Elf_Error {
 /* ELF(3) API extensions. */
 #define	ELF_F_ARCHIVE	   0x100U /* archive creation */
 #define	ELF_F_ARCHIVE_SYSV 0x200U /* SYSV style archive */
+#define	ELF_F_NOCOPY	   0x400U /* share section data with the file */
 
 __BEGIN_DECLS
 Elf		*elf_begin(int _fd, Elf_Cmd _cmd, Elf *_elf);
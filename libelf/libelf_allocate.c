@@ -44,12 +44,37 @@ Elf *
 _libelf_allocate_elf(void)
 {
 	Elf *e;
+#if	ELFTC_HAVE_PTHREADS
+	int error;
+	pthread_mutexattr_t attr;
+#endif
 
 	if ((e = malloc(sizeof(*e))) == NULL) {
 		LIBELF_SET_ERROR(RESOURCE, errno);
 		return NULL;
 	}
 
+#if	ELFTC_HAVE_PTHREADS
+	/*
+	 * The lock is recursive, since lazily loaded state may be
+	 * brought in from within other locked operations.
+	 */
+	if ((error = pthread_mutexattr_init(&attr)) != 0) {
+		free(e);
+		LIBELF_SET_ERROR(RESOURCE, error);
+		return NULL;
+	}
+	if ((error = pthread_mutexattr_settype(&attr,
+	    PTHREAD_MUTEX_RECURSIVE)) == 0)
+		error = pthread_mutex_init(&e->e_lock, &attr);
+	(void) pthread_mutexattr_destroy(&attr);
+	if (error != 0) {
+		free(e);
+		LIBELF_SET_ERROR(RESOURCE, error);
+		return NULL;
+	}
+#endif
+
 	e->e_activations = 1;
 	e->e_hdr.e_rawhdr = NULL;
 	e->e_byteorder   = ELFDATANONE;
@@ -115,6 +140,8 @@ _libelf_release_elf(Elf *e)
 
 		assert(STAILQ_EMPTY(&e->e_u.e_elf.e_scn));
 
+		FREE(e->e_u.e_elf.e_scnndx);
+
 		if (e->e_flags & LIBELF_F_AR_HEADER) {
 			arh = e->e_hdr.e_arhdr;
 			FREE(arh->ar_name);
@@ -128,6 +155,10 @@ _libelf_release_elf(Elf *e)
 		break;
 	}
 
+#if	ELFTC_HAVE_PTHREADS
+	(void) pthread_mutex_destroy(&e->e_lock);
+#endif
+
 	free(e);
 
 	return (NULL);
@@ -160,11 +191,51 @@ _libelf_release_data(struct _Libelf_Data *d)
 	return (NULL);
 }
 
+/*
+ * Grow the section index table of ELF descriptor `e' so that it
+ * can hold at least `nscn' entries.
+ */
+int
+_libelf_grow_scn_index(Elf *e, size_t nscn)
+{
+	size_t n;
+	Elf_Scn **t;
+
+	if (nscn <= e->e_u.e_elf.e_scnndxsz)
+		return (1);
+
+	for (n = e->e_u.e_elf.e_scnndxsz ? e->e_u.e_elf.e_scnndxsz :
+	    LIBELF_SCN_INDEX_MIN; n < nscn; n *= 2)
+		;
+
+	if ((t = realloc(e->e_u.e_elf.e_scnndx, n * sizeof(*t))) == NULL) {
+		LIBELF_SET_ERROR(RESOURCE, errno);
+		return (0);
+	}
+
+	(void) memset(t + e->e_u.e_elf.e_scnndxsz, 0,
+	    (n - e->e_u.e_elf.e_scnndxsz) * sizeof(*t));
+
+	e->e_u.e_elf.e_scnndx = t;
+	e->e_u.e_elf.e_scnndxsz = n;
+
+	return (1);
+}
+
+/*
+ * Allocate a descriptor for section `ndx' and append it to the
+ * section list.  Descriptors may be created out of order when section
+ * headers are read in lazily; _libelf_load_section_headers() puts the
+ * list back in index order before it is walked.
+ */
 Elf_Scn *
 _libelf_allocate_scn(Elf *e, size_t ndx)
 {
 	Elf_Scn *s;
 
+	if (!_libelf_grow_scn_index(e, ndx + 1))
+		return (NULL);
+
 	if ((s = calloc((size_t) 1, sizeof(Elf_Scn))) == NULL) {
 		LIBELF_SET_ERROR(RESOURCE, errno);
 		return (NULL);
@@ -178,6 +249,9 @@ _libelf_allocate_scn(Elf *e, size_t ndx)
 
 	STAILQ_INSERT_TAIL(&e->e_u.e_elf.e_scn, s, s_next);
 
+	assert(e->e_u.e_elf.e_scnndx[ndx] == NULL);
+	e->e_u.e_elf.e_scnndx[ndx] = s;
+
 	return (s);
 }
 
@@ -206,6 +280,10 @@ _libelf_release_scn(Elf_Scn *s)
 
 	STAILQ_REMOVE(&e->e_u.e_elf.e_scn, s, _Elf_Scn, s_next);
 
+	assert(s->s_ndx < e->e_u.e_elf.e_scnndxsz &&
+	    e->e_u.e_elf.e_scnndx[s->s_ndx] == s);
+	e->e_u.e_elf.e_scnndx[s->s_ndx] = NULL;
+
 	free(s);
 
 	return (NULL);
@@ -147,6 +147,7 @@ _libelf_cvt_$1$4_tof(char *dst, size_t dsz, char *src, size_t count,
     int byteswap)
 {
 	Elf$3_$2 t, *s = (Elf$3_$2 *) (uintptr_t) src;
+	static const unsigned char layout[] = { sizeof(t) };
 	size_t c;
 
 	(void) dsz;
@@ -156,6 +157,10 @@ _libelf_cvt_$1$4_tof(char *dst, size_t dsz, char *src, size_t count,
 		return (1);
 	}
 
+	if (_libelf_swap_fields(dst, src, count, sizeof(t), layout,
+	    sizeof(layout)))
+		return (1);
+
 	for (c = 0; c < count; c++) {
 		t = *s++;
 		SWAP_$1$4(t);
@@ -170,6 +175,7 @@ _libelf_cvt_$1$4_tom(char *dst, size_t dsz, char *src, size_t count,
     int byteswap)
 {
 	Elf$3_$2 t, *d = (Elf$3_$2 *) (uintptr_t) dst;
+	static const unsigned char layout[] = { sizeof(t) };
 	size_t c;
 
 	if (dsz < count * sizeof(Elf$3_$2))
@@ -180,6 +186,10 @@ _libelf_cvt_$1$4_tom(char *dst, size_t dsz, char *src, size_t count,
 		return (1);
 	}
 
+	if (_libelf_swap_fields(dst, src, count, sizeof(t), layout,
+	    sizeof(layout)))
+		return (1);
+
 	for (c = 0; c < count; c++) {
 		READ_$1$4(src,t);
 		SWAP_$1$4(t);
@@ -248,6 +258,23 @@ define(`READ_STRUCT',
   `pushdef(`SZ',$2)/* Read an Elf$2_$1 */
 		READ_MEMBERS(Elf$2_$1_DEF)popdef(`SZ')')
 
+# LAYOUT_FIELD(FIELDNAME,ELFTYPE) -- Generate the width of one field.
+# Fields that are not integral quantities are marked with a zero.
+define(`LAYOUT_FIELD',
+  `ifelse($2,`IDENT',`0',`sizeof(t.$1)'),
+		')
+
+# LAYOUT_MEMBERS(ELFTYPELIST) -- Iterate over a structure definition.
+define(`LAYOUT_MEMBERS',
+  `ifelse($#,1,`/**/',
+    `LAYOUT_FIELD($1)LAYOUT_MEMBERS(shift($@))')')
+
+# LAYOUT_STRUCT(CTYPE,SIZE) -- Generate the field widths of an ELF
+# structure, for use by _libelf_swap_fields().
+define(`LAYOUT_STRUCT',
+  `static const unsigned char layout[] = {
+		LAYOUT_MEMBERS(Elf$2_$1_DEF)
+	}')
 
 # MAKECOMPFUNCS -- Generate converters for composite ELF structures.
 #
@@ -256,6 +283,9 @@ define(`READ_STRUCT',
 # representation.  When converting data to memory, the destination
 # pointer will be similarly aligned.
 #
+# Byte swapping conversions are first offered to _libelf_swap_fields(),
+# which handles structures whose file and memory layouts coincide.
+#
 # For in-place conversions, when converting to file representations,
 # the source buffer is large enough to hold `file' data.  When
 # converting from file to memory, we need to be careful to work
@@ -271,10 +301,15 @@ _libelf_cvt_$1$3_tof(char *dst, size_t dsz, char *src, size_t count,
     int byteswap)
 {
 	Elf$3_$2	t, *s;
+	LAYOUT_STRUCT($2,$3);
 	size_t c;
 
 	(void) dsz;
 
+	if (byteswap && _libelf_swap_fields(dst, src, count, sizeof(t),
+	    layout, sizeof(layout)))
+		return (1);
+
 	s = (Elf$3_$2 *) (uintptr_t) src;
 	for (c = 0; c < count; c++) {
 		t = *s++;
@@ -292,6 +327,7 @@ _libelf_cvt_$1$3_tom(char *dst, size_t dsz, char *src, size_t count,
     int byteswap)
 {
 	Elf$3_$2	 t, *d;
+	LAYOUT_STRUCT($2,$3);
 	char		*s,*s0;
 	size_t		fsz;
 
@@ -302,6 +338,10 @@ _libelf_cvt_$1$3_tom(char *dst, size_t dsz, char *src, size_t count,
 	if (dsz < count * sizeof(Elf$3_$2))
 		return (0);
 
+	if (byteswap && _libelf_swap_fields(dst, src, count, sizeof(t),
+	    layout, sizeof(layout)))
+		return (1);
+
 	while (count--) {
 		s = s0;
 		READ_STRUCT($2,$3)
@@ -534,6 +574,17 @@ divert(0)
 
 #define	SWAP_BYTE(X)	do { (void) (X); } while (0)
 #define	SWAP_IDENT(X)	do { (void) (X); } while (0)
+#if	defined(__GNUC__)
+#define	SWAP_HALF(X)	do {						\
+		(X) = __builtin_bswap16((uint16_t) (X));		\
+	} while (0)
+#define	SWAP_WORD(X)	do {						\
+		(X) = __builtin_bswap32((uint32_t) (X));		\
+	} while (0)
+#define	SWAP_WORD64(X)	do {						\
+		(X) = __builtin_bswap64((uint64_t) (X));		\
+	} while (0)
+#else
 #define	SWAP_HALF(X)	do {						\
 		uint16_t _x = (uint16_t) (X);				\
 		uint16_t _t = _x & 0xFF;				\
@@ -548,9 +599,6 @@ divert(0)
 		_t <<= 8; _x >>= 8; _t |= _x & 0xFF;			\
 		(X) = _t;						\
 	} while (0)
-#define	SWAP_ADDR32(X)	SWAP_WORD(X)
-#define	SWAP_OFF32(X)	SWAP_WORD(X)
-#define	SWAP_SWORD(X)	SWAP_WORD(X)
 #define	SWAP_WORD64(X)	do {						\
 		uint64_t _x = (uint64_t) (X);				\
 		uint64_t _t = _x & 0xFF;				\
@@ -563,6 +611,10 @@ divert(0)
 		_t <<= 8; _x >>= 8; _t |= _x & 0xFF;			\
 		(X) = _t;						\
 	} while (0)
+#endif	/* __GNUC__ */
+#define	SWAP_ADDR32(X)	SWAP_WORD(X)
+#define	SWAP_OFF32(X)	SWAP_WORD(X)
+#define	SWAP_SWORD(X)	SWAP_WORD(X)
 #define	SWAP_ADDR64(X)	SWAP_WORD64(X)
 #define	SWAP_LWORD(X)	SWAP_WORD64(X)
 #define	SWAP_OFF64(X)	SWAP_WORD64(X)
@@ -1005,6 +1057,9 @@ _libelf_cvt_NOTE_tof(char *dst, size_t dsz, char *src, size_t count,
 		descsz = en->n_descsz;
 		type = en->n_type;
 
+		/* Compute the note's size before byteswapping. */
+		sz = ((namesz + 3U) & ~3U) + ((descsz + 3U) & ~3U);
+
 		SWAP_WORD(namesz);
 		SWAP_WORD(descsz);
 		SWAP_WORD(type);
@@ -1014,11 +1069,7 @@ _libelf_cvt_NOTE_tof(char *dst, size_t dsz, char *src, size_t count,
 		WRITE_WORD(dst, type);
 
 		src += sizeof(Elf_Note);
-
-		ROUNDUP2(namesz, 4);
-		ROUNDUP2(descsz, 4);
-
-		sz = namesz + descsz;
+		count -= sizeof(Elf_Note);
 
 		if (count < sz)
 			sz = count;
@@ -26,12 +26,67 @@
 
 #include <sys/cdefs.h>
 
+#include <assert.h>
 #include <libelf.h>
 
 #include "_libelf.h"
 
 ELFTC_VCSID("$Id$");
 
+/*
+ * Check a request for `count' objects of type `t' starting at index
+ * `ndx' of data descriptor `ed', as made by the functions that
+ * retrieve arrays of objects.  Returns the number of objects
+ * available, which may be less than `count', or -1 in case of an
+ * error.  The class of the underlying ELF object is returned in
+ * `*ecp'.
+ */
+int
+_libelf_getdata_array(Elf_Data *ed, Elf_Type t, int ndx, int count,
+    int *ecp)
+{
+	int ec;
+	Elf *e;
+	size_t msz, n;
+	Elf_Scn *scn;
+	uint32_t sh_type;
+	struct _Libelf_Data *d;
+
+	d = (struct _Libelf_Data *) ed;
+
+	if (d == NULL || ndx < 0 || count < 0 ||
+	    (scn = d->d_scn) == NULL ||
+	    (e = scn->s_elf) == NULL) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (-1);
+	}
+
+	ec = e->e_class;
+	assert(ec == ELFCLASS32 || ec == ELFCLASS64);
+
+	if (ec == ELFCLASS32)
+		sh_type = scn->s_shdr.s_shdr32.sh_type;
+	else
+		sh_type = scn->s_shdr.s_shdr64.sh_type;
+
+	if (_libelf_xlate_shtype(sh_type) != (int) t) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (-1);
+	}
+
+	msz = _libelf_msize(t, ec, e->e_version);
+	assert(msz > 0);
+
+	if ((size_t) ndx > (n = d->d_data.d_size / msz)) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (-1);
+	}
+
+	*ecp = ec;
+
+	return ((size_t) count > n - ndx ? (int) (n - ndx) : count);
+}
+
 int
 _libelf_xlate_shtype(uint32_t sht)
 {
@@ -64,6 +119,8 @@ _libelf_xlate_shtype(uint32_t sht)
 		return (ELF_T_REL);
 	case SHT_RELA:
 		return (ELF_T_RELA);
+	case SHT_RELR:
+		return (ELF_T_ADDR);
 	case SHT_STRTAB:
 		return (ELF_T_BYTE);
 	case SHT_SYMTAB:
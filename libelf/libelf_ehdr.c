@@ -98,8 +98,8 @@ _libelf_load_extended(Elf *e, int ec, uint64_t shoff, uint16_t phnum,
 		eh->e_version = LIBELF_PRIVATE(version);		\
 	} while (0)
 
-void *
-_libelf_ehdr(Elf *e, int ec, int allocate)
+static void *
+_libelf_load_ehdr(Elf *e, int ec, int allocate)
 {
 	void *ehdr;
 	size_t fsz, msz;
@@ -202,3 +202,20 @@ _libelf_ehdr(Elf *e, int ec, int allocate)
 
 	return (ehdr);
 }
+
+void *
+_libelf_ehdr(Elf *e, int ec, int allocate)
+{
+	void *ehdr;
+
+	if (e == NULL || e->e_kind != ELF_K_ELF) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (NULL);
+	}
+
+	LIBELF_LOCK(e);
+	ehdr = _libelf_load_ehdr(e, ec, allocate);
+	LIBELF_UNLOCK(e);
+
+	return (ehdr);
+}
@@ -41,7 +41,8 @@ _libelf_getscn0(Elf *e)
 {
 	Elf_Scn *s;
 
-	if ((s = STAILQ_FIRST(&e->e_u.e_elf.e_scn)) != NULL)
+	if (e->e_u.e_elf.e_scnndxsz > 0 &&
+	    (s = e->e_u.e_elf.e_scnndx[SHN_UNDEF]) != NULL)
 		return (s);
 
 	return (_libelf_allocate_scn(e, (size_t) SHN_UNDEF));
@@ -35,8 +35,8 @@
 
 ELFTC_VCSID("$Id$");
 
-void *
-_libelf_getphdr(Elf *e, int ec)
+static void *
+_libelf_load_phdr(Elf *e, int ec)
 {
 	size_t phnum;
 	size_t fsz, msz;
@@ -106,6 +106,23 @@ _libelf_getphdr(Elf *e, int ec)
 	return (phdr);
 }
 
+void *
+_libelf_getphdr(Elf *e, int ec)
+{
+	void *phdr;
+
+	if (e == NULL) {
+		LIBELF_SET_ERROR(ARGUMENT, 0);
+		return (NULL);
+	}
+
+	LIBELF_LOCK(e);
+	phdr = _libelf_load_phdr(e, ec);
+	LIBELF_UNLOCK(e);
+
+	return (phdr);
+}
+
 void *
 _libelf_newphdr(Elf *e, int ec, size_t count)
 {
@@ -0,0 +1,227 @@
+/*-
+ * Copyright (c) 2026 The Elftoolchain Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <libelf.h>
+#include <string.h>
+
+#include "_libelf.h"
+
+ELFTC_VCSID("$Id$");
+
+/*
+ * Vectorized byte swapping for arrays of fixed size ELF types.
+ *
+ * When an ELF type has no padding in its in-memory representation, its
+ * file and memory representations share a layout, and changing the
+ * byte order of an array of such objects amounts to applying a fixed
+ * permutation to every group of bytes whose length is a common
+ * multiple of the object size and the vector size.  The permutation is
+ * computed from the widths of the type's fields and applied using
+ * byte shuffle instructions.
+ *
+ * _libelf_swap_fields() returns zero if it cannot handle a request,
+ * in which case the caller falls back to its scalar code.
+ */
+
+/*
+ * The vector code needs per-function target attributes and
+ * __builtin_cpu_supports(), which appeared in GCC 4.9.  Clang reports
+ * itself as GCC 4.2, so ask it about these features directly.
+ */
+#if	defined(__clang__)
+#if	defined(__has_attribute) && defined(__has_builtin)
+#if	__has_attribute(target) && __has_builtin(__builtin_cpu_supports)
+#define	LIBELF_SWAP_CC		1
+#endif
+#endif
+#elif	defined(__GNUC__)
+#if	__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#define	LIBELF_SWAP_CC		1
+#endif
+#endif
+
+#if	defined(LIBELF_SWAP_CC) && (defined(__i386__) || defined(__x86_64__))
+#define	LIBELF_SWAP_X86		1
+#include <immintrin.h>
+#else
+#define	LIBELF_SWAP_X86		0
+#endif
+
+#if	LIBELF_SWAP_X86
+
+#define	LIBELF_SWAP_VECSZ	32	/* bytes in the widest vector used */
+#define	LIBELF_SWAP_MAXPERIOD	256	/* bytes in a permutation period */
+#define	LIBELF_SWAP_MINSIZE	128	/* smaller arrays use scalar code */
+
+struct _libelf_swap_plan {
+	size_t		sp_period;	/* bytes in the permutation */
+	unsigned char	sp_perm[LIBELF_SWAP_MAXPERIOD];
+	unsigned char	sp_mask[LIBELF_SWAP_MAXPERIOD];
+};
+
+/*
+ * Compute the byte permutation for an object of size `size' with
+ * fields of the widths listed in `layout'.  Each entry of
+ * sp_mask[] is the source position of a byte relative to the start
+ * of its 16 byte lane, as required by the PSHUFB instruction.
+ */
+static int
+_libelf_swap_plan(struct _libelf_swap_plan *sp, size_t size,
+    const unsigned char *layout, size_t nfields)
+{
+	size_t f, i, n, off, period;
+
+	if (size == 0 || size > LIBELF_SWAP_MAXPERIOD)
+		return (0);
+
+	for (off = f = 0; f < nfields; f++) {
+		if (layout[f] == 0 || off + layout[f] > size)
+			return (0);
+		for (i = 0; i < layout[f]; i++)
+			sp->sp_perm[off + i] = (unsigned char)
+			    (off + layout[f] - 1 - i);
+		off += layout[f];
+	}
+	if (off != size)	/* the type has padding */
+		return (0);
+
+	for (period = size; period % LIBELF_SWAP_VECSZ; period += size)
+		if (period + size > LIBELF_SWAP_MAXPERIOD)
+			return (0);
+
+	for (n = size; n < period; n++)
+		sp->sp_perm[n] = (unsigned char) (sp->sp_perm[n % size] +
+		    (n / size) * size);
+
+	/* Fields that straddle a vector lane cannot be handled. */
+	for (n = 0; n < period; n++) {
+		if (sp->sp_perm[n] / 16 != n / 16)
+			return (0);
+		sp->sp_mask[n] = sp->sp_perm[n] % 16;
+	}
+
+	sp->sp_period = period;
+
+	return (1);
+}
+
+__attribute__((target("ssse3")))
+static size_t
+_libelf_swap_ssse3(char *dst, const char *src, size_t sz,
+    const struct _libelf_swap_plan *sp)
+{
+	__m128i m, v;
+	size_t off, p;
+
+	for (off = p = 0; off + 16 <= sz; off += 16) {
+		m = _mm_loadu_si128((const __m128i *) (const void *)
+		    &sp->sp_mask[p]);
+		v = _mm_loadu_si128((const __m128i *) (const void *)
+		    (src + off));
+		_mm_storeu_si128((__m128i *) (void *) (dst + off),
+		    _mm_shuffle_epi8(v, m));
+		if ((p += 16) == sp->sp_period)
+			p = 0;
+	}
+
+	return (off);
+}
+
+__attribute__((target("avx2")))
+static size_t
+_libelf_swap_avx2(char *dst, const char *src, size_t sz,
+    const struct _libelf_swap_plan *sp)
+{
+	__m256i m, v;
+	size_t off, p;
+
+	for (off = p = 0; off + 32 <= sz; off += 32) {
+		m = _mm256_loadu_si256((const __m256i *) (const void *)
+		    &sp->sp_mask[p]);
+		v = _mm256_loadu_si256((const __m256i *) (const void *)
+		    (src + off));
+		_mm256_storeu_si256((__m256i *) (void *) (dst + off),
+		    _mm256_shuffle_epi8(v, m));
+		if ((p += 32) == sp->sp_period)
+			p = 0;
+	}
+
+	return (off);
+}
+
+int
+_libelf_swap_fields(char *dst, const char *src, size_t count, size_t size,
+    const unsigned char *layout, size_t nfields)
+{
+	struct _libelf_swap_plan sp;
+	char tmp[LIBELF_SWAP_VECSZ];
+	size_t i, n, off, p, sz;
+
+	sz = count * size;
+	if (sz < LIBELF_SWAP_MINSIZE)
+		return (0);
+
+	/* Only identical or disjoint buffers are supported. */
+	if (dst != src && dst < src + sz && src < dst + sz)
+		return (0);
+
+	if (!__builtin_cpu_supports("ssse3") ||
+	    !_libelf_swap_plan(&sp, size, layout, nfields))
+		return (0);
+
+	if (__builtin_cpu_supports("avx2"))
+		off = _libelf_swap_avx2(dst, src, sz, &sp);
+	else
+		off = _libelf_swap_ssse3(dst, src, sz, &sp);
+
+	/*
+	 * Handle the remaining bytes, which start on a lane boundary
+	 * and hence contain only whole fields.
+	 */
+	if ((n = sz - off) > 0) {
+		(void) memcpy(tmp, src + off, n);
+		for (i = 0; i < n; i++) {
+			p = (off + i) % sp.sp_period;
+			dst[off + i] = tmp[i + sp.sp_perm[p] - p];
+		}
+	}
+
+	return (1);
+}
+
+#else	/* !LIBELF_SWAP_X86 */
+
+int
+_libelf_swap_fields(char *dst, const char *src, size_t count, size_t size,
+    const unsigned char *layout, size_t nfields)
+{
+	(void) dst; (void) src; (void) count; (void) size;
+	(void) layout; (void) nfields;
+
+	return (0);
+}
+
+#endif	/* LIBELF_SWAP_X86 */
@@ -29,6 +29,10 @@ _LDADD_LIBELF=${LDADD:M-lelf}
 .if !empty(_LDADD_LIBELF)
 CFLAGS+= -I${TOP}/libelf
 LDFLAGS+= -L${TOP}/libelf
+# libelf uses pthread(3) mutexes to protect shared descriptors.
+.if ${OS_HOST} != "Minix"
+LDADD+= -lpthread
+.endif
 .endif
 
 _LDADD_LIBELFTC=${LDADD:M-lelftc}
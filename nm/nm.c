@@ -172,6 +172,7 @@ p->t_table == NULL || p->s_table == NULL || p->filename == NULL)
 #define	IS_SYM_TYPE(t)		((t) == '?' || isalpha((t)) != 0)
 #define	IS_UNDEF_SYM_TYPE(t)	((t) == 'U' || (t) == 'v' || (t) == 'w')
 #define	UNUSED(p)		((void)p)
+#define	SYM_BATCH		256	/* symbols read at a time */
 
 static int		cmp_name(const void *, const void *);
 static int		cmp_none(const void *, const void *);
@@ -618,14 +619,14 @@ get_sym(Elf *elf, struct sym_head *headp, int shnum, size_t dynndx,
 	Elf_Scn *scn;
 	Elf_Data *data;
 	GElf_Shdr shdr;
-	GElf_Sym sym;
+	GElf_Sym *sym, syms[SYM_BATCH];
 	struct filter_entry *fep;
 	size_t ndx;
 	int rtn;
 	const char *sym_name;
 	char type;
 	bool filter;
-	int i, j;
+	int i, j, k, n;
 
 	assert(elf != NULL);
 	assert(headp != NULL);
@@ -653,24 +654,27 @@ get_sym(Elf *elf, struct sym_head *headp, int shnum, size_t dynndx,
 
 		data = NULL;
 		while ((data = elf_getdata(scn, data)) != NULL) {
-			j = 1;
-			while (gelf_getsym(data, j++, &sym) != NULL) {
-				sym_name = get_sym_name(elf, &sym, ndx,
-				    sec_table, sec_table_size);
-				filter = false;
-				type = get_sym_type(&sym, type_table);
-				SLIST_FOREACH(fep, &nm_out_filter,
-				    filter_entries) {
-					if (!fep->fn(type, &sym, sym_name)) {
-						filter = true;
-						break;
+			for (j = 1; (n = gelf_getsyms(data, j, SYM_BATCH,
+			    syms)) > 0; j += n) {
+				for (k = 0, sym = syms; k < n; k++, sym++) {
+					sym_name = get_sym_name(elf, sym, ndx,
+					    sec_table, sec_table_size);
+					filter = false;
+					type = get_sym_type(sym, type_table);
+					SLIST_FOREACH(fep, &nm_out_filter,
+					    filter_entries) {
+						if (!fep->fn(type, sym,
+						    sym_name)) {
+							filter = true;
+							break;
+						}
+					}
+					if (filter == false) {
+						if (sym_list_insert(headp,
+						    sym_name, sym) == 0)
+							return (0);
+						rtn++;
 					}
-				}
-				if (filter == false) {
-					if (sym_list_insert(headp, sym_name,
-					    &sym) == 0)
-						return (0);
-					rtn++;
 				}
 			}
 		}
@@ -97,6 +97,11 @@ ELFTC_VCSID("$Id$");
  */
 #define	DISPLAY_FILENAME	0x0001
 
+/*
+ * Number of symbols or relocations retrieved from libelf at a time.
+ */
+#define	BATCH_SIZE		256
+
 /*
  * Internal data structure for sections.
  */
@@ -669,6 +674,7 @@ section_type(unsigned int mach, unsigned int stype)
 	case SHT_PREINIT_ARRAY: return "PREINIT_ARRAY";
 	case SHT_GROUP: return "GROUP";
 	case SHT_SYMTAB_SHNDX: return "SYMTAB_SHNDX";
+	case SHT_RELR: return "RELR";
 	case SHT_SUNW_dof: return "SUNW_dof";
 	case SHT_SUNW_cap: return "SUNW_cap";
 	case SHT_GNU_HASH: return "GNU_HASH";
@@ -859,6 +865,9 @@ dt_type(unsigned int mach, unsigned int dtype)
 	case DT_PREINIT_ARRAY: return "PREINIT_ARRAY";
 	case DT_PREINIT_ARRAYSZ: return "PREINIT_ARRAYSZ";
 	case DT_MAXPOSTAGS: return "MAXPOSTAGS";
+	case DT_RELRSZ: return "RELRSZ";
+	case DT_RELR: return "RELR";
+	case DT_RELRENT: return "RELRENT";
 	case DT_SUNW_AUXILIARY: return "SUNW_AUXILIARY";
 	case DT_SUNW_RTLDINF: return "SUNW_RTLDINF";
 	case DT_SUNW_FILTER: return "SUNW_FILTER";
@@ -2780,6 +2789,7 @@ dump_dyn_val(struct readelf *re, GElf_Dyn *dyn, uint32_t stab)
 	case DT_INIT:
 	case DT_SYMBOLIC:
 	case DT_REL:
+	case DT_RELR:
 	case DT_DEBUG:
 	case DT_TEXTREL:
 	case DT_JMPREL:
@@ -2799,6 +2809,8 @@ dump_dyn_val(struct readelf *re, GElf_Dyn *dyn, uint32_t stab)
 	case DT_SYMENT:
 	case DT_RELSZ:
 	case DT_RELENT:
+	case DT_RELRSZ:
+	case DT_RELRENT:
 	case DT_INIT_ARRAYSZ:
 	case DT_FINI_ARRAYSZ:
 	case DT_GNU_CONFLICTSZ:
@@ -2837,10 +2849,10 @@ dump_dyn_val(struct readelf *re, GElf_Dyn *dyn, uint32_t stab)
 static void
 dump_rel(struct readelf *re, struct section *s, Elf_Data *d)
 {
-	GElf_Rel r;
+	GElf_Rel r, rels[BATCH_SIZE];
 	const char *symname;
 	uint64_t symval;
-	int i, len;
+	int bulk, i, j, len, n;
 
 #define	REL_HDR "r_offset", "r_info", "r_type", "st_value", "st_name"
 #define	REL_CT32 (uintmax_t)r.r_offset, (uintmax_t)r.r_info,	    \
@@ -2860,8 +2872,20 @@ dump_rel(struct readelf *re, struct section *s, Elf_Data *d)
 			printf("%-12s %-12s %-19s %-16s %s\n", REL_HDR);
 	}
 	len = d->d_size / s->entsize;
-	for (i = 0; i < len; i++) {
-		if (gelf_getrel(d, i, &r) != &r) {
+	bulk = 1;
+	for (i = j = n = 0; i < len; i++, j++) {
+		if (bulk && j == n) {
+			/*
+			 * Retrieve the remaining entries one at a time if
+			 * they cannot be retrieved in bulk.
+			 */
+			if ((n = gelf_getrels(d, i, BATCH_SIZE, rels)) <= 0)
+				bulk = 0;
+			j = 0;
+		}
+		if (bulk)
+			r = rels[j];
+		else if (gelf_getrel(d, i, &r) != &r) {
 			warnx("gelf_getrel failed: %s", elf_errmsg(-1));
 			continue;
 		}
@@ -2888,10 +2912,10 @@ dump_rel(struct readelf *re, struct section *s, Elf_Data *d)
 static void
 dump_rela(struct readelf *re, struct section *s, Elf_Data *d)
 {
-	GElf_Rela r;
+	GElf_Rela r, relas[BATCH_SIZE];
 	const char *symname;
 	uint64_t symval;
-	int i, len;
+	int bulk, i, j, len, n;
 
 #define	RELA_HDR "r_offset", "r_info", "r_type", "st_value", \
 		"st_name + r_addend"
@@ -2912,9 +2936,21 @@ dump_rela(struct readelf *re, struct section *s, Elf_Data *d)
 			printf("%-12s %-12s %-19s %-16s %s\n", RELA_HDR);
 	}
 	len = d->d_size / s->entsize;
-	for (i = 0; i < len; i++) {
-		if (gelf_getrela(d, i, &r) != &r) {
-			warnx("gelf_getrel failed: %s", elf_errmsg(-1));
+	bulk = 1;
+	for (i = j = n = 0; i < len; i++, j++) {
+		if (bulk && j == n) {
+			/*
+			 * Retrieve the remaining entries one at a time if
+			 * they cannot be retrieved in bulk.
+			 */
+			if ((n = gelf_getrelas(d, i, BATCH_SIZE, relas)) <= 0)
+				bulk = 0;
+			j = 0;
+		}
+		if (bulk)
+			r = relas[j];
+		else if (gelf_getrela(d, i, &r) != &r) {
+			warnx("gelf_getrela failed: %s", elf_errmsg(-1));
 			continue;
 		}
 		symname = get_symbol_name(re, s->link, GELF_R_SYM(r.r_info));
@@ -2939,6 +2975,60 @@ dump_rela(struct readelf *re, struct section *s, Elf_Data *d)
 #undef	RELA_CT
 }
 
+/*
+ * Print the entries of a SHT_RELR section along with the places they
+ * encode. An entry with the least significant bit clear is the address
+ * of a place, an entry with it set is a bitmap of the places that
+ * follow the last address.
+ */
+static void
+dump_relr(struct readelf *re, struct section *s, Elf_Data *d)
+{
+	uint64_t base, entry, off;
+	int bits, first, i, j, len, w, wd;
+
+	w = re->ec == ELFCLASS32 ? 4 : 8;
+	bits = w * 8 - 1;
+	if (re->ec == ELFCLASS32)
+		wd = 8;
+	else if (re->options & RE_WW)
+		wd = 16;
+	else
+		wd = 12;
+
+	printf("\nRelative relocation section (%s):\n", s->name);
+	printf("%-*s %s\n", wd, "r_relr", "r_offset");
+	base = 0;
+	len = d->d_size / w;
+	for (i = 0; i < len; i++) {
+		if (re->ec == ELFCLASS32)
+			entry = ((uint32_t *) d->d_buf)[i];
+		else
+			entry = ((uint64_t *) d->d_buf)[i];
+		if ((entry & 1) == 0) {
+			printf("%*.*jx %*.*jx\n", wd, wd, (uintmax_t) entry,
+			    wd, wd, (uintmax_t) entry);
+			base = entry + w;
+			continue;
+		}
+		first = 1;
+		for (j = 0; j < bits; j++) {
+			if (((entry >> (j + 1)) & 1) == 0)
+				continue;
+			off = base + (uint64_t) j * w;
+			if (first)
+				printf("%*.*jx", wd, wd, (uintmax_t) entry);
+			else
+				printf("%*s", wd, "");
+			printf(" %*.*jx\n", wd, wd, (uintmax_t) off);
+			first = 0;
+		}
+		if (first)
+			printf("%*.*jx\n", wd, wd, (uintmax_t) entry);
+		base += (uint64_t) bits * w;
+	}
+}
+
 static void
 dump_reloc(struct readelf *re)
 {
@@ -2948,7 +3038,8 @@ dump_reloc(struct readelf *re)
 
 	for (i = 0; (size_t)i < re->shnum; i++) {
 		s = &re->sl[i];
-		if (s->type == SHT_REL || s->type == SHT_RELA) {
+		if (s->type == SHT_REL || s->type == SHT_RELA ||
+		    s->type == SHT_RELR) {
 			(void) elf_errno();
 			if ((d = elf_getdata(s->scn, NULL)) == NULL) {
 				elferr = elf_errno();
@@ -2959,8 +3050,10 @@ dump_reloc(struct readelf *re)
 			}
 			if (s->type == SHT_REL)
 				dump_rel(re, s, d);
-			else
+			else if (s->type == SHT_RELA)
 				dump_rela(re, s, d);
+			else
+				dump_relr(re, s, d);
 		}
 	}
 }
@@ -2970,9 +3063,9 @@ dump_symtab(struct readelf *re, int i)
 {
 	struct section *s;
 	Elf_Data *d;
-	GElf_Sym sym;
+	GElf_Sym sym, syms[BATCH_SIZE];
 	const char *name;
-	int elferr, stab, j;
+	int bulk, elferr, stab, j, k, n;
 
 	s = &re->sl[i];
 	stab = s->link;
@@ -2990,8 +3083,20 @@ dump_symtab(struct readelf *re, int i)
 	printf("%7s%9s%14s%5s%8s%6s%9s%5s\n", "Num:", "Value", "Size", "Type",
 	    "Bind", "Vis", "Ndx", "Name");
 
-	for (j = 0; (uint64_t)j < s->sz / s->entsize; j++) {
-		if (gelf_getsym(d, j, &sym) != &sym) {
+	bulk = 1;
+	for (j = k = n = 0; (uint64_t)j < s->sz / s->entsize; j++, k++) {
+		if (bulk && k == n) {
+			/*
+			 * Retrieve the remaining entries one at a time if
+			 * they cannot be retrieved in bulk.
+			 */
+			if ((n = gelf_getsyms(d, j, BATCH_SIZE, syms)) <= 0)
+				bulk = 0;
+			k = 0;
+		}
+		if (bulk)
+			sym = syms[k];
+		else if (gelf_getsym(d, j, &sym) != &sym) {
 			warnx("gelf_getsym failed: %s", elf_errmsg(-1));
 			continue;
 		}
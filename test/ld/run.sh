@@ -0,0 +1,231 @@
+#!/bin/sh
+#
+# $Id$
+#
+# Check that the output of ld(1) does not depend on the number of
+# threads used to load symbols, to apply relocations, to merge strings
+# and to compute the build ID (--threads).
+#
+# A set of objects and an archive that refer to each other's code and
+# data, and share some of their strings, are generated using cc(1).
+# They are linked with --threads=1, and the output of each
+# multithreaded link is compared with it.
+#
+# Identical code folding (--icf), version scripts and the relaxation
+# of GOT loads on amd64 are also checked on small inputs.
+
+test_log=test.log
+
+LD=${LD:-`/bin/pwd`/../../ld/ld}
+READELF=${READELF:-`/bin/pwd`/../../readelf/readelf}
+CC=${CC:-cc}
+NOBJ=32
+TESTDIR=/tmp/ld-threads
+
+# setup cleanup trap
+trap 'rm -rf ${TESTDIR}; exit' 0 2 3 15
+
+rm -rf ${TESTDIR}
+mkdir -p ${TESTDIR} || exit 1
+
+exec >${test_log} 2>&1
+echo @TEST-RUN: `date`
+
+# Generate and compile the input objects.
+i=0
+while [ $i -lt ${NOBJ} ]; do
+    n=`expr \( $i + 1 \) % ${NOBJ}`
+    cat > ${TESTDIR}/t$i.c <<END
+extern int f$n(int);
+static int tab$i[64] = { $i, $n };
+static int *ptr$i[3] = { &tab$i[1], &tab$i[2], &tab$i[$i] };
+int f$i(int x) { return x > 0 ? f$n(x - 1) + *ptr$i[x % 3] : tab$i[0]; }
+const char *s$i(int x) { return x ? "string $i" : "a string $n"; }
+END
+    (cd ${TESTDIR} && ${CC} -O1 -fPIC -c t$i.c) || exit 1
+    i=`expr $i + 1`
+done
+(cd ${TESTDIR} && ar rc libt.a t1[0-9].o) || exit 1
+objs=`cd ${TESTDIR} && ls t*.o | grep -v '^t1[0-9]\.o$'`
+
+total=0
+passed=0
+for mode in "-r" "-shared" "-shared --build-id=fast" \
+    "-shared --build-id=sha1" "-shared --icf=all" \
+    "-shared -z pack-relative-relocs"; do
+    (cd ${TESTDIR} && ${LD} --threads=1 ${mode} -o ref ${objs} libt.a) ||
+	exit 1
+    for t in 2 4 ${NOBJ} 64; do
+	total=`expr ${total} + 1`
+	(cd ${TESTDIR} && ${LD} --threads=$t ${mode} -o out ${objs} libt.a &&
+	    cmp ref out)
+	if [ $? -eq 0 ]; then
+	    echo "ld ${mode} --threads=$t - ok"
+	    passed=`expr ${passed} + 1`
+	else
+	    echo "ld ${mode} --threads=$t - not ok"
+	fi
+    done
+done
+
+# Link an object with a single candidate section for folding.
+echo 'int one(int x) { return x + 1; }' > ${TESTDIR}/one.c
+(cd ${TESTDIR} && ${CC} -O1 -ffunction-sections -c one.c) || exit 1
+for icf in all safe; do
+    total=`expr ${total} + 1`
+    if (cd ${TESTDIR} && ${LD} --icf=${icf} -shared -o out one.o); then
+	echo "ld --icf=${icf} single candidate - ok"
+	passed=`expr ${passed} + 1`
+    else
+	echo "ld --icf=${icf} single candidate - not ok"
+    fi
+done
+
+# Two identical local functions which are only called are folded by
+# --icf=safe, and the FDE of the folded one is removed.
+cat > ${TESTDIR}/fold.c <<END
+static int __attribute__((noinline)) g0(int x) { return x * 3 + 7; }
+static int __attribute__((noinline)) g1(int x) { return x * 3 + 7; }
+int fold(int x) { return g0(x) + g1(x + 1); }
+END
+(cd ${TESTDIR} && ${CC} -O1 -ffunction-sections -c fold.c) || exit 1
+ehsize() {
+    ${READELF} -W -S $1 | awk '$2 == ".eh_frame" { print $6 }'
+}
+total=`expr ${total} + 1`
+(cd ${TESTDIR} && ${LD} -shared -o ref fold.o &&
+    ${LD} --icf=safe --print-icf-sections -shared -o out fold.o \
+    >fold.log 2>&1) || exit 1
+if [ `grep -c 'Fold section' ${TESTDIR}/fold.log` -eq 1 ] &&
+    [ `ehsize ${TESTDIR}/out` != `ehsize ${TESTDIR}/ref` ]; then
+    echo "ld --icf=safe local calls - ok"
+    passed=`expr ${passed} + 1`
+else
+    echo "ld --icf=safe local calls - not ok"
+fi
+
+# Symbols get their versions from exact, wildcard and extern "C++"
+# patterns of a version script; an exact match wins over a wildcard.
+cat > ${TESTDIR}/ver.c <<END
+int foo(void) { return 1; }
+int bar(void) { return 2; }
+int baz_1(void) { return 3; }
+int baz_2(void) { return 4; }
+int hidden(void) { return 5; }
+int nsf(int x) __asm__("_ZN2ns1fEi");
+int nsf(int x) { return x; }
+END
+cat > ${TESTDIR}/ver.map <<END
+V1 {
+	global: foo; baz_*;
+	extern "C++" { ns::f*; };
+	local: *;
+};
+V2 {
+	global: bar; baz_2;
+} V1;
+END
+echo 'int dep(void) { return 0; }' > ${TESTDIR}/dep.c
+(cd ${TESTDIR} && ${CC} -fPIC -c ver.c && ${CC} -fPIC -c dep.c &&
+    ${LD} -shared -o libdep.so dep.o &&
+    ${LD} -shared --version-script ver.map -o out ver.o libdep.so) ||
+    exit 1
+total=`expr ${total} + 1`
+syms=`${READELF} -s ${TESTDIR}/out | sed -n '/\.dynsym/,/\.symtab/p' |
+    awk '$8 ~ /@/ { print $8 }' | LC_ALL=C sort | tr '\n' ' '`
+if [ "${syms}" = "_ZN2ns1fEi@@V1 bar@@V2 baz_1@@V1 baz_2@@V2 foo@@V1 " ]; then
+    echo "ld --version-script - ok"
+    passed=`expr ${passed} + 1`
+else
+    echo "ld --version-script - not ok: ${syms}"
+fi
+
+# On amd64, GOT loads using R_X86_64_GOTPCRELX and R_X86_64_REX_GOTPCRELX
+# in a static executable are rewritten to use the symbols directly:
+# mov to lea, indirect call and jmp to direct ones, and test and binary
+# operations to their immediate forms.  No GOT is left in the output.
+case `uname -m` in
+x86_64|amd64)
+    cat > ${TESTDIR}/gotpcrelx.s <<END
+	.text
+	.globl	_start
+_start:
+	movq	val@GOTPCREL(%rip), %rax
+	movl	(%rax), %ebx
+	movq	val@GOTPCREL(%rip), %r9
+	addl	(%r9), %ebx
+	call	*addone@GOTPCREL(%rip)
+	addl	%eax, %ebx
+	movq	\$0, %r10
+	addq	val@GOTPCREL(%rip), %r10
+	addl	(%r10), %ebx
+	movq	\$0, %r11
+	orq	val@GOTPCREL(%rip), %r11
+	testq	%r11, val@GOTPCREL(%rip)
+	je	1f
+	addl	(%r11), %ebx
+1:	cmpq	val@GOTPCREL(%rip), %r10
+	jne	2f
+	addl	\$100, %ebx
+2:	movl	%ebx, %edi
+	movl	\$60, %eax
+	syscall
+	.globl	addone
+addone:
+	jmp	*addone1@GOTPCREL(%rip)
+addone1:
+	movl	\$1, %eax
+	ret
+	.data
+	.globl	val
+val:	.long	5
+END
+    (cd ${TESTDIR} && ${CC} -c gotpcrelx.s && ${LD} -o out gotpcrelx.o) ||
+	exit 1
+    total=`expr ${total} + 1`
+    ${TESTDIR}/out
+    if [ $? -eq 121 ] && ! ${READELF} -W -S ${TESTDIR}/out |
+	grep -q '\.got'; then
+	echo "ld GOTPCRELX relaxation - ok"
+	passed=`expr ${passed} + 1`
+    else
+	echo "ld GOTPCRELX relaxation - not ok"
+    fi
+
+    # A symbol above 2GB can be reached neither from %rip nor with a
+    # 32-bit immediate, so its GOT loads are kept.
+    cat > ${TESTDIR}/gotfar.s <<END
+	.text
+	.globl	_start
+_start:
+	movq	\$0x180000000, %rdx
+	movl	\$1, %edi
+	movq	far@GOTPCREL(%rip), %rax
+	cmpq	%rdx, %rax
+	jne	1f
+	movq	\$0, %rax
+	addq	far@GOTPCREL(%rip), %rax
+	cmpq	%rdx, %rax
+	jne	1f
+	movl	\$121, %edi
+1:	movl	\$60, %eax
+	syscall
+	.globl	far
+	.set	far, 0x180000000
+END
+    (cd ${TESTDIR} && ${CC} -c gotfar.s && ${LD} -o out gotfar.o) ||
+	exit 1
+    total=`expr ${total} + 1`
+    ${TESTDIR}/out
+    if [ $? -eq 121 ] && ${READELF} -W -S ${TESTDIR}/out |
+	grep -q '\.got'; then
+	echo "ld GOTPCRELX far symbol - ok"
+	passed=`expr ${passed} + 1`
+    else
+	echo "ld GOTPCRELX far symbol - not ok"
+    fi
+    ;;
+esac
+
+# show statistics.
+echo @RESULT: "${passed} out of ${total} passed."
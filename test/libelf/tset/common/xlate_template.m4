@@ -792,7 +792,111 @@ tcXlate_tpByte`'__SZ__ (void)
 	tet_result(result);
 }')
 
-define(`Xlate_TestConversions_Note')
+/*
+ * Xlate_TestConversions_Note()
+ *
+ * Test note conversions.  A section holding two notes is converted
+ * to and from each byte order.  Each note is located using the
+ * sizes in the header of the note preceding it, so a size used in
+ * the wrong byte order shows up in the conversion of the second note.
+ */
+define(`Xlate_TestConversions_Note',`
+static unsigned char td_NOTE_LSB`'__SZ__[] = {
+	0x04, 0x00, 0x00, 0x00,		/* namesz */
+	0x06, 0x00, 0x00, 0x00,		/* descsz */
+	0x01, 0x00, 0x00, 0x00,		/* type */
+	0x47, 0x4E, 0x55, 0x00,		/* "GNU" */
+	0x01, 0x02, 0x03, 0x04,		/* desc */
+	0x05, 0x06, 0x00, 0x00,
+	0x02, 0x00, 0x00, 0x00,
+	0x04, 0x00, 0x00, 0x00,
+	0x02, 0x00, 0x00, 0x00,
+	0x61, 0x00, 0x00, 0x00,		/* "a" */
+	0x11, 0x12, 0x13, 0x14
+};
+
+static unsigned char td_NOTE_MSB`'__SZ__[] = {
+	0x00, 0x00, 0x00, 0x04,
+	0x00, 0x00, 0x00, 0x06,
+	0x00, 0x00, 0x00, 0x01,
+	0x47, 0x4E, 0x55, 0x00,
+	0x01, 0x02, 0x03, 0x04,
+	0x05, 0x06, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x02,
+	0x00, 0x00, 0x00, 0x04,
+	0x00, 0x00, 0x00, 0x02,
+	0x61, 0x00, 0x00, 0x00,
+	0x11, 0x12, 0x13, 0x14
+};
+
+void
+tcXlate_tpNote`'__SZ__ (void)
+{
+	Elf_Data dst, src, *r;
+	Elf_Note *en;
+	int result;
+	unsigned int ed;
+	unsigned char *ref;
+	uint32_t membuf[sizeof(td_NOTE_LSB`'__SZ__) / sizeof(uint32_t)];
+	uint32_t filebuf[sizeof(membuf) / sizeof(uint32_t)];
+	uint32_t dstbuf[sizeof(membuf) / sizeof(uint32_t)];
+
+	TP_ANNOUNCE("TPFNNAME""(NOTE) conversion.");
+
+	/* The memory representation has headers in native byte order. */
+	(void) memcpy(membuf, td_NOTE_LSB`'__SZ__, sizeof(membuf));
+	en = (Elf_Note *) (uintptr_t) membuf;
+	en->n_namesz = 4;
+	en->n_descsz = 6;
+	en->n_type = 1;
+	en = (Elf_Note *) (uintptr_t) &membuf[6];
+	en->n_namesz = 2;
+	en->n_descsz = 4;
+	en->n_type = 2;
+
+	result = TET_PASS;
+
+	for (ed = ELFDATA2LSB; ed <= ELFDATA2MSB; ed++) {
+		ref = ed == ELFDATA2LSB ? td_NOTE_LSB`'__SZ__ :
+		    td_NOTE_MSB`'__SZ__;
+		(void) memcpy(filebuf, ref, sizeof(filebuf));
+
+		(void) memset(&dst, 0, sizeof(dst));
+		(void) memset(&src, 0, sizeof(src));
+		(void) memset(dstbuf, 0, sizeof(dstbuf));
+
+		src.d_buf = TO_M_OR_F(`filebuf',`membuf');
+		src.d_size = sizeof(membuf);
+		src.d_type = ELF_T_NOTE;
+		src.d_version = EV_CURRENT;
+
+		dst.d_buf = dstbuf;
+		dst.d_size = sizeof(dstbuf);
+		dst.d_version = EV_CURRENT;
+
+		if ((r = CallXlator(&dst, &src, ed)) != &dst) {
+			TP_FAIL("TPFNNAME""(NOTE:%d) failed: \"%s\".", ed,
+			    elf_errmsg(-1));
+			goto done;
+		}
+
+		if (dst.d_type != ELF_T_NOTE || dst.d_size != sizeof(dstbuf)) {
+			TP_FAIL("TPFNNAME""(NOTE:%d) type(%d != %d expected), "
+			    "size(%d != %d expected).", ed, dst.d_type,
+			    ELF_T_NOTE, dst.d_size, sizeof(dstbuf));
+			goto done;
+		}
+
+		if (memcmp(dstbuf, TO_M_OR_F(`membuf',`filebuf'),
+		    sizeof(dstbuf)) != 0) {
+			TP_FAIL("TPFNNAME""(NOTE:%d) compare failed.", ed);
+			goto done;
+		}
+	}
+
+ done:
+	tet_result(result);
+}')
 
 /*
  * Xlate_TestConversions
@@ -201,3 +201,89 @@ _FN(lsb,32)
 _FN(lsb,64)
 _FN(msb,32)
 _FN(msb,64)
+
+/*
+ * Verify that ELF_F_NOCOPY causes section data to be shared with
+ * the file image, and that marking the data dirty gives it a private
+ * copy.
+ */
+
+undefine(`_FN')
+define(`_FN',`
+void
+tcNoCopy$1$2(void)
+{
+	Elf *e;
+	int error, fd, result;
+	const size_t strsectionsize = sizeof stringsection;
+	size_t rawsize, shstrndx;
+	char *buf, *rawfile;
+	Elf_Scn *scn;
+	Elf_Data *ed;
+
+	e = NULL;
+	fd = -1;
+	result = TET_UNRESOLVED;
+
+	TP_ANNOUNCE("ELF_F_NOCOPY shares section data with the file image");
+
+	_TS_OPEN_FILE(e, "zerosection.$1$2", ELF_C_READ, fd, goto done;);
+
+	if (elf_flagelf(e, ELF_C_SET, ELF_F_NOCOPY) == 0) {
+		TP_UNRESOLVED("elf_flagelf failed: \"%s\"", elf_errmsg(-1));
+		goto done;
+	}
+
+	if (elf_getshdrstrndx(e, &shstrndx) != 0 ||
+	    (scn = elf_getscn(e, shstrndx)) == NULL ||
+	    (rawfile = elf_rawfile(e, &rawsize)) == NULL) {
+		TP_UNRESOLVED("Cannot find string table section");
+		goto done;
+	}
+
+	if ((ed = elf_getdata(scn, NULL)) == NULL) {
+		error = elf_errno();
+		TP_FAIL("elf_getdata failed %d \"%s\"", error,
+		    elf_errmsg(error));
+		goto done;
+	}
+
+	buf = ed->d_buf;
+	if (ed->d_size != strsectionsize || buf < rawfile ||
+	    buf + ed->d_size > rawfile + rawsize ||
+	    memcmp(stringsection, buf, strsectionsize) != 0) {
+		TP_FAIL("Section data not shared: buf %p rawfile %p",
+		    (void *) buf, (void *) rawfile);
+		goto done;
+	}
+
+	if (elf_flagdata(ed, ELF_C_SET, ELF_F_DIRTY) == 0) {
+		error = elf_errno();
+		TP_FAIL("elf_flagdata failed %d \"%s\"", error,
+		    elf_errmsg(error));
+		goto done;
+	}
+
+	buf = ed->d_buf;
+	if ((buf >= rawfile && buf < rawfile + rawsize) ||
+	    memcmp(stringsection, buf, strsectionsize) != 0) {
+		TP_FAIL("Dirty data still shared: buf %p rawfile %p",
+		    (void *) buf, (void *) rawfile);
+		goto done;
+	}
+
+	result = TET_PASS;
+
+done:
+	if (e)
+		elf_end(e);
+	if (fd != -1)
+		(void) close(fd);
+	tet_result(result);
+}
+')
+
+_FN(lsb,32)
+_FN(lsb,64)
+_FN(msb,32)
+_FN(msb,64)
@@ -321,6 +321,77 @@ FN(32,`msb')
 FN(64,`lsb')
 FN(64,`msb')
 
+/*
+ * elf_nextscn() iterates through all sections in ascending order
+ * after sections have been retrieved out of order.
+ */
+
+undefine(`FN')
+define(`FN',`
+void
+tcElfOutOfOrder$2$1(void)
+{
+	Elf *e;
+	Elf_Scn *scn;
+	int fd, result;
+	size_t nsections, n, r;
+
+	TP_CHECK_INITIALIZATION();
+
+	TP_ANNOUNCE("elf_nextscn() visits all sections after out of "
+	    "order retrievals.");
+
+	e = NULL;
+	fd = -1;
+	result = TET_UNRESOLVED;
+
+	_TS_OPEN_FILE(e, "newscn.$2$1", ELF_C_READ, fd, goto done;);
+
+	if (elf_getshnum(e, &nsections) == 0 || nsections < 3) {
+		TP_UNRESOLVED("elf_getshnum() failed.");
+		goto done;
+	}
+
+	/* Retrieve every other section, highest index first. */
+	for (n = nsections - 1; n > 0; n -= n > 1 ? 2 : 1)
+		if (elf_getscn(e, n) == NULL) {
+			TP_UNRESOLVED("elf_getscn(%d) failed.", n);
+			goto done;
+		}
+
+	result = TET_PASS;
+
+	n = 1;
+	scn = NULL;
+	while ((scn = elf_nextscn(e, scn)) != NULL) {
+		if ((r = elf_ndxscn(scn)) != n) {
+			TP_FAIL("scn=%p ndx %d != %d.", (void *) scn, r, n);
+			goto done;
+		}
+		if (elf_getscn(e, n) != scn) {
+			TP_FAIL("elf_getscn(%d) != scn.", n);
+			goto done;
+		}
+		n++;
+	}
+
+	if (n != nsections)
+		TP_FAIL("%d sections visited, expected %d.", n - 1,
+		    nsections - 1);
+
+ done:
+	if (e)
+		(void) elf_end(e);
+	if (fd != -1)
+		(void) close(fd);
+
+	tet_result(result);
+}')
+
+FN(32,`lsb')
+FN(32,`msb')
+FN(64,`lsb')
+FN(64,`msb')
 
 /*
  * elf_nextscn() returns an error on mismatched Elf,Scn.
@@ -353,6 +353,73 @@ FN(32,`msb',`newscn')
 FN(64,`lsb',`newscn')
 FN(64,`msb',`newscn')
 
+/*
+ * Changes to the size of a string table are honoured once its
+ * section header has been marked dirty.
+ */
+
+undefine(`FN')
+define(`FN',`
+void
+tcDirtyShdr$1`'TOUPPER($2)(void)
+{
+	int error, fd, result;
+	Elf *e;
+	Elf_Scn *scn;
+	Elf$1_Ehdr *eh;
+	Elf$1_Shdr *sh;
+	size_t offset;
+	char *r;
+
+	TP_CHECK_INITIALIZATION();
+
+	TP_ANNOUNCE("TOUPPER($2)$1: a reduced section size is honoured.");
+
+	result = TET_UNRESOLVED;
+
+	_TS_OPEN_FILE(e, "$3.$2$1", ELF_C_READ, fd, goto done;);
+
+	if ((eh = elf$1_getehdr(e)) == NULL) {
+		TP_UNRESOLVED("elf$1_getehdr() failed: \"%s\".",
+		    elf_errmsg(-1));
+		goto done;
+	}
+
+	if ((scn = elf_getscn(e, eh->e_shstrndx)) == NULL ||
+	    (sh = elf$1_getshdr(scn)) == NULL) {
+		TP_UNRESOLVED("elf$1_getshdr() failed: \"%s\".",
+		    elf_errmsg(-1));
+		goto done;
+	}
+
+	/* Look up the last byte of the section, twice. */
+	offset = sh->sh_size - 1;
+	if ((r = elf_strptr(e, eh->e_shstrndx, offset)) == NULL ||
+	    elf_strptr(e, eh->e_shstrndx, offset) != r) {
+		TP_UNRESOLVED("elf_strptr() failed: \"%s\".",
+		    elf_errmsg(-1));
+		goto done;
+	}
+
+	sh->sh_size = offset;
+	(void) elf_flagshdr(scn, ELF_C_SET, ELF_F_DIRTY);
+
+	result = TET_PASS;
+	if ((r = elf_strptr(e, eh->e_shstrndx, offset)) != NULL ||
+	    (error = elf_errno()) != ELF_E_ARGUMENT)
+		TP_FAIL("r=%p error=%d \"%s\".", (void *) r, error,
+		    elf_errmsg(error));
+
+ done:
+	(void) elf_end(e);
+	tet_result(result);
+}')
+
+FN(32,`lsb',`newscn')
+FN(32,`msb',`newscn')
+FN(64,`lsb',`newscn')
+FN(64,`msb',`newscn')
+
 /*
  * TODO: With the layout bit set, an out of bounds offset is detected.
  */
@@ -600,7 +600,7 @@ const char strtab[] = {
 undefine(`FN')
 define(`FN',`
 void
-tcUpdate$1$2(void)
+tcUpdate$3$1$2(void)
 {
 	int fd, result;
 	off_t offset;
@@ -614,13 +614,28 @@ tcUpdate$1$2(void)
 
 	TP_CHECK_INITIALIZATION();
 
-	TP_ANNOUNCE("TOUPPER($2)$1: elf_update() creates a legal ELF file.");
+	TP_ANNOUNCE("TOUPPER($2)$1: elf_update() creates a legal ELF file`'ifelse($3,`',`',
+	    ` through a read-write descriptor')`'.");
 
 	result = TET_UNRESOLVED;
 	fd = -1;
 	e = NULL;
 
+ifelse($3,`',`dnl
 	_TS_OPEN_FILE(e, TS_NEWFILE, ELF_C_WRITE, fd, goto done;);
+',`dnl
+	/* Such files are assembled in a shared mapping. */
+	if ((fd = open(TS_NEWFILE, O_RDWR|O_CREAT|O_TRUNC, 0644)) < 0) {
+		TP_UNRESOLVED("open() failed: %s.", strerror(errno));
+		goto done;
+	}
+
+	if ((e = elf_begin(fd, ELF_C_WRITE, NULL)) == NULL) {
+		TP_UNRESOLVED("elf_begin() failed: \"%s\".",
+		    elf_errmsg(-1));
+		goto done;
+	}
+')dnl
 
 	if ((eh = elf$1_newehdr(e)) == NULL) {
 		TP_UNRESOLVED("elf$1_newehdr() failed: \"%s\".",
@@ -706,6 +721,10 @@ FN(32,`lsb')
 FN(32,`msb')
 FN(64,`lsb')
 FN(64,`msb')
+FN(32,`lsb',`ReadWrite')
+FN(32,`msb',`ReadWrite')
+FN(64,`lsb',`ReadWrite')
+FN(64,`msb',`ReadWrite')
 
 /*
  * An unsupported section type should be rejected.
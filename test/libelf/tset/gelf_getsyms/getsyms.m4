@@ -0,0 +1,239 @@
+/*-
+ * Copyright (c) 2026 The Elftoolchain Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <libelf.h>
+#include <gelf.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "elfts.h"
+#include "tet_api.h"
+
+include(`elfts.m4')
+
+IC_REQUIRES_VERSION_INIT();
+
+/*
+ * Tests for gelf_getdyns(), gelf_getrelas(), gelf_getrels() and
+ * gelf_getsyms().
+ *
+ * Each test case creates a section of the appropriate type in a new
+ * ELF object, and compares the entries retrieved by the array
+ * function against those retrieved one at a time.
+ */
+
+#define	NENTRIES	16
+#define	FIRST		5	/* first entry retrieved */
+
+/*
+ * Null arguments are rejected.
+ */
+void
+tcArgsNull(void)
+{
+	int n, error, result;
+	GElf_Sym sym;
+
+	TP_CHECK_INITIALIZATION();
+
+	TP_ANNOUNCE("gelf_getsyms(NULL,...) fails.");
+
+	result = TET_PASS;
+	if ((n = gelf_getsyms(NULL, 0, 1, &sym)) != -1 ||
+	    (error = elf_errno()) != ELF_E_ARGUMENT)
+		TP_FAIL("n=%d error=%d \"%s\".", n, error,
+		    elf_errmsg(error));
+
+	tet_result(result);
+}
+
+/*
+ * Create a section of type `sht' in a new ELF object, and attach a
+ * data descriptor of type `t' with NENTRIES entries to it.
+ */
+undefine(`FN')
+define(`FN',`
+static Elf_Data *
+newdata$1(Elf *e, uint32_t sht, Elf_Type t, void *buf, size_t bufsz)
+{
+	Elf_Scn *scn;
+	Elf_Data *d;
+	Elf$1_Shdr *sh;
+	unsigned char *p;
+	size_t i;
+
+	if (elf$1_newehdr(e) == NULL ||
+	    (scn = elf_newscn(e)) == NULL ||
+	    (sh = elf$1_getshdr(scn)) == NULL ||
+	    (d = elf_newdata(scn)) == NULL)
+		return (NULL);
+
+	sh->sh_type = sht;
+
+	/* Give each byte of the entries a distinct value. */
+	for (p = buf, i = 0; i < bufsz; i++)
+		p[i] = (unsigned char) (i * 7 + 1);
+
+	d->d_buf = buf;
+	d->d_size = bufsz;
+	d->d_type = t;
+
+	return (d);
+}')
+
+FN(32)
+FN(64)
+
+/*
+ * Entries retrieved in bulk match those retrieved singly.
+ */
+undefine(`FN')
+define(`FN',`
+void
+tc$2Match$1(void)
+{
+	Elf *e;
+	Elf_Data *d;
+	int fd, i, n, error, result;
+	Elf$1_$2 buf[NENTRIES];
+	GElf_$2 one, many[NENTRIES + 1];
+
+	TP_CHECK_INITIALIZATION();
+
+	TP_ANNOUNCE("gelf_get$3s() matches gelf_get$3().");
+
+	e = NULL;
+	fd = -1;
+	result = TET_UNRESOLVED;
+
+	_TS_OPEN_FILE(e, TS_NEWFILE, ELF_C_WRITE, fd, goto done;);
+
+	if ((d = newdata$1(e, $4, $5, buf, sizeof(buf))) == NULL) {
+		TP_UNRESOLVED("newdata() failed: \"%s\".", elf_errmsg(-1));
+		goto done;
+	}
+
+	result = TET_PASS;
+
+	/* Ask for more entries than are present. */
+	if ((n = gelf_get$3s(d, FIRST, NENTRIES + 1, many)) !=
+	    NENTRIES - FIRST) {
+		TP_FAIL("gelf_get$3s() returned %d, error=\"%s\".", n,
+		    elf_errmsg(-1));
+		goto done;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (gelf_get$3(d, FIRST + i, &one) == NULL) {
+			TP_UNRESOLVED("gelf_get$3(%d) failed: \"%s\".",
+			    FIRST + i, elf_errmsg(-1));
+			goto done;
+		}
+		if (memcmp(&one, &many[i], sizeof(one)) != 0) {
+			TP_FAIL("entry %d differs.", FIRST + i);
+			goto done;
+		}
+	}
+
+	/* Retrieving from the end of the data returns zero entries. */
+	if ((n = gelf_get$3s(d, NENTRIES, 1, many)) != 0)
+		TP_FAIL("gelf_get$3s(end) returned %d.", n);
+
+	/* Indices past the end are rejected. */
+	if ((n = gelf_get$3s(d, NENTRIES + 1, 1, many)) != -1 ||
+	    (error = elf_errno()) != ELF_E_ARGUMENT)
+		TP_FAIL("gelf_get$3s(end+1) n=%d error=%d \"%s\".", n,
+		    error, elf_errmsg(error));
+
+ done:
+	if (e)
+		(void) elf_end(e);
+	if (fd != -1)
+		(void) close(fd);
+	(void) unlink(TS_NEWFILE);
+
+	tet_result(result);
+}')
+
+FN(32,`Dyn',`dyn',`SHT_DYNAMIC',`ELF_T_DYN')
+FN(64,`Dyn',`dyn',`SHT_DYNAMIC',`ELF_T_DYN')
+FN(32,`Rel',`rel',`SHT_REL',`ELF_T_REL')
+FN(64,`Rel',`rel',`SHT_REL',`ELF_T_REL')
+FN(32,`Rela',`rela',`SHT_RELA',`ELF_T_RELA')
+FN(64,`Rela',`rela',`SHT_RELA',`ELF_T_RELA')
+FN(32,`Sym',`sym',`SHT_SYMTAB',`ELF_T_SYM')
+FN(64,`Sym',`sym',`SHT_SYMTAB',`ELF_T_SYM')
+
+/*
+ * Data of the wrong type is rejected.
+ */
+undefine(`FN')
+define(`FN',`
+void
+tcWrongType$1(void)
+{
+	Elf *e;
+	Elf_Data *d;
+	int fd, n, error, result;
+	Elf$1_Rel buf[NENTRIES];
+	GElf_Sym sym;
+
+	TP_CHECK_INITIALIZATION();
+
+	TP_ANNOUNCE("gelf_getsyms() rejects non-symbol data.");
+
+	e = NULL;
+	fd = -1;
+	result = TET_UNRESOLVED;
+
+	_TS_OPEN_FILE(e, TS_NEWFILE, ELF_C_WRITE, fd, goto done;);
+
+	if ((d = newdata$1(e, SHT_REL, ELF_T_REL, buf, sizeof(buf))) ==
+	    NULL) {
+		TP_UNRESOLVED("newdata() failed: \"%s\".", elf_errmsg(-1));
+		goto done;
+	}
+
+	result = TET_PASS;
+	if ((n = gelf_getsyms(d, 0, 1, &sym)) != -1 ||
+	    (error = elf_errno()) != ELF_E_ARGUMENT)
+		TP_FAIL("n=%d error=%d \"%s\".", n, error,
+		    elf_errmsg(error));
+
+ done:
+	if (e)
+		(void) elf_end(e);
+	if (fd != -1)
+		(void) close(fd);
+	(void) unlink(TS_NEWFILE);
+
+	tet_result(result);
+}')
+
+FN(32)
+FN(64)
@@ -0,0 +1,402 @@
+/*-
+ * Copyright (c) 2026 The Elftoolchain Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <libelf.h>
+#include <gelf.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "elfts.h"
+#include "tet_api.h"
+
+include(`elfts.m4')
+
+IC_REQUIRES_VERSION_INIT();
+
+/*
+ * Stress tests for the use of the library from multiple threads.
+ *
+ * Worker threads do not call into TET; they record their outcome
+ * in their `struct worker' and the results are checked by the
+ * main thread.
+ */
+
+#define	NTHREADS	8
+#define	NITERATIONS	2000
+
+struct worker {
+	pthread_t	w_thread;
+	int		w_id;
+	Elf		*w_elf;		/* shared descriptor */
+	int		w_fd;		/* its file descriptor */
+	uint32_t	w_digest;	/* summary of what was read */
+	int		w_error;	/* unexpected elf_errno() */
+	int		w_fail;		/* non-zero on failure */
+};
+
+static int	argument_error, io_error;
+static char	io_message[256];
+
+/*
+ * Force an ELF_E_ARGUMENT error.
+ */
+static void
+force_argument_error(void)
+{
+	(void) elf_getscn(NULL, (size_t) 0);
+}
+
+/*
+ * Force an ELF_E_IO error; this error number also encodes an OS
+ * error code and is described by a formatted message.
+ */
+static void
+force_io_error(void)
+{
+	(void) elf_begin(-1, ELF_C_READ, NULL);
+}
+
+static void *
+errors_worker(void *arg)
+{
+	int error, n;
+	const char *msg;
+	struct worker *w;
+
+	w = arg;
+
+	for (n = 0; n < NITERATIONS && w->w_fail == 0; n++) {
+		switch (w->w_id % 3) {
+		case 0:		/* no errors are raised */
+			if ((error = elf_errno()) != 0) {
+				w->w_error = error;
+				w->w_fail = 1;
+			}
+			break;
+		case 1:
+			force_argument_error();
+			(void) sched_yield();
+			if ((error = elf_errno()) != argument_error) {
+				w->w_error = error;
+				w->w_fail = 1;
+			}
+			break;
+		case 2:
+			force_io_error();
+			(void) sched_yield();
+			if ((msg = elf_errmsg(0)) == NULL ||
+			    strcmp(msg, io_message) != 0 ||
+			    (error = elf_errno()) != io_error) {
+				w->w_error = elf_errno();
+				w->w_fail = 1;
+			}
+			break;
+		}
+
+		/* The recorded error must have been reset. */
+		if ((error = elf_errno()) != 0) {
+			w->w_error = error;
+			w->w_fail = 1;
+		}
+	}
+
+	return (NULL);
+}
+
+/*
+ * Assertion: Errors recorded by one thread are not visible to other
+ * threads.
+ */
+
+void
+tcErrorsArePerThread(void)
+{
+	int i, result;
+	struct worker w[NTHREADS];
+
+	TP_CHECK_INITIALIZATION();
+
+	TP_ANNOUNCE("errors are recorded separately for each thread.");
+
+	result = TET_PASS;
+
+	/* Determine the error values expected by the workers. */
+	(void) elf_errno();
+	force_argument_error();
+	argument_error = elf_errno();
+	force_io_error();
+	(void) strncpy(io_message, elf_errmsg(0), sizeof(io_message) - 1);
+	io_error = elf_errno();
+
+	if (argument_error == 0 || io_error == 0 ||
+	    argument_error == io_error) {
+		TP_UNRESOLVED("unexpected errors argument=%d io=%d.",
+		    argument_error, io_error);
+		goto done;
+	}
+
+	(void) memset(w, 0, sizeof(w));
+	for (i = 0; i < NTHREADS; i++) {
+		w[i].w_id = i;
+		if (pthread_create(&w[i].w_thread, NULL, errors_worker,
+		    &w[i]) != 0) {
+			TP_UNRESOLVED("pthread_create() failed.");
+			goto join;
+		}
+	}
+
+ join:
+	while (--i >= 0) {
+		(void) pthread_join(w[i].w_thread, NULL);
+		if (w[i].w_fail && result == TET_PASS)
+			TP_FAIL("thread %d: unexpected error %d.", i,
+			    w[i].w_error);
+	}
+
+ done:
+	tet_result(result);
+}
+
+/*
+ * Walk all the sections of an ELF object, summarizing the
+ * section names and contents seen.
+ */
+static int
+walk_sections(Elf *e, uint32_t *digest)
+{
+	Elf_Scn *scn;
+	Elf_Data *d;
+	GElf_Shdr shdr;
+	size_t i, shstrndx;
+	const char *name;
+	unsigned char *p;
+	uint32_t h;
+
+	if (elf_getshdrstrndx(e, &shstrndx) != 0)
+		return (0);
+
+	h = 0;
+	scn = NULL;
+	while ((scn = elf_nextscn(e, scn)) != NULL) {
+		if (gelf_getshdr(scn, &shdr) == NULL)
+			return (0);
+		if ((name = elf_strptr(e, shstrndx, shdr.sh_name)) == NULL)
+			return (0);
+		for (; *name; name++)
+			h = h * 33 + (unsigned char) *name;
+		d = NULL;
+		while ((d = elf_getdata(scn, d)) != NULL)
+			for (p = d->d_buf, i = 0; i < d->d_size; i++)
+				h = h * 33 + p[i];
+		if (elf_errno() != 0)
+			return (0);
+	}
+
+	*digest = h;
+	return (1);
+}
+
+static void *
+reader_worker(void *arg)
+{
+	struct worker *w;
+
+	w = arg;
+	if (!walk_sections(w->w_elf, &w->w_digest)) {
+		w->w_error = elf_errno();
+		w->w_fail = 1;
+	}
+
+	return (NULL);
+}
+
+/*
+ * Assertion: Multiple threads reading a single descriptor see
+ * consistent contents.
+ */
+
+undefine(`FN')
+define(`FN',`
+void
+tcConcurrentReads$1`'TOUPPER($2)(void)
+{
+	Elf *e;
+	int fd, i, n, result;
+	uint32_t digest;
+	struct worker w[NTHREADS];
+
+	TP_CHECK_INITIALIZATION();
+
+	TP_ANNOUNCE("TOUPPER($2)$1: concurrent reads of a descriptor "
+	    "are consistent.");
+
+	result = TET_UNRESOLVED;
+	e = NULL;
+	fd = -1;
+
+	/* Compute the expected summary using a single thread. */
+	_TS_OPEN_FILE(e, "newscn.$2$1", ELF_C_READ, fd, goto done;);
+	if (!walk_sections(e, &digest)) {
+		TP_UNRESOLVED("walk_sections() failed: \"%s\".",
+		    elf_errmsg(-1));
+		goto done;
+	}
+	(void) elf_end(e);
+	e = NULL;
+
+	result = TET_PASS;
+
+	for (n = 0; n < NITERATIONS / NTHREADS && result == TET_PASS; n++) {
+		if ((e = elf_begin(fd, ELF_C_READ, NULL)) == NULL) {
+			TP_UNRESOLVED("elf_begin() failed: \"%s\".",
+			    elf_errmsg(-1));
+			goto done;
+		}
+
+		(void) memset(w, 0, sizeof(w));
+		for (i = 0; i < NTHREADS; i++) {
+			w[i].w_id = i;
+			w[i].w_elf = e;
+			if (pthread_create(&w[i].w_thread, NULL,
+			    reader_worker, &w[i]) != 0) {
+				TP_UNRESOLVED("pthread_create() failed.");
+				break;
+			}
+		}
+
+		while (--i >= 0) {
+			(void) pthread_join(w[i].w_thread, NULL);
+			if (result != TET_PASS)
+				continue;
+			if (w[i].w_fail)
+				TP_FAIL("thread %d: error %d.", i,
+				    w[i].w_error);
+			else if (w[i].w_digest != digest)
+				TP_FAIL("thread %d: digest 0x%x != 0x%x.", i,
+				    w[i].w_digest, digest);
+		}
+
+		(void) elf_end(e);
+		e = NULL;
+	}
+
+ done:
+	if (e)
+		(void) elf_end(e);
+	if (fd != -1)
+		(void) close(fd);
+	tet_result(result);
+}')
+
+FN(32,`lsb')
+FN(32,`msb')
+FN(64,`lsb')
+FN(64,`msb')
+
+/*
+ * Assertion: A descriptor may be opened and closed concurrently
+ * from multiple threads.
+ */
+
+static void *
+activation_worker(void *arg)
+{
+	int n;
+	Elf *e;
+	struct worker *w;
+
+	w = arg;
+	for (n = 0; n < NITERATIONS && w->w_fail == 0; n++) {
+		if ((e = elf_begin(w->w_fd, ELF_C_READ, w->w_elf)) !=
+		    w->w_elf) {
+			w->w_error = elf_errno();
+			w->w_fail = 1;
+			break;
+		}
+		if (elf_end(e) == 0) {
+			w->w_fail = 1;
+			break;
+		}
+	}
+
+	return (NULL);
+}
+
+void
+tcConcurrentActivations(void)
+{
+	Elf *e;
+	int fd, i, result;
+	struct worker w[NTHREADS];
+
+	TP_CHECK_INITIALIZATION();
+
+	TP_ANNOUNCE("concurrent elf_begin()/elf_end() calls on a "
+	    "descriptor are consistent.");
+
+	result = TET_UNRESOLVED;
+	e = NULL;
+	fd = -1;
+
+	_TS_OPEN_FILE(e, "newscn.lsb32", ELF_C_READ, fd, goto done;);
+
+	result = TET_PASS;
+
+	(void) memset(w, 0, sizeof(w));
+	for (i = 0; i < NTHREADS; i++) {
+		w[i].w_id = i;
+		w[i].w_elf = e;
+		w[i].w_fd = fd;
+		if (pthread_create(&w[i].w_thread, NULL, activation_worker,
+		    &w[i]) != 0) {
+			TP_UNRESOLVED("pthread_create() failed.");
+			break;
+		}
+	}
+
+	while (--i >= 0) {
+		(void) pthread_join(w[i].w_thread, NULL);
+		if (w[i].w_fail && result == TET_PASS)
+			TP_FAIL("thread %d: error %d.", i, w[i].w_error);
+	}
+
+	/* Only the initial activation must remain. */
+	if (result == TET_PASS && elf_end(e) != 0)
+		TP_FAIL("elf_end() did not release the descriptor.");
+	e = NULL;
+
+ done:
+	if (e)
+		(void) elf_end(e);
+	if (fd != -1)
+		(void) close(fd);
+	tet_result(result);
+}